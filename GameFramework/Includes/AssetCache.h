@@ -0,0 +1,98 @@
+// AssetCache.h
+// Shared, reference counted image assets.
+//
+// The pixel store is platform neutral on purpose: it only decodes files into
+// 32 bit pixel buffers and hands out shared handles, so it can be exercised
+// without a window.
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CPixelImage (Class)
+// Desc : Decoded, immutable image. Pixels are stored top-down, one 32 bit
+//		0xAARRGGBB value per pixel (same memory layout as an RGBQUAD).
+//-----------------------------------------------------------------------------
+class CPixelImage
+{
+public:
+	CPixelImage(int width, int height);
+
+	int Width() const { return m_Width; }
+	int Height() const { return m_Height; }
+
+	unsigned int* Pixels() { return m_Pixels.data(); }
+	const unsigned int* Pixels() const { return m_Pixels.data(); }
+	const unsigned int* Row(int y) const { return m_Pixels.data() + y * m_Width; }
+
+	size_t SizeInBytes() const { return m_Pixels.size() * sizeof(unsigned int); }
+
+private:
+	CPixelImage(const CPixelImage& rhs);
+	CPixelImage& operator=(const CPixelImage& rhs);
+
+	int m_Width;
+	int m_Height;
+	std::vector<unsigned int> m_Pixels;
+};
+
+typedef std::shared_ptr<const CPixelImage> PixelImagePtr;
+
+// Decodes an uncompressed 8, 24 or 32 bit Windows bitmap.
+// Returns NULL if the file is missing or in an unsupported format.
+PixelImagePtr DecodeBitmapFile(const char* szFileName);
+PixelImagePtr DecodeBitmapMemory(const unsigned char* pData, size_t size);
+
+//-----------------------------------------------------------------------------
+// Name : CAssetCache (Class)
+// Desc : Decodes every image file once and hands out shared handles to it.
+//		Safe to call from several threads.
+//-----------------------------------------------------------------------------
+class CAssetCache
+{
+public:
+	struct Stats
+	{
+		unsigned long	Hits;			// Requests served from memory
+		unsigned long	Misses;			// Requests that had to decode a file
+		unsigned long	Failures;		// Files that could not be decoded
+		unsigned long	AssetCount;		// Images currently resident
+		size_t			BytesResident;	// Pixel bytes currently resident
+		size_t			BytesLoaded;	// Pixel bytes decoded since startup
+	};
+
+	CAssetCache();
+	~CAssetCache();
+
+	// Returns the decoded image for the file, decoding it on first use.
+	PixelImagePtr Acquire(const char* szFileName);
+
+	// Returns the image registered under the name, or NULL. Never decodes.
+	PixelImagePtr Find(const char* szName);
+
+	// Registers an already decoded image under the given name.
+	void Insert(const char* szName, PixelImagePtr pImage);
+
+	// Drops images nobody outside the cache holds anymore.
+	void Trim();
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+	CAssetCache(const CAssetCache& rhs);
+	CAssetCache& operator=(const CAssetCache& rhs);
+
+	typedef std::map<std::string, PixelImagePtr> AssetMap;
+
+	mutable std::mutex	m_Lock;
+	AssetMap			m_Assets;
+	Stats				m_Stats;
+};
+
+#endif // ASSETCACHE_H
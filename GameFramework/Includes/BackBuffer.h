@@ -3,19 +3,40 @@
 // August 24, 2004.
 #ifndef BACKBUFFER_H
 #define BACKBUFFER_H
-#include "main.h"
+#include "Blitter.h"
+#include "Presenter.h"
+#include "DirtyRegion.h"
+#include <vector>
 
 class BackBuffer
 {
 public:
-	BackBuffer(HWND hWnd, int width, int height);
+	// The back buffer takes ownership of the presenter.
+	BackBuffer(int width, int height, IPresenter *pPresenter);
 	~BackBuffer();
 
+	// present() only sends the parts of the frame marked dirty since the
+	// last present, reset() only erases what sprites drew last frame.
 	void present();
 	void reset();
 
-	HDC getDC() const { return mhDC; }
-	HWND getHWND() const { return mhWnd; }
+	// Pixels changed outside of sprite drawing (backgrounds, overlays).
+	void markDirty(const CRect& rc);
+	void markAllDirty();
+
+	// Pixels a sprite drew; dirty now, and erased by the next reset().
+	void markDrawn(const CRect& rc);
+
+	const CDirtyRegion& getDirtyRegion() const { return mDirty; }
+
+	// Pixels the presenter pushed for the last frame.
+	unsigned long getPixelsPushed() const { return mPixelsPushed; }
+
+	// Direct access to the 32 bit, top-down frame pixels.
+	CPixelSurface getSurface() const;
+
+	IPresenter* getPresenter() const { return mpPresenter; }
+	void setPresenter(IPresenter *pPresenter);
 
 	int width() const { return mWidth; }
 	int height() const { return mHeight; }
@@ -32,11 +53,13 @@ private:
 	BackBuffer& operator=(const BackBuffer& rhs);
 
 private:
-	HWND mhWnd;
-	HDC mhDC;
-	HBITMAP mhSurface;
-	HBITMAP mhOldObject;
+	std::vector<unsigned int> mPixels;
+	IPresenter *mpPresenter;
+	CDirtyRegion mDirty;		// Changed since the last present
+	CDirtyRegion mDrawn;		// Sprite footprints of the frame being built
+	CDirtyRegion mErase;		// Sprite footprints of the previous frame
+	unsigned long mPixelsPushed;
 	int mWidth;
 	int mHeight;
 };
-#endif // BACKBUFFER_H
\ No newline at end of file
+#endif // BACKBUFFER_H
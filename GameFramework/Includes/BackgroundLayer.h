@@ -0,0 +1,49 @@
+// BackgroundLayer.h
+// Vertically scrolling, wrapping background image.
+#ifndef BACKGROUNDLAYER_H
+#define BACKGROUNDLAYER_H
+
+#include "Blitter.h"
+#include "DirtyRegion.h"
+
+//-----------------------------------------------------------------------------
+// Name : CBackgroundLayer (Class)
+// Desc : Keeps a decoded background resident and paints it straight into the
+//		frame. The image wraps vertically, so a frame is at most two row
+//		ranges of it: from the scroll offset to the bottom of the image, then
+//		from its top row on.
+//-----------------------------------------------------------------------------
+class CBackgroundLayer
+{
+public:
+	CBackgroundLayer();
+
+	void SetImage(PixelImagePtr pImage);
+	PixelImagePtr GetImage() const { return m_pImage; }
+	bool IsLoaded() const { return (bool)m_pImage; }
+	int GetImageHeight() const { return m_pImage ? m_pImage->Height() : 0; }
+
+	// Pixels per second. Positive speeds move the picture down the screen.
+	void SetSpeed(float fSpeed) { m_fSpeed = fSpeed; }
+	float GetSpeed() const { return m_fSpeed; }
+
+	// Image row shown on the top row of the frame.
+	void SetOffset(float fOffset);
+	int GetOffset() const { return (int)m_fOffset; }
+
+	void Update(float dt);
+
+	// True when the visible rows changed since the last full Paint.
+	bool HasMoved() const { return GetOffset() != m_iPaintedOffset; }
+
+	void Paint(const CPixelSurface& dst);
+	void Paint(const CPixelSurface& dst, const CRect& rc) const;
+
+private:
+	PixelImagePtr	m_pImage;
+	float			m_fSpeed;
+	float			m_fOffset;
+	int				m_iPaintedOffset;
+};
+
+#endif // BACKGROUNDLAYER_H
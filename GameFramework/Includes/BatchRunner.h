@@ -0,0 +1,80 @@
+// BatchRunner.h
+// Many independent game sessions run side by side, for balancing.
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "GameWorld.h"
+#include <stdio.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CBatchSettings (Struct)
+// Desc : What to run. Session i plays with seed Seed + i, so every session
+//		can be run again on its own, and the results do not depend on how
+//		many threads shared the work.
+//-----------------------------------------------------------------------------
+struct CBatchSettings
+{
+	unsigned long	Sessions;
+	uint64_t		Seed;
+	float			TickRate;		// Steps per second
+	double			MaxMinutes;		// Simulated time before a session is called off
+	CGameRules		Rules;
+
+	CBatchSettings() : Sessions(1000), Seed(1), TickRate(120.0f), MaxMinutes(10.0) {}
+};
+
+//-----------------------------------------------------------------------------
+// Name : CSessionResult (Struct)
+// Desc : How one session ended.
+//-----------------------------------------------------------------------------
+struct CSessionResult
+{
+	uint64_t		Seed;
+	unsigned long	Steps;			// Steps the session ran
+	int				Score, Score2;
+	int				Lives, Lives2;
+	bool			bFinished;		// A player lost; false if called off
+};
+
+//-----------------------------------------------------------------------------
+// Name : CBatchSummary (Struct)
+// Desc : The outcome statistics over a batch. Game lengths are in simulated
+//		minutes, over the sessions that finished; scores and upgrades count
+//		both players of every session.
+//-----------------------------------------------------------------------------
+struct CBatchSummary
+{
+	unsigned long	Sessions;
+	unsigned long	Finished;
+	unsigned long	Wins, Wins2, Draws;		// Of the finished sessions, by lives left
+	double			LengthMean, LengthP10, LengthP50, LengthP90;
+	double			ScoreMean;
+	int				ScoreP50, ScoreP90, ScoreMax;
+	double			FishRate;				// Share of players reaching the fish score
+	double			SharkRate;				// Share of players reaching the shark score
+};
+
+//-----------------------------------------------------------------------------
+// Name : CBatchRunner (Class)
+// Desc : Runs every session in its own world, driven by a CInputBot, spread
+//		over the job system's threads. The worlds only share the decoded
+//		images, which are read only once loaded.
+//-----------------------------------------------------------------------------
+class CBatchRunner
+{
+public:
+	// Returns false if a world could not be built (missing assets).
+	static bool Run(const CBatchSettings& settings, std::vector<CSessionResult>& results);
+
+	static CBatchSummary Summarize(const CBatchSettings& settings, const std::vector<CSessionResult>& results);
+	static void PrintSummary(FILE* pFile, const CBatchSettings& settings, const CBatchSummary& summary);
+
+	// One CSV row per session, for analysis elsewhere.
+	static bool SaveResults(const char* szFileName, const CBatchSettings& settings, const std::vector<CSessionResult>& results);
+
+private:
+	static bool RunSession(CGameWorld& world, const CBatchSettings& settings, unsigned long nSession, CSessionResult& result);
+};
+
+#endif // BATCHRUNNER_H
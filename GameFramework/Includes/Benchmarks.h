@@ -0,0 +1,63 @@
+// Benchmarks.h
+// Headless timings of the engine's hot paths, with checks that the fast
+// paths still give the results of the plain ones.
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdint.h>
+
+struct CBatchSettings;
+
+//-----------------------------------------------------------------------------
+// Name : CBenchmarks (Class)
+// Desc : Each Run prints its table to stdout and returns false if one of its
+//		checks failed, or it could not run; slow timings never fail. The
+//		ones that play the game need data/ to load it from.
+//-----------------------------------------------------------------------------
+class CBenchmarks
+{
+public:
+	// Keyed sprites drawn per millisecond by size, on every blit path the
+	// CPU has, checking all paths draw the same pixels.
+	static bool RunBlit();
+
+	// A game played by the input bots and drawn after every step into a
+	// back buffer that presents nowhere: draw time a frame, and how much
+	// of the frame changed.
+	static bool RunRender(unsigned long nFrames, uint64_t seed);
+
+	// The scrolling background painted from the resident wrapping layer,
+	// against decoding the image again and copying all of it every frame
+	// as it used to be; checks they all paint the same frames.
+	static bool RunScroll(unsigned long nFrames);
+
+	// Spatial hash pairs for many moving circles of mixed sizes on two
+	// layers, timed and compared with testing every pair.
+	static bool RunBroadphase(unsigned long nColliders);
+
+	// Moving entities stepped by CEntityList::Update against the per-object
+	// Sprite::update loop it replaced, checking both end up in one place.
+	static bool RunEntities(unsigned long nEntities);
+
+	// The game's threading in real time: the simulation stepping on a
+	// thread of its own and publishing snapshots through a triple buffer,
+	// the calling thread drawing the newest one 60 times a second. Reports
+	// the frames that found no new step, the steps never drawn, and how
+	// long both threads were busy at once.
+	static bool RunPipeline(double fSeconds, uint64_t seed);
+
+	// The job system's users on one thread, then two, and so on up to
+	// nMaxThreads: a batch of sessions, a big entity update and a big
+	// FindPairs. Prints the time and speedup of each, and checks every
+	// thread count comes to the same results.
+	static bool RunScaling(int nMaxThreads, const CBatchSettings& settings);
+
+	// Resamples a generated image with every filter on one thread, then
+	// two, and so on up to nMaxThreads, checking every thread count gives
+	// the same pixels and the fixed point weights stay within a level of a
+	// double precision resize. szSizes is "WxH:WxH", or empty for 1080p to
+	// 4K.
+	static bool RunResize(const char* szSizes, int nMaxThreads);
+};
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,61 @@
+// Blitter.h
+// Software sprite compositing on 32 bit pixel buffers.
+//
+// Transparency is baked into the source image once, at load time: pixels to
+// draw carry 0xFF in their alpha byte, pixels to skip carry 0. The kernels
+// then turn the alpha byte into a select mask in-register, so a draw is a
+// plain streaming pass with no per-draw mask construction.
+#ifndef BLITTER_H
+#define BLITTER_H
+
+#include "AssetCache.h"
+
+//-----------------------------------------------------------------------------
+// Name : CPixelSurface (Struct)
+// Desc : A view of a 32 bit, top-down pixel buffer owned by someone else.
+//-----------------------------------------------------------------------------
+struct CPixelSurface
+{
+	unsigned int*	pPixels;
+	int				Width;
+	int				Height;
+	int				Pitch;		// Distance between rows, in pixels
+
+	CPixelSurface() : pPixels(0), Width(0), Height(0), Pitch(0) {}
+	CPixelSurface(unsigned int* pixels, int width, int height, int pitch)
+		: pPixels(pixels), Width(width), Height(height), Pitch(pitch) {}
+
+	unsigned int* Row(int y) const { return pPixels + y * Pitch; }
+};
+
+enum EBlitPath
+{
+	BLIT_SCALAR,
+	BLIT_SSE2,
+	BLIT_AVX2
+};
+
+// Copy of the image where every pixel not matching the key (0x00RRGGBB)
+// is marked opaque.
+PixelImagePtr BuildColorKeyImage(const CPixelImage& image, unsigned int colorKey);
+
+// Copy of the image where pixels that are black in the mask are opaque,
+// matching the SRCAND / SRCPAINT convention of the mask bitmaps.
+PixelImagePtr BuildMaskedImage(const CPixelImage& image, const CPixelImage& mask);
+
+// Draws the (srcX, srcY, w, h) part of a keyed image with its upper-left
+// corner at (x, y), clipped against the surface edges.
+void BlitKeyed(const CPixelSurface& dst, int x, int y,
+			   const CPixelImage& src, int srcX, int srcY, int w, int h);
+
+inline void BlitKeyed(const CPixelSurface& dst, int x, int y, const CPixelImage& src)
+{
+	BlitKeyed(dst, x, y, src, 0, 0, src.Width(), src.Height());
+}
+
+// Kernel selection. The best path the CPU supports is picked on first use;
+// forcing a path is meant for comparing them.
+EBlitPath GetBlitPath();
+void SetBlitPath(EBlitPath path);
+
+#endif // BLITTER_H
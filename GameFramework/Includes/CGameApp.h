@@ -14,12 +14,17 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 #include "CTimer.h"
-#include "CPlayer.h"
+#include "GameWorld.h"
 #include "BackBuffer.h"
-#include "ImageFile.h"
-#include <CPlayer2.h>
+#include "Win32Presenter.h"
+#include "BackgroundLayer.h"
+#include "WorldSnapshot.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include "InputLog.h"
 #include <fstream>
-#include "Enemy.h"
+#include <atomic>
+#include <thread>
 //-----------------------------------------------------------------------------
 // Forward Declarations
 //-----------------------------------------------------------------------------
@@ -58,19 +63,20 @@ private:
 	void		FrameAdvance	  ( );
 	bool		CreateDisplay	 ( );
 	void		ChangeDevice	  ( );
+	IPresenter*	CreatePresenter	  ( );
 	void		SetupGameState	( );
-	void		AnimateObjects	( );
-	void		DrawObjects	   ( );
-	void        SaveGame();
-	void        LoadGame();
-	void Collision();
-	void BulletCrateCollision();
-	void PlaneCrateCollision();
-	void FishCoinCollision();
-	
-	void FishUpgrade();
-	void LifeSpawn();
-	void HeartCollision();
+	void		StartSimulation	  ( );
+	void		StopSimulation	  ( );
+	void		SimulationThread  ( );
+	int			SimulateFrame	  ( );
+	void		SimulateStep	  ( float dt );
+	void		HandleGameMessage ( UINT Message, WPARAM wParam );
+	bool		SetupInputLog	  ( );
+	void		EndReplay		  ( );
+	bool		PostInput		  ( UINT Message, WPARAM wParam );
+	void		RecordSnapshot	  ( double fTime );
+	void		SaveFrameStats	  ( );
+	void		DrawObjects	   ( const CWorldSnapshot& frame, float fAlpha );
 	void Scrolling();
 	void		ProcessInput	  ( );
 
@@ -90,7 +96,7 @@ private:
 	HICON				   m_hIcon;			// Window Icon
 	HMENU				   m_hMenu;			// Window Menu
 	
-	bool					m_bActive;		  // Is the application active ?
+	std::atomic<bool>		m_bActive;		  // Is the application active ?
 
 	ULONG				   m_nViewX;		   // X Position of render viewport
 	ULONG				   m_nViewY;		   // Y Position of render viewport
@@ -99,24 +105,42 @@ private:
 
 	POINT				   m_OldCursorPos;	 // Old cursor position for tracking
 	HINSTANCE				m_hInstance;
+	TCHAR					m_szCmdLine[MAX_PATH];	// Command line options
 
-	CImageFile				m_imgBackground;
+	float					m_fTickRate;		// Simulation steps per second
+	float					m_fAccumulator;		// Time not yet simulated, in seconds
+	float					m_fRenderLimit;		// Frame rate cap, 0 for none
 
-	BackBuffer*				m_pBBuffer;
-	CPlayer*				m_pPlayer;
-	CPlayer2*               m_pRacheta;
-	int RotateIt = 0;
-	int RotateIt2=0;
-	struct SaveData { 
-    Vec2 posPlayer1;
-	Vec2 posPlayer2;
+	// Game input messages, handed from the window to the simulation in
+	// the order they arrived.
+	struct CInputEvent
+	{
+		UINT	Message;
+		WPARAM	wParam;
 	};
-	int y = -600;
-	Enemy* Crate;
-	int Score = 0;
-	int Lives = 3;
-	int Score2 = 0;
-	int Lives2 = 3;
+
+	// The simulation runs on its own thread unless started with -sim:inline.
+	// Everything it touches below is its own; the window thread only sees
+	// the world through the published snapshots.
+	bool					m_bThreaded;
+	std::thread				m_SimThread;
+	std::atomic<bool>		m_bSimRunning;
+	double					m_fSimClock;		// Clock time of the last SimulateFrame
+	CFramePacer				m_SimPacer;			// Waits for the next step to fall due
+	ULONG					m_ulKeys;			// Held direction keys, per player byte
+	ULONG					m_ulKeysSent;		// Last keys the window queued
+	CSpscQueue<CInputEvent, 256>	m_Input;
+	ULONG					m_ulActions;		// Actions pressed since the last step, as CGameWorld::EInput
+	CInputRecorder			m_Recorder;			// Steps' input, for -record
+	CInputPlayer			m_Replay;			// Steps' input, for -replay
+	uint64_t				m_nSeed;			// The world's random seed
+	CGameWorld				m_World;
+	bool					m_bGameOver;		// WM_CLOSE already posted for it
+	CTripleBuffer<CWorldSnapshot>	m_Snapshots;
+
+	CBackgroundLayer		m_Background;	  // Painted by the window thread
+
+	BackBuffer*				m_pBBuffer;
 };
 
 #endif // _CGAMEAPP_H_
\ No newline at end of file
@@ -16,6 +16,9 @@
 #include "Main.h"
 #include "Sprite.h"
 #include <vector>
+#include "EntityList.h"
+#include "SpritePool.h"
+#include "Random.h"
 
 //-----------------------------------------------------------------------------
 // Main Class Definitions
@@ -44,17 +47,25 @@ public:
 		SPEED_STOP
 	};
 
+	enum ELevel
+	{
+		LEVEL_START,
+		LEVEL_FISH,
+		LEVEL_SHARK,
+		LEVEL_COUNT
+	};
+
 	//-------------------------------------------------------------------------
 	// Constructors & Destructors for This Class.
 	//-------------------------------------------------------------------------
-			 CPlayer(const BackBuffer *pBackBuffer);
+			 CPlayer();
 	virtual ~CPlayer();
 
 	//-------------------------------------------------------------------------
 	// Public Functions for This Class.
 	//-------------------------------------------------------------------------
 	void					Update( float dt );
-	void					Draw();
+	void					Draw(CWorldSnapshot& frame);
 	void					Move(ULONG ulDirection);
 	Vec2&					Position();
 	Vec2&					Velocity();
@@ -69,31 +80,36 @@ public:
 
 	bool CheckExplosion();
 
-	std::vector<Sprite*> getVectorCplayer();
+	CEntityList& GetBullets() { return Bullets; }
 
-	void updatebullets(std::vector<Sprite*> bulletsP1);
+	void SetLevel(int iLevel);
 
-	void lvl1();
+	int GetLevel() const { return m_iLevel; }
 
-	void lvl2();
+	void SpawnHeart(CRandom& random);
 
-	void SpawnHeart();
-
-	void DrawHeart();
+	void DrawHeart(CWorldSnapshot& frame);
 
 	void UpdateHeart(float dt);
 
-	std::vector<Sprite*> GetVectorHeart();
+	CEntityList& GetHearts() { return heart; }
+
+	// Frees the bullets and hearts killed this frame.
+	void Flush();
 
-	void UpdateVectorHeart(std::vector<Sprite*> heart);
+	// Builds the pooled sprites up front, so spawning never allocates.
+	void ReservePools(size_t nBullets, size_t nHearts);
+	const CSpritePool& GetBulletPool() const { return m_BulletPool; }
+	const CSpritePool& GetHeartPool() const { return m_HeartPool; }
 
 private:
 	//-------------------------------------------------------------------------
 	// Private Variables for This Class.
 	//-------------------------------------------------------------------------
 	Sprite*					m_pSprite;
-	std::vector<Sprite*> Bullets;
-	const BackBuffer* pBackBuffer;
+	CSpritePool				m_BulletPool;	// Pools before the lists using them
+	CSpritePool				m_HeartPool;
+	CEntityList				Bullets;
 	ESpeedStates			m_eSpeedState;
 	float					m_fTimer;
 	
@@ -101,7 +117,9 @@ private:
 	bool                    if_Bullet;
 	AnimatedSprite*			m_pExplosionSprite;
 	int						m_iExplosionFrame;
-	std::vector<Sprite*> heart;
+	int						m_iLevel;
+	int						m_iOrientation;
+	CEntityList				heart;
 };
 
 #endif // _CPLAYER_H_
\ No newline at end of file
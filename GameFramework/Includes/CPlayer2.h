@@ -17,6 +17,8 @@
 #include "Main.h"
 #include "Sprite.h"
 #include <vector>
+#include "EntityList.h"
+#include "SpritePool.h"
 
 //-----------------------------------------------------------------------------
 // Main Class Definitions
@@ -45,17 +47,25 @@ public:
 		SPEED_STOP
 	};
 
+	enum ELevel
+	{
+		LEVEL_START,
+		LEVEL_FISH,
+		LEVEL_SHARK,
+		LEVEL_COUNT
+	};
+
 	//-------------------------------------------------------------------------
 	// Constructors & Destructors for This Class.
 	//-------------------------------------------------------------------------
-	CPlayer2(const BackBuffer* pBackBuffer);
+	CPlayer2();
 	virtual ~CPlayer2();
 
 	//-------------------------------------------------------------------------
 	// Public Functions for This Class.
 	//-------------------------------------------------------------------------
 	void					Update(float dt);
-	void					Draw();
+	void					Draw(CWorldSnapshot& frame);
 	void					Move(ULONG ulDirection2);
 	Vec2& Position();
 	Vec2& Velocity();
@@ -70,13 +80,18 @@ public:
 
 	void RotateSprite(int i);
 
-	std::vector<Sprite*> getVectorCplayer2();
+	CEntityList& GetBullets() { return Bullets; }
+
+	void SetLevel(int iLevel);
 
-	void lvl21();
+	int GetLevel() const { return m_iLevel; }
 
-	void lvl22();
+	// Frees the bullets killed this frame.
+	void Flush();
 
-	void updatebullets2(std::vector<Sprite*> bulletsP1);
+	// Builds the pooled sprites up front, so firing never allocates.
+	void ReservePools(size_t nBullets);
+	const CSpritePool& GetBulletPool() const { return m_BulletPool; }
 
 	
 
@@ -85,8 +100,8 @@ private:
 	// Private Variables for This Class.
 	//-------------------------------------------------------------------------
 	Sprite* m_pSprite;
-	std::vector<Sprite*> Bullets;
-	const BackBuffer* pBackBuffer;
+	CSpritePool				m_BulletPool;	// Pool before the list using it
+	CEntityList				Bullets;
 	Sprite* Bullet;
 	ESpeedStates			m_eSpeedState;
 	float					m_fTimer;
@@ -95,6 +110,8 @@ private:
 	bool                    if_Bullet;
 	AnimatedSprite* m_pExplosionSprite;
 	int						m_iExplosionFrame;
+	int						m_iLevel;
+	int						m_iOrientation;
 };
 
 #endif // _CPLAYER_H_
\ No newline at end of file
@@ -15,6 +15,8 @@
 // CTimer Specific Includes
 //-----------------------------------------------------------------------------
 #include "Main.h"
+#include "FrameHistogram.h"
+#include "FramePacer.h"
 
 //-----------------------------------------------------------------------------
 // Definitions, Macros & Constants
@@ -45,6 +47,22 @@ public:
 	void			Tick( float fLockFPS = 0.0f );
 	unsigned long	GetFrameRate( LPTSTR lpszString = NULL, size_t size = 0 ) const;
 	float			GetTimeElapsed() const;
+	float			GetFrameDelta() const;
+
+	// Measures the next frame from now and forgets the statistics so far,
+	// e.g. once loading is done.
+	void			Restart();
+
+	// The next Tick measures from now; time spent paused is not a frame.
+	void			Resume();
+
+	// Raw frame times, including the ones the average filters out.
+	void			SetHitchBudget( float fSeconds );
+	CFrameStats		GetFrameStats() const;
+	bool			SaveFrameStats( const char* szFileName ) const;
+
+	// How closely Tick kept to the rate it was locked to.
+	CPacingStats	GetPacingStats() const;
 
 private:
 	//------------------------------------------------------------
@@ -52,13 +70,19 @@ private:
 	//------------------------------------------------------------
 	bool			m_PerfHardware;			 // Has Performance Counter
 	float			m_TimeScale;				// Amount to scale counter
-	float			m_TimeElapsed;			  // Time elapsed since previous frame
+	float			m_TimeElapsed;			  // Time elapsed since previous frame (averaged)
+	float			m_FrameDelta;			   // Time elapsed since previous frame (measured)
 	__int64			m_CurrentTime;			  // Current Performance Counter
 	__int64			m_LastTime;				 // Performance Counter last frame
 	__int64			m_PerfFreq;				 // Performance Frequency
 
-	float			m_FrameTime[MAX_SAMPLE_COUNT];
+	float			m_FrameTime[MAX_SAMPLE_COUNT];	// Ring of the latest frame times
 	ULONG			m_SampleCount;
+	ULONG			m_SampleNext;			   // Slot the next frame time goes in
+	double			m_SampleTotal;			  // Sum of the ring, kept as it changes
+
+	CFrameHistogram	m_History;				  // Every frame time since Restart
+	CFramePacer		m_Pacer;					// Holds Tick to the locked rate
 
 	unsigned long	m_FrameRate;				// Stores current framerate
 	unsigned long	m_FPSFrameCount;			// Elapsed frames in any given second
@@ -0,0 +1,45 @@
+// CpuFeatures.h
+// Instruction set detection shared by the SIMD kernels.
+//
+// CPU_X86 is defined where the SSE2 kernels can be compiled, which is every
+// x86 and x64 target. AVX2 kernels are compiled there too, marked with
+// CPU_AVX2_FUNC, and only called once CpuHasAVX2() said yes.
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CPU_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CPU_AVX2_FUNC
+#else
+#include <cpuid.h>
+#define CPU_AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+inline bool CpuHasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7)
+		return false;
+
+	// AVX2 needs OS support for the YMM state as well.
+	__cpuid(info, 1);
+	bool bOSXSave = (info[2] & (1 << 27)) != 0;
+	bool bAVX = (info[2] & (1 << 28)) != 0;
+	if(!bOSXSave || !bAVX || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,71 @@
+// DirtyRegion.h
+// Tracks which parts of the back buffer changed during a frame.
+#ifndef DIRTYREGION_H
+#define DIRTYREGION_H
+
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CRect (Struct)
+// Desc : Integer rectangle, right and bottom edges are exclusive.
+//-----------------------------------------------------------------------------
+struct CRect
+{
+	int Left, Top, Right, Bottom;
+
+	CRect() : Left(0), Top(0), Right(0), Bottom(0) {}
+	CRect(int left, int top, int right, int bottom) : Left(left), Top(top), Right(right), Bottom(bottom) {}
+
+	int Width() const { return Right - Left; }
+	int Height() const { return Bottom - Top; }
+	long Area() const { return IsEmpty() ? 0 : (long)Width() * Height(); }
+	bool IsEmpty() const { return Right <= Left || Bottom <= Top; }
+
+	CRect Union(const CRect& r) const;
+	CRect Intersect(const CRect& r) const;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CDirtyRegion (Class)
+// Desc : A small set of rectangles covering everything that changed.
+//		Rectangles that are close together are merged as they come in, and
+//		once they cover too much of the frame the region simply becomes the
+//		whole frame, since one big copy beats many medium ones.
+//-----------------------------------------------------------------------------
+class CDirtyRegion
+{
+public:
+	CDirtyRegion();
+
+	void SetBounds(int width, int height);
+
+	// Fraction of the frame above which the whole frame is considered dirty.
+	void SetFullThreshold(float fThreshold) { m_fFullThreshold = fThreshold; }
+
+	void Add(const CRect& rc);
+	void AddFull();
+	void Clear();
+
+	bool IsFull() const { return m_bFull; }
+	bool IsEmpty() const { return !m_bFull && m_Rects.empty(); }
+
+	// The rectangles to copy; a single frame-sized one when full.
+	const std::vector<CRect>& Rects() const { return m_Rects; }
+
+	// Number of pixels the rectangles cover.
+	long Area() const { return m_Area; }
+
+private:
+	enum { MAX_RECTS = 16 };
+
+	void MergeClosestPair();
+	void UpdateArea();
+
+	std::vector<CRect>	m_Rects;
+	CRect				m_Bounds;
+	long				m_Area;
+	float				m_fFullThreshold;
+	bool				m_bFull;
+};
+
+#endif // DIRTYREGION_H
@@ -7,16 +7,17 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 #include "Sprite.h"
+#include "EntityList.h"
+#include "SpritePool.h"
+#include "Random.h"
 #include <list>
 #include <vector>
-#include <windows.h>
 #include <cstdlib>
 #include <iostream>
 #include <chrono>
 #include <thread>
 #include <functional>
 #include <fstream>
-#include <io.h>
 #include <time.h>
 
 
@@ -33,45 +34,55 @@ public:
 	//-------------------------------------------------------------------------
 	// Enumerators
 	//-------------------------------------------------------------------------
+	enum
+	{
+		PLAYFIELD_HEIGHT = 600		// Crates fall this far, whatever the screen
+	};
 
 	//-------------------------------------------------------------------------
 	// Constructors & Destructors for This Class.
 	//-------------------------------------------------------------------------
-	Enemy(const BackBuffer* pBackBuffer);
+	Enemy();
 	virtual ~Enemy();
 
 	//-------------------------------------------------------------------------
 	// Public Functions for This Class.
 	//-------------------------------------------------------------------------
 	void					Update(float dt);
-	void					Draw();
-	void					SpawnCrate();
+	void					Draw(CWorldSnapshot& frame);
+	void					SpawnCrate(CRandom& random);
 	Vec2& Position();
 	Vec2& Velocity();
-	std::vector<Sprite*>    getVectorCrate();
+	CEntityList&			GetCrates() { return crates; }
 	void GetCratePos();
 	double					getShipWidth();
 	bool					ifExplosion();
-	void updatecrate(std::vector <Sprite*> crates);
 
-	void spawncoins();
+	void spawncoins(CRandom& random);
 
 	void updatecoins(float dt);
 
-	void drawcoins();
+	void drawcoins(CWorldSnapshot& frame);
 
-	std::vector<Sprite*> getVectorCoin();
+	CEntityList&			GetCoins() { return coins; }
 
-	void updatevectorcoin(std::vector<Sprite*> crates);
+	// Frees the crates and coins killed this frame.
+	void Flush();
+
+	// Builds the pooled sprites up front, so spawning never allocates.
+	void ReservePools(size_t nCrates, size_t nCoins);
+	const CSpritePool& GetCratePool() const { return cratePool; }
+	const CSpritePool& GetCoinPool() const { return coinPool; }
 
 
 private:
 	//-------------------------------------------------------------------------
 	// Private Variables for This Class.
 	//-------------------------------------------------------------------------
-	std::vector<Sprite*>	crates;
-	const BackBuffer* pBackBuffer;
-	std::vector<Sprite*>	coins;
+	CSpritePool				cratePool;	// Pools before the lists using them
+	CSpritePool				coinPool;
+	CEntityList				crates;
+	CEntityList				coins;
 
 };
 
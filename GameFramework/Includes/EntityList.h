@@ -0,0 +1,105 @@
+// EntityList.h
+// Moving sprites stored as structure of arrays, with removal deferred to
+// the end of the frame.
+#ifndef ENTITYLIST_H
+#define ENTITYLIST_H
+
+#include <stddef.h>
+#include <vector>
+
+class Sprite;
+class CSpritePool;
+class CWorldSnapshot;
+
+//-----------------------------------------------------------------------------
+// Name : CEntityList (Class)
+// Desc : Owns a set of moving sprites. Position, velocity and lifetime live
+//		in parallel float arrays so Update() can move, age and cull the whole
+//		set in one vectorized pass; the sprite is only positioned when drawn.
+//
+//		Kill() only queues an entity for removal, so indices stay valid for
+//		the rest of the frame (update, collision pairs, ...). Flush() then
+//		removes the whole queue by swapping each dead entry with the last one
+//		and popping it, and frees the sprites, back to their pool when the
+//		list has one. The order of the list is not preserved.
+//-----------------------------------------------------------------------------
+class CEntityList
+{
+public:
+	enum EFlags
+	{
+		FLAG_DYING = 0x01
+	};
+
+	CEntityList();
+	~CEntityList();
+
+	// Sprites are returned to the pool instead of deleted. The pool has
+	// to outlive the list.
+	void SetPool(CSpritePool* pPool) { m_pPool = pPool; }
+
+	void Reserve(size_t count);
+
+	// Entities without a lifetime live until killed or culled.
+	void Add(Sprite* pSprite, float x, float y, float vx = 0.0f, float vy = 0.0f, float fLifetime = -1.0f);
+
+	// Moves every entity by its velocity, and kills the ones whose lifetime
+	// ran out or that left the [fMinY, fMaxY] band. The positions before the
+	// move are kept for Draw(). Big lists are split across the job system.
+	void Update(float dt, float fMinY, float fMaxY);
+
+	// Positions each sprite and adds it to the frame, moving from its
+	// previous position to its current one.
+	void Draw(CWorldSnapshot& frame);
+
+	// Queues the entity at the index for removal; repeated kills are ignored.
+	void Kill(size_t index);
+	bool IsDying(size_t index) const { return (m_Flags[index] & FLAG_DYING) != 0; }
+
+	// Removes and frees everything killed since the last flush.
+	void Flush();
+
+	size_t Size() const { return m_Sprites.size(); }
+	bool Empty() const { return m_Sprites.empty(); }
+	Sprite* operator[](size_t index) const { return m_Sprites[index]; }
+
+	float X(size_t index) const { return m_X[index]; }
+	float Y(size_t index) const { return m_Y[index]; }
+
+	// Entities alive after the last flush, and freed by it.
+	size_t GetLiveCount() const { return m_Sprites.size(); }
+	size_t GetFreedCount() const { return m_FreedLastFlush; }
+	unsigned long GetFreedTotal() const { return m_FreedTotal; }
+
+private:
+	CEntityList(const CEntityList& rhs);
+	CEntityList& operator=(const CEntityList& rhs);
+
+	void Free(Sprite* pSprite);
+
+	// Update() for [first, last), collecting the indices to kill.
+	void UpdateRange(size_t first, size_t last, float dt, float fMinY, float fMaxY, std::vector<size_t>& kills);
+
+	enum
+	{
+		UPDATE_CHUNKS		= 16,		// Most pieces one Update() is split into
+		PARALLEL_UPDATE_MIN	= 16384		// Smaller lists are not worth splitting
+	};
+
+	std::vector<float>			m_X;
+	std::vector<float>			m_Y;
+	std::vector<float>			m_PrevX;	// Positions before the last Update()
+	std::vector<float>			m_PrevY;
+	std::vector<float>			m_VX;
+	std::vector<float>			m_VY;
+	std::vector<float>			m_Life;		// Seconds left, +inf if unlimited
+	std::vector<unsigned char>	m_Flags;
+	std::vector<Sprite*>		m_Sprites;
+	std::vector<size_t>			m_KillQueue;
+	std::vector<size_t>			m_ChunkKills[UPDATE_CHUNKS];	// Update() scratch
+	CSpritePool*				m_pPool;
+	size_t						m_FreedLastFlush;
+	unsigned long				m_FreedTotal;
+};
+
+#endif // ENTITYLIST_H
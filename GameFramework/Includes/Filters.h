@@ -19,40 +19,55 @@ public:
 	double GetWidth()					{ return m_dWidth; }
 	void   SetWidth (double dWidth)		{ m_dWidth = dWidth; }
 
+	// Shape parameters beyond the width, to tell two filters of one type
+	// apart (the weights cache keys on them)
+	virtual void GetShape (double &dP, double &dQ) { dP = dQ = 0; }
+
 	virtual double Filter (double dVal) = 0;
+
+	// Samples one window of source pixels: pOut[i] is the filter at
+	// dScale * (dCenter - (iFirst + i)). The weights table calls this once
+	// per destination pixel; the kernel filters below do it without a
+	// virtual call per tap.
+	virtual void Sample (double dCenter, double dScale, int iFirst, int nTaps, double *pOut) {
+		for(int i = 0; i < nTaps; i++)
+			pOut[i] = Filter(dScale * (dCenter - (double)(iFirst + i)));
+	}
 };
 
-class CBoxFilter : public CGenericFilter
+// Kernels: the filter functions as small value types with an inline,
+// non-virtual Filter and their support radius as Width(). TKernelFilter
+// turns one into a CGenericFilter.
+
+class CBoxKernel
 {
 public:
-	CBoxFilter() : CGenericFilter(0.5) {}
-	virtual ~CBoxFilter() {}
+	static double Width() { return 0.5; }
 
-	double Filter (double dVal) { return (fabs(dVal) <= m_dWidth ? 1.0 : 0.0); }
+	double Filter (double dVal) const { return (fabs(dVal) <= 0.5 ? 1.0 : 0.0); }
 };
 
-class CBilinearFilter : public CGenericFilter
+class CBilinearKernel
 {
 public:
+	static double Width() { return 1; }
 
-	CBilinearFilter () : CGenericFilter(1) {}
-	virtual ~CBilinearFilter() {}
-
-	double Filter (double dVal) {
+	double Filter (double dVal) const {
 		dVal = fabs(dVal);
-		return (dVal < m_dWidth ? m_dWidth - dVal : 0.0);
+		return (dVal < 1 ? 1 - dVal : 0.0);
 	}
 };
 
-class CBicubicFilter : public CGenericFilter
+// Mitchell-Netravali family; b = c = 1/3 is the recommended one.
+class CBicubicKernel
 {
-protected:
 	double p0, p2, p3;
 	double q0, q1, q2, q3;
 
 public:
+	static double Width() { return 2; }
 
-	CBicubicFilter (double b = (1/(double)3), double c = (1/(double)3)) : CGenericFilter(2) {
+	CBicubicKernel (double b = (1/(double)3), double c = (1/(double)3)) {
 		p0 = (6 - 2*b) / 6;
 		p2 = (-18 + 12*b + 6*c) / 6;
 		p3 = (12 - 9*b - 6*c) / 6;
@@ -61,9 +76,8 @@ public:
 		q2 = (6*b + 30*c) / 6;
 		q3 = (-b - 6*c) / 6;
 	}
-	virtual ~CBicubicFilter() {}
 
-	double Filter(double dVal) {
+	double Filter(double dVal) const {
 		dVal = fabs(dVal);
 		if(dVal < 1)
 			return (p0 + dVal*dVal*(p2 + dVal*p3));
@@ -73,44 +87,134 @@ public:
 	}
 };
 
-class CLanczos3Filter : public CGenericFilter
+class CBSplineKernel
 {
 public:
-	CLanczos3Filter() : CGenericFilter(3) {}
-	virtual ~CLanczos3Filter() {}
+	static double Width() { return 2; }
+
+	double Filter(double dVal) const {
+
+		dVal = fabs(dVal);
+		if(dVal < 1) return (4 + dVal*dVal*(-6 + 3*dVal)) / 6;
+		if(dVal < 2) {
+			double t = 2 - dVal;
+			return (t*t*t / 6);
+		}
+		return 0;
+	}
+};
+
+// sinc(x) * sinc(x / 3), read from a table of LUT_STEPS samples per unit
+// and interpolated linearly. That is within about 1e-7 of the exact value, a
+// five hundredth of a fixed point weight step, without two sin calls a tap.
+class CLanczos3Kernel
+{
+public:
+	enum { LUT_STEPS = 2048 };
 
-	double Filter(double dVal) {
+	static double Width() { return 3; }
+
+	CLanczos3Kernel() : m_pTable(Table()) {}
+
+	double Filter(double dVal) const {
 		dVal = fabs(dVal);
-		if(dVal < m_dWidth)     {
-			return (sinc(dVal) * sinc(dVal / m_dWidth));
+		if(dVal < 3) {
+			double dPos = dVal * LUT_STEPS;
+			int i = (int)dPos;
+			return m_pTable[i] + (dPos - i) * (m_pTable[i + 1] - m_pTable[i]);
+		}
+		return 0;
+	}
+
+	// The function itself, which the table is built from
+	static double Exact(double dVal) {
+		dVal = fabs(dVal);
+		if(dVal < 3) {
+			return (sinc(dVal) * sinc(dVal / 3));
 		}
 		return 0;
 	}
 
 private:
-	double sinc(double value) {
+	const double *m_pTable;
+
+	static double sinc(double value) {
 		if(value != 0) {
 			value *= FILTER_PI;
 			return (sin(value) / value);
 		}
 		return 1;
 	}
+
+	// Built by the first kernel made, on whichever thread that is
+	static const double* Table() {
+		struct CTable {
+			double Values[3 * LUT_STEPS + 1];
+			CTable() {
+				for(int i = 0; i <= 3 * LUT_STEPS; i++)
+					Values[i] = Exact((double)i / LUT_STEPS);
+			}
+		};
+		static const CTable table;
+		return table.Values;
+	}
 };
 
-class CBSplineFilter : public CGenericFilter
+// A kernel as a CGenericFilter. Sample loops over the kernel directly, so
+// the table builder gets every tap of a window inlined.
+template <class TKernel>
+class TKernelFilter : public CGenericFilter
 {
+protected:
+	TKernel m_Kernel;
+
 public:
-	CBSplineFilter() : CGenericFilter(2) {}
-	virtual ~CBSplineFilter() {}
+	TKernelFilter (const TKernel &kernel = TKernel()) : CGenericFilter(TKernel::Width()), m_Kernel(kernel) {}
+	virtual ~TKernelFilter() {}
 
-	double Filter(double dVal) {
+	const TKernel& GetKernel() const { return m_Kernel; }
 
-		dVal = fabs(dVal);
-		if(dVal < 1) return (4 + dVal*dVal*(-6 + 3*dVal)) / 6;
-		if(dVal < 2) {
-			double t = 2 - dVal;
-			return (t*t*t / 6);
-		}
-		return 0;
+	double Filter (double dVal) { return m_Kernel.Filter(dVal); }
+
+	void Sample (double dCenter, double dScale, int iFirst, int nTaps, double *pOut) {
+		for(int i = 0; i < nTaps; i++)
+			pOut[i] = m_Kernel.Filter(dScale * (dCenter - (double)(iFirst + i)));
 	}
-};
\ No newline at end of file
+};
+
+class CBoxFilter : public TKernelFilter<CBoxKernel>
+{
+public:
+	virtual ~CBoxFilter() {}
+};
+
+class CBilinearFilter : public TKernelFilter<CBilinearKernel>
+{
+public:
+	virtual ~CBilinearFilter() {}
+};
+
+class CBicubicFilter : public TKernelFilter<CBicubicKernel>
+{
+protected:
+	double m_dB, m_dC;
+
+public:
+
+	CBicubicFilter (double b = (1/(double)3), double c = (1/(double)3)) : TKernelFilter<CBicubicKernel>(CBicubicKernel(b, c)), m_dB(b), m_dC(c) {}
+	virtual ~CBicubicFilter() {}
+
+	void GetShape (double &dP, double &dQ) { dP = m_dB; dQ = m_dC; }
+};
+
+class CLanczos3Filter : public TKernelFilter<CLanczos3Kernel>
+{
+public:
+	virtual ~CLanczos3Filter() {}
+};
+
+class CBSplineFilter : public TKernelFilter<CBSplineKernel>
+{
+public:
+	virtual ~CBSplineFilter() {}
+};
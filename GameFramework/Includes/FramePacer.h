@@ -0,0 +1,85 @@
+// FramePacer.h
+// Waits for frame deadlines by sleeping most of the way and spinning the rest.
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include "FrameHistogram.h"
+
+//-----------------------------------------------------------------------------
+// Name : CPacingStats (Struct)
+// Desc : How well a pacer kept to its target. Times are in seconds.
+//-----------------------------------------------------------------------------
+struct CPacingStats
+{
+	unsigned long	Frames;			// Paced frames measured
+	double			TargetPeriod;	// Period last asked for
+	double			MeanPeriod;		// Achieved, start to start
+	double			JitterP50;		// |achieved - target| percentiles
+	double			JitterP99;
+	double			JitterMax;
+	double			SleepMargin;	// Current spin time before each deadline
+	double			MeanOversleep;	// Average wake-up past what was asked
+	double			MaxOversleep;
+	unsigned long	LateWakes;		// Sleeps that woke past the deadline itself
+};
+
+//-----------------------------------------------------------------------------
+// Name : CFramePacer (Class)
+// Desc : OS sleeps are cheap but coarse: they wake up anywhere from a few
+//		microseconds to a couple of milliseconds late. Spinning is exact but
+//		burns the core. WaitUntil() sleeps until a margin before the
+//		deadline and spins only for that margin.
+//
+//		The margin follows the wake-up error actually seen: every sleep
+//		measures how far past its target it woke, and the margin is kept at
+//		the average of that plus a few deviations. It shrinks to a fraction
+//		of a millisecond where sleeps are precise (clock_nanosleep on Linux,
+//		or Windows with 1 ms timer resolution) and grows where they are not.
+//
+//		Times are seconds on the steady clock, see Now().
+//-----------------------------------------------------------------------------
+class CFramePacer
+{
+public:
+	CFramePacer();
+	~CFramePacer();
+
+	static double Now();
+
+	// Returns at fDeadline, or right away if that has passed.
+	void WaitUntil(double fDeadline);
+
+	// Holds the caller to one call per fPeriod seconds, measured from the
+	// previous call's deadline so the rate does not drift. After falling a
+	// whole period behind it starts counting from now instead of hurrying.
+	void Pace(double fPeriod);
+
+	// Forgets the previous frame; the next Pace() call starts a new run.
+	void Reset();
+
+	CPacingStats GetStats() const;
+
+private:
+	CFramePacer(const CFramePacer& rhs);
+	CFramePacer& operator=(const CFramePacer& rhs);
+
+	void Sleep(double fSeconds);
+	void UpdateMargin(double fOversleep);
+
+	// Wake-up error, as running averages
+	double			m_fMargin;
+	double			m_fOversleepMean;
+	double			m_fOversleepDev;
+	double			m_fOversleepMax;
+	unsigned long	m_nLateWakes;
+
+	// Pace() state
+	double			m_fPeriod;
+	double			m_fDeadline;		// When the next frame is due, 0 before the first
+	double			m_fLastFrame;		// When the previous one was let go
+	double			m_fPeriodTotal;
+	unsigned long	m_nFrames;
+	CFrameHistogram	m_Jitter;
+};
+
+#endif // FRAMEPACER_H
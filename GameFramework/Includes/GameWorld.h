@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+// File: GameWorld.h
+//
+// Desc: The game itself: players, crates, collisions and scoring, stepped
+//	   one fixed tick at a time. No window, no clock and no keyboard, so
+//	   the same world runs inside the game and in the headless runner.
+//-----------------------------------------------------------------------------
+
+#ifndef _GAMEWORLD_H_
+#define _GAMEWORLD_H_
+
+//-----------------------------------------------------------------------------
+// CGameWorld Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CPlayer.h"
+#include "CPlayer2.h"
+#include "Enemy.h"
+#include "BackgroundLayer.h"
+#include "SpatialHash.h"
+#include "WorldSnapshot.h"
+#include "TimingWheel.h"
+#include "Random.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameRules (Struct)
+// Desc : The balance knobs, so batch runs can try other values. The
+//		defaults are the ones the game ships with.
+//-----------------------------------------------------------------------------
+struct CGameRules
+{
+	UINT	CrateInterval;		// Milliseconds between crates
+	UINT	CoinInterval;		// Milliseconds between coins
+	int		FishScore;			// Score that upgrades a player to a fish
+	int		SharkScore;			// Score that upgrades a fish to a shark
+
+	CGameRules() : CrateInterval(500), CoinInterval(10000), FishScore(1000), SharkScore(5000) {}
+};
+
+//-----------------------------------------------------------------------------
+// Name : CGameWorld (Class)
+// Desc : Everything the simulation owns. Each step takes one input mask;
+//		given the same tick rate, seed and masks, two worlds go through the
+//		same states on any machine.
+//-----------------------------------------------------------------------------
+class CGameWorld
+{
+public:
+	//-------------------------------------------------------------------------
+	// Enumerators
+	//-------------------------------------------------------------------------
+	// One step's input as a mask. The low 16 bits are the held direction
+	// keys, a byte per player; the rest are actions pressed since the last
+	// step. Recordings store these, so never renumber them.
+	enum EInput
+	{
+		INPUT_KEYS			= 0x0000FFFF,
+		INPUT_EXPLODE		= 1 << 16,
+		INPUT_FIRE2			= 1 << 17,
+		INPUT_FIRE			= 1 << 18,
+		INPUT_EXPLODE2		= 1 << 19,
+		INPUT_ROTATE		= 1 << 20,
+		INPUT_ROTATE_BACK	= 1 << 21,
+		INPUT_ROTATE2		= 1 << 22,
+		INPUT_ROTATE2_BACK	= 1 << 23,
+		INPUT_SAVE			= 1 << 24,
+		INPUT_LOAD			= 1 << 25
+	};
+
+	// Client height of the game's 800x600 window, for worlds without one
+	enum { DEFAULT_VIEW_HEIGHT = 561 };
+
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+			 CGameWorld();
+	virtual ~CGameWorld();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+	// Loads the game objects; false if an asset is missing. nViewHeight is
+	// how much of the background the screen shows, for where it starts.
+	bool		Build			  ( int nViewHeight );
+	void		Release			  ( );
+
+	// Starts a game: scores and lives back to the start, players on their
+	// marks and the spawn timers running.
+	void		Setup			  ( float fTickRate, uint64_t seed, const CGameRules& rules = CGameRules() );
+
+	// Advances the game by one fixed step of dt seconds.
+	void		Step			  ( float dt, ULONG ulInput );
+
+	// Adds the world as the last step left it to the snapshot.
+	void		Record			  ( CWorldSnapshot& frame );
+
+	// Sends the sprite pools' usage to the debugger.
+	void		ReportPools		  ( ) const;
+
+	// A player ran out of lives; the game is over.
+	bool		IsOver			  ( ) const { return m_bGameOver; }
+
+	unsigned long	GetStepCount	  ( ) const { return m_nSteps; }
+	ULONG			GetLiveEntities	  ( ) const { return m_nLiveEntities; }
+	const CBackgroundLayer& GetScroll ( ) const { return m_Scroll; }
+	int				GetScore		  ( ) const { return Score; }
+	int				GetScore2		  ( ) const { return Score2; }
+	int				GetLives		  ( ) const { return Lives; }
+	int				GetLives2		  ( ) const { return Lives2; }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+	void		ApplyInput		  ( ULONG ulInput );
+	void		SetGameTimer	  ( UINT nID, UINT nElapse );
+	void		OnGameTimer		  ( UINT nID );
+	void		AnimateObjects	  ( float dt );
+	void        SaveGame();
+	void        LoadGame();
+	void Collision();
+	void BuildCollisionGrid();
+	void FlushEntities();
+	void BulletCrateCollision();
+	void PlaneCrateCollision();
+	void FishCoinCollision();
+
+	void FishUpgrade();
+	void LifeSpawn();
+	void HeartCollision();
+
+	//-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+	float					m_fTickRate;		// Simulation steps per second
+	unsigned long			m_nSteps;			// Steps run so far
+	CTimingWheel			m_Events;			// Game timers, in steps
+	enum { MAX_GAME_TIMERS = 8 };
+	CTimingWheel::Handle	m_GameTimers[MAX_GAME_TIMERS];	// By SetGameTimer id
+	CRandom					m_Random;			// Everything the game rolls
+	CGameRules				m_Rules;
+
+	CBackgroundLayer		m_Scroll;		  // Only the offset, for the snapshots
+
+	// Collision layers of the broadphase grid.
+	enum ECollisionLayer
+	{
+		LAYER_CRATE,
+		LAYER_COIN,
+		LAYER_HEART,
+		LAYER_BULLET,
+		LAYER_BULLET2,
+		LAYER_PLAYER,
+		LAYER_PLAYER2
+	};
+
+	CSpatialHash			m_Collisions;	  // Rebuilt every step
+	std::vector<CCollisionPair> m_Pairs;
+	ULONG					m_nLiveEntities;	  // Sprites alive after the last step
+	ULONG					m_nFreedEntities;	  // Sprites freed at the end of it
+	bool					m_bGameOver;		  // A player lost the last life
+
+	CPlayer*				m_pPlayer;
+	CPlayer2*               m_pRacheta;
+	int RotateIt = 0;
+	int RotateIt2=0;
+	struct SaveData {
+    Vec2 posPlayer1;
+	Vec2 posPlayer2;
+	};
+	Enemy* Crate;
+	int Score = 0;
+	int Lives = 3;
+	int Score2 = 0;
+	int Lives2 = 3;
+
+	CGameWorld(const CGameWorld& rhs);
+	CGameWorld& operator=(const CGameWorld& rhs);
+};
+
+#endif // _GAMEWORLD_H_
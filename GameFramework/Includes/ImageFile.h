@@ -2,7 +2,7 @@
 // ImageFile.h
 // by Mihai Popescu
 // March 2009
-#include "main.h"
+#include "Main.h"
 
 
 typedef BYTE (*RGBQUAD_TO_BYTE)(const RGBQUAD &q);
@@ -26,7 +26,9 @@ class CImageFile
 protected:
 	BITMAPINFOHEADER m_biInfo;
 	RGBQUAD *m_pRGB;
+#ifdef _WIN32
 	HBITMAP m_hBMP;
+#endif
 
 	LONG &height;
 	LONG &width;
@@ -36,14 +38,25 @@ public:
 	CImageFile(void);
 	virtual ~CImageFile(void);
 
+	// Makes a blank (black) image of the size, for drawing into.
+	bool Create(LONG nWidth, LONG nHeight);
+
+#ifdef _WIN32
 	bool LoadBitmapFromFile(const char* szFileName, HDC hdc);
 	virtual void Paint(HDC hdc, int x, int y);
+#endif
 
 	LONG Height() const { return height; }
 	LONG Width() const { return width; }
 
+	// Rows from the bottom up, as in a DIB
+	RGBQUAD* GetPixels() { return m_pRGB; }
+	const RGBQUAD* GetPixels() const { return m_pRGB; }
+
 	void Clear() { ZeroMemory(m_pRGB, sizeof(RGBQUAD) * width * height); }
+#ifdef _WIN32
 	void Reload(HDC hdc);
+#endif
 
 	BYTE* CopyMonoImage(EColorChannel chn, const RECT* rc = NULL);
 	void PasteMonoImage(const BYTE *img, EColorChannel chn, const RECT* rc = NULL);
@@ -0,0 +1,45 @@
+// InputBot.h
+// Scripted stand-in players for runs without a keyboard.
+#ifndef INPUTBOT_H
+#define INPUTBOT_H
+
+#include "GameWorld.h"
+#include "Random.h"
+
+//-----------------------------------------------------------------------------
+// Name : CInputBot (Class)
+// Desc : Makes one input mask per step for both players: holds random
+//		directions for a while, fires often and now and then rotates. It
+//		never saves or loads, so runs do not touch data/Text.txt. Its own
+//		random numbers are salted, so a bot and a world given the same seed
+//		do not roll the same sequence.
+//-----------------------------------------------------------------------------
+class CInputBot
+{
+public:
+	explicit CInputBot(uint64_t seed) : m_Random(seed ^ 0x9E3779B97F4A7C15ULL), m_ulKeys(0), m_nHold(0) {}
+
+	ULONG Next()
+	{
+		// A new pair of held directions every 10 to 60 steps
+		if(m_nHold-- <= 0)
+		{
+			m_ulKeys = (ULONG)m_Random.Range(16) | ((ULONG)m_Random.Range(16) << 8);
+			m_nHold = 10 + m_Random.Range(50);
+		}
+
+		ULONG ulInput = m_ulKeys;
+		if(m_Random.Range(8) == 0)   ulInput |= CGameWorld::INPUT_FIRE;
+		if(m_Random.Range(8) == 0)   ulInput |= CGameWorld::INPUT_FIRE2;
+		if(m_Random.Range(200) == 0) ulInput |= CGameWorld::INPUT_ROTATE;
+		if(m_Random.Range(200) == 0) ulInput |= CGameWorld::INPUT_ROTATE2;
+		return ulInput;
+	}
+
+private:
+	CRandom	m_Random;
+	ULONG	m_ulKeys;
+	int		m_nHold;
+};
+
+#endif // INPUTBOT_H
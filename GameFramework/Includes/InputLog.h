@@ -0,0 +1,89 @@
+// InputLog.h
+// Per-step game input, recorded to and played back from a file.
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <fstream>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Name : CInputLogHeader (Struct)
+// Desc : What a recording starts from, after a "GINP" tag. The rest of the
+//		file is the input mask of every simulation step, run-length encoded:
+//		a varint count followed by the 32 bit mask held for that many steps,
+//		all little endian. Held keys change a few times a second at most, so
+//		a minute of play usually takes a few hundred bytes.
+//-----------------------------------------------------------------------------
+struct CInputLogHeader
+{
+	enum { VERSION = 1 };
+
+	uint32_t	Version;
+	float		TickRate;	// Steps per second the session ran at
+	uint64_t	Seed;		// Game random seed
+};
+
+//-----------------------------------------------------------------------------
+// Name : CInputRecorder (Class)
+// Desc : Writes one mask per simulation step. Runs are only written once
+//		they end, so the file is complete after Close() (or destruction).
+//-----------------------------------------------------------------------------
+class CInputRecorder
+{
+public:
+	CInputRecorder();
+	~CInputRecorder();
+
+	bool Open(const char* szFileName, const CInputLogHeader& header);
+	void Close();
+	bool IsOpen() const { return m_File.is_open(); }
+
+	void Record(uint32_t mask);
+
+	uint64_t GetStepCount() const { return m_nSteps; }
+
+private:
+	CInputRecorder(const CInputRecorder& rhs);
+	CInputRecorder& operator=(const CInputRecorder& rhs);
+
+	void FlushRun();
+
+	std::ofstream	m_File;
+	uint32_t		m_RunMask;
+	uint64_t		m_RunLength;
+	uint64_t		m_nSteps;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CInputPlayer (Class)
+// Desc : Reads a recording back one step at a time.
+//-----------------------------------------------------------------------------
+class CInputPlayer
+{
+public:
+	CInputPlayer();
+
+	// Returns false if the file is missing or not a recording.
+	bool Open(const char* szFileName);
+	void Close() { m_File.close(); }
+	bool IsOpen() const { return m_File.is_open(); }
+
+	const CInputLogHeader& GetHeader() const { return m_Header; }
+
+	// The next step's mask; false once the recording has run out.
+	bool Next(uint32_t& mask);
+
+	uint64_t GetStepCount() const { return m_nSteps; }
+
+private:
+	CInputPlayer(const CInputPlayer& rhs);
+	CInputPlayer& operator=(const CInputPlayer& rhs);
+
+	std::ifstream	m_File;
+	CInputLogHeader	m_Header;
+	uint32_t		m_RunMask;
+	uint64_t		m_RunLeft;
+	uint64_t		m_nSteps;
+};
+
+#endif // INPUTLOG_H
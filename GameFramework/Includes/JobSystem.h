@@ -0,0 +1,181 @@
+// JobSystem.h
+// Work-stealing thread pool for engine subsystems.
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+class CJobSystem;
+
+//-----------------------------------------------------------------------------
+// Name : CJob (Class)
+// Desc : A piece of work plus the bookkeeping to run it. Jobs are owned by
+//		whoever creates them (usually on the stack) and must stay alive until
+//		they are done.
+//
+//		A job with a parent counts as part of it: the parent is only done
+//		once its own work and all of its children are. Children have to be
+//		set up before the parent finishes, i.e. before submitting it or from
+//		inside its work.
+//
+//		DependOn() holds a job back until another one is done. Dependencies
+//		have to be declared before either job is submitted.
+//
+//		Set() makes a job an ordinary one again after SubmitBackground().
+//-----------------------------------------------------------------------------
+class CJob
+{
+public:
+	enum { MAX_DEPENDENTS = 8 };
+
+	CJob();
+	explicit CJob(const std::function<void()>& work, CJob* pParent = NULL);
+
+	// Gives the job new work. It must not be in flight.
+	void Set(const std::function<void()>& work, CJob* pParent = NULL);
+
+	// Returns false if the prerequisite has no room for another dependent.
+	bool DependOn(CJob& prerequisite);
+
+	bool IsDone() const { return m_Unfinished.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class CJobSystem;
+
+	CJob(const CJob& rhs);
+	CJob& operator=(const CJob& rhs);
+
+	std::function<void()>	m_Work;
+	CJob*					m_pParent;
+	std::atomic<int>		m_Unfinished;	// Own work plus unfinished children
+	std::atomic<int>		m_Blockers;		// Unfinished prerequisites, plus one until submitted
+	CJob*					m_Dependents[MAX_DEPENDENTS];
+	int						m_nDependents;
+	bool					m_bBackground;	// Queued where only workers look
+};
+
+//-----------------------------------------------------------------------------
+// Name : CJobSystem (Class)
+// Desc : Worker threads with a job queue each. A thread pushes and pops its
+//		own jobs at the back of its queue, newest first, which keeps the data
+//		it just touched in cache; idle threads steal from the front of the
+//		others', taking the oldest and usually biggest pieces of work.
+//
+//		Threads that are not workers (the window, the simulation) share one
+//		extra queue. Wait() never just blocks: the waiting thread runs queued
+//		jobs until the one it waits for is done, so waiting from inside a job
+//		or with no workers at all still makes progress.
+//
+//		Background jobs go to one more queue that only workers take from, and
+//		only when they find nothing else, so a long job handed off by the
+//		frame thread is not picked up again by its next ParallelFor or Wait.
+//-----------------------------------------------------------------------------
+class CJobSystem
+{
+public:
+	enum { MAX_CHUNKS = 64 };
+
+	CJobSystem();
+	~CJobSystem();
+
+	// Starts the workers; a negative count means one per core, less the
+	// calling thread. Zero workers is valid, everything then runs in Wait().
+	bool Start(int nWorkers = -1);
+	void Stop();
+
+	int GetWorkerCount() const { return (int)m_Workers.size(); }
+
+	// Threads that take part in a parallel loop: the workers and the caller.
+	int GetThreadCount() const { return (int)m_Workers.size() + 1; }
+
+	// Queues the job, or holds it back until its prerequisites are done.
+	void Submit(CJob& job);
+
+	// Submit, but for the workers alone. The jobs the work submits itself
+	// are ordinary ones. Without workers this is Submit, as nothing else
+	// would ever run the job.
+	void SubmitBackground(CJob& job);
+
+	// Runs other jobs until this one is done.
+	void Wait(CJob& job);
+
+	// Calls body(first, last) over [begin, end) in chunks of at least grain
+	// items, the caller taking the first chunk, and returns when all are done.
+	template <typename F>
+	void ParallelFor(size_t begin, size_t end, size_t grain, const F& body);
+
+private:
+	CJobSystem(const CJobSystem& rhs);
+	CJobSystem& operator=(const CJobSystem& rhs);
+
+	struct CWorkQueue
+	{
+		std::mutex			Lock;
+		std::vector<CJob*>	Jobs;	// Owner end is the back
+		size_t				Head;	// Thieves take Jobs[Head]
+	};
+
+	size_t QueueIndex() const;
+	void Push(CJob& job);
+	CJob* FindJob(size_t index);
+	void Execute(CJob& job);
+	void Finish(CJob& job);
+	void WorkerMain(size_t index);
+
+	std::vector<std::thread>				m_Workers;
+	std::vector<std::unique_ptr<CWorkQueue>> m_Queues;	// 0 is shared by non-workers
+	CWorkQueue								m_Background;
+	std::atomic<bool>						m_bRunning;
+	std::atomic<int>						m_nQueued;
+	std::atomic<int>						m_nSleeping;
+	std::mutex								m_WakeLock;
+	std::condition_variable					m_Wake;
+};
+
+template <typename F>
+void CJobSystem::ParallelFor(size_t begin, size_t end, size_t grain, const F& body)
+{
+	if(end <= begin)
+		return;
+
+	// A few chunks per thread, so a slow one can be balanced by stealing.
+	size_t count = end - begin;
+	size_t chunks = (count + (grain ? grain : 1) - 1) / (grain ? grain : 1);
+	size_t maxChunks = (size_t)GetThreadCount() * 4;
+	if(chunks > maxChunks) chunks = maxChunks;
+	if(chunks > MAX_CHUNKS) chunks = MAX_CHUNKS;
+
+	if(chunks <= 1 || m_Workers.empty())
+	{
+		body(begin, end);
+		return;
+	}
+
+	size_t chunkSize = (count + chunks - 1) / chunks;
+	size_t firstEnd = begin + chunkSize;
+
+	CJob root([&body, begin, firstEnd]() { body(begin, firstEnd); });
+	CJob jobs[MAX_CHUNKS];
+	for(size_t i = 1; i < chunks; i++)
+	{
+		size_t first = begin + i * chunkSize;
+		if(first >= end)
+			break;
+
+		size_t last = first + chunkSize < end ? first + chunkSize : end;
+		jobs[i].Set([&body, first, last]() { body(first, last); }, &root);
+		Submit(jobs[i]);
+	}
+
+	Execute(root);
+	Wait(root);
+}
+
+#endif // JOBSYSTEM_H
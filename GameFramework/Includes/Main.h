@@ -12,13 +12,18 @@
 //-----------------------------------------------------------------------------
 // Main Application Includes
 //-----------------------------------------------------------------------------
+#ifdef _WIN32
 #define CRTDBG_MAP_ALLOC
 #include "..\\Res\\resource.h"
 #include <windows.h>
 #include <crtdbg.h>
-#include <assert.h> 
 #include "Commdlg.h"
 #include <tchar.h>
+#else
+// The headless runner builds the game objects without windows.h
+#include "Win32Types.h"
+#endif
+#include <assert.h> 
 #include <stdio.h>
 #include <math.h>
 
@@ -0,0 +1,95 @@
+// Presenter.h
+// Ways of getting a finished back buffer frame somewhere.
+//
+// The back buffer only owns pixels; where they end up is up to the
+// presenter plugged into it. The window presenter lives in
+// Win32Presenter.h, the ones here need no display at all.
+#ifndef PRESENTER_H
+#define PRESENTER_H
+
+#include "Blitter.h"
+#include "DirtyRegion.h"
+#include <fstream>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : IPresenter (Interface)
+// Desc : Receives every finished frame from the back buffer, together with
+//		the region that changed since the previous one. Presenters that keep
+//		their own copy of the frame only need to update that region.
+//-----------------------------------------------------------------------------
+class IPresenter
+{
+public:
+	virtual ~IPresenter() {}
+
+	virtual void Present(const CPixelSurface& frame, const CDirtyRegion& dirty) = 0;
+
+	unsigned long GetFramesPresented() const { return m_FramesPresented; }
+
+	// Pixels copied out for the last frame presented.
+	unsigned long GetPixelsPushed() const { return m_PixelsPushed; }
+
+protected:
+	IPresenter() : m_FramesPresented(0), m_PixelsPushed(0) {}
+
+	unsigned long m_FramesPresented;
+	unsigned long m_PixelsPushed;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CMemoryPresenter (Class)
+// Desc : Headless presenter, keeps a copy of the last frame in memory.
+//-----------------------------------------------------------------------------
+class CMemoryPresenter : public IPresenter
+{
+public:
+	CMemoryPresenter() : m_Width(0), m_Height(0) {}
+
+	virtual void Present(const CPixelSurface& frame, const CDirtyRegion& dirty);
+
+	int Width() const { return m_Width; }
+	int Height() const { return m_Height; }
+	const unsigned int* Pixels() const { return m_Frame.data(); }
+
+private:
+	std::vector<unsigned int> m_Frame;
+	int m_Width;
+	int m_Height;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CNullPresenter (Class)
+// Desc : Drops every frame, only counting what a presenter keeping a copy
+//		would have pushed. For timing the renderer on its own.
+//-----------------------------------------------------------------------------
+class CNullPresenter : public IPresenter
+{
+public:
+	virtual void Present(const CPixelSurface& frame, const CDirtyRegion& dirty);
+};
+
+//-----------------------------------------------------------------------------
+// Name : CFrameDumpPresenter (Class)
+// Desc : Appends every frame to a file as raw 32 bit BGRA rows, top-down.
+//		Always writes whole frames, whatever the dirty region says.
+//		The result plays back with e.g.
+//		ffmpeg -f rawvideo -pix_fmt bgra -s 800x600 -i frames.raw out.mp4
+//-----------------------------------------------------------------------------
+class CFrameDumpPresenter : public IPresenter
+{
+public:
+	CFrameDumpPresenter(const char* szFileName);
+
+	bool IsOpen() const { return m_File.is_open(); }
+
+	virtual void Present(const CPixelSurface& frame, const CDirtyRegion& dirty);
+
+private:
+	CFrameDumpPresenter(const CFrameDumpPresenter& rhs);
+	CFrameDumpPresenter& operator=(const CFrameDumpPresenter& rhs);
+
+	std::ofstream m_File;
+};
+
+#endif // PRESENTER_H
@@ -0,0 +1,84 @@
+// Profiler.h
+// Scoped timing zones, recorded per thread and exported as a Chrome trace.
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Debug builds profile by default; define GAME_PROFILER as 1 or 0 in the
+// project settings to force it either way.
+#ifndef GAME_PROFILER
+#ifdef _DEBUG
+#define GAME_PROFILER 1
+#else
+#define GAME_PROFILER 0
+#endif
+#endif
+
+#if GAME_PROFILER
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Name : CProfiler (Class)
+// Desc : Collects the zones every thread ran. Each thread records into a
+//		ring buffer of its own, so recording takes no locks; once a ring is
+//		full the oldest zones are overwritten. Zones nest by time, which is
+//		how the trace viewer builds the hierarchy.
+//
+//		Export while other threads are still recording is allowed, but the
+//		zones they overwrite during it are left out.
+//-----------------------------------------------------------------------------
+class CProfiler
+{
+public:
+	enum { RING_SIZE = 1 << 16 };	// Zones kept per thread
+
+	// Nanoseconds on a steady clock.
+	static int64_t Now();
+
+	// Adds a finished zone to the calling thread's ring. szName must
+	// outlive the profiler; string literals do.
+	static void Record(const char* szName, int64_t start, int64_t end);
+
+	// Name the calling thread shows up with in the trace.
+	static void SetThreadName(const char* szName);
+
+	// Writes everything still in the rings as Chrome trace_event JSON, for
+	// chrome://tracing or ui.perfetto.dev. Returns false if the file could
+	// not be written.
+	static bool ExportChromeTrace(const char* szFileName);
+};
+
+//-----------------------------------------------------------------------------
+// Name : CProfileZone (Class)
+// Desc : Times the scope it lives in. Use PROFILE_ZONE rather than this
+//		directly, so release builds lose it.
+//-----------------------------------------------------------------------------
+class CProfileZone
+{
+public:
+	explicit CProfileZone(const char* szName) : m_szName(szName), m_Start(CProfiler::Now()) {}
+	~CProfileZone() { CProfiler::Record(m_szName, m_Start, CProfiler::Now()); }
+
+private:
+	CProfileZone(const CProfileZone& rhs);
+	CProfileZone& operator=(const CProfileZone& rhs);
+
+	const char*	m_szName;
+	int64_t		m_Start;
+};
+
+#define PROFILE_CONCAT2(a, b)		a##b
+#define PROFILE_CONCAT(a, b)		PROFILE_CONCAT2(a, b)
+#define PROFILE_ZONE(name)			CProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD(name)		CProfiler::SetThreadName(name)
+#define PROFILE_EXPORT(file)		CProfiler::ExportChromeTrace(file)
+
+#else
+
+#define PROFILE_ZONE(name)			((void)0)
+#define PROFILE_THREAD(name)		((void)0)
+#define PROFILE_EXPORT(file)		(false)
+
+#endif // GAME_PROFILER
+
+#endif // PROFILER_H
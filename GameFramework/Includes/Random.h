@@ -0,0 +1,58 @@
+// Random.h
+// Small, seedable random number generator for game logic.
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Name : CRandom (Class)
+// Desc : PCG32: 64 bits of state, 32 bit results, and the same sequence on
+//		every compiler and platform for the same seed, which rand() does not
+//		promise. Everything the simulation rolls comes from one of these, so
+//		a recorded seed is enough to play a session back exactly.
+//-----------------------------------------------------------------------------
+class CRandom
+{
+public:
+	explicit CRandom(uint64_t seed = 0) { Seed(seed); }
+
+	void Seed(uint64_t seed)
+	{
+		m_Seed = seed;
+		m_State = 0;
+		Next();
+		m_State += seed;
+		Next();
+	}
+
+	uint64_t GetSeed() const { return m_Seed; }
+
+	uint32_t Next()
+	{
+		uint64_t old = m_State;
+		m_State = old * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rot = (uint32_t)(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+
+	// Uniform in [0, n), n > 0; like rand() % n without the bias.
+	int Range(int n)
+	{
+		uint32_t bound = (uint32_t)n;
+		uint32_t threshold = (0u - bound) % bound;
+		for(;;)
+		{
+			uint32_t r = Next();
+			if(r >= threshold)
+				return (int)(r % bound);
+		}
+	}
+
+private:
+	uint64_t	m_State;
+	uint64_t	m_Seed;
+};
+
+#endif // RANDOM_H
@@ -1,63 +1,188 @@
 #pragma once
 #include "Filters.h"
 #include "ImageFile.h"
+#include "JobSystem.h"
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <typeindex>
 
-class CWeightsTable
+// Fraction bits of the fixed point weights the kernels use. A short holds
+// Q14 values in [-2.0, 2.0), so 2.0 itself does not fit: normalized weights
+// have to stay below 2.0 in magnitude. Those of the filters here do (Lanczos
+// reaches about 1.34 on windows cut by the image edge), and the table
+// builder saturates anything beyond. A window's weights then add up to at
+// most a few times 1.0 in magnitude, so 255 times that is far inside the
+// 32 bit accumulators.
+#define RESIZE_WEIGHT_BITS 14
+#define RESIZE_WEIGHT_ONE  (1 << RESIZE_WEIGHT_BITS)
+
+enum EResamplePath
 {
-	typedef struct 
-	{
-		double *Weights;			// Normalized weights of neighboring pixels
-		int Left, Right;			// Bounds of source pixels window
-	} sContribution;
+	RESAMPLE_SCALAR,
+	RESAMPLE_SSE2,
+	RESAMPLE_AVX2
+};
+
+// Kernel selection, as with the blitter. The best path the CPU supports is
+// picked on first use; forcing a path is meant for comparing them.
+EResamplePath GetResamplePath();
+void SetResamplePath(EResamplePath path);
 
+// Contribution table of one pass: for every destination pixel, the window
+// of source pixels it reads and their fixed point weights. The weights live
+// in one block, a zero padded row of m_WindowStride shorts per destination
+// pixel, and the windows' bounds in another.
+class CWeightsTable
+{
 private:
-	// Row (or column) of contribution weights
-	sContribution *m_WeightTable;
+	// Weights of all windows, 32 byte aligned
+	short *m_pWeights;
+	// Left and right bound of every window, in pairs
+	int *m_pBounds;
+	// Storage behind both
+	unsigned char *m_pBuffer;
 	// Filter window size (of affecting source pixels)
 	DWORD m_WindowSize;
+	// Window size rounded up to whole 16 byte vectors
+	DWORD m_WindowStride;
 	// Length of line (no. of rows / cols)
 	DWORD m_LineLength;
 
+	CWeightsTable(const CWeightsTable &rhs);
+	CWeightsTable &operator=(const CWeightsTable &rhs);
+
 public:
 	
 	CWeightsTable(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize);
 	~CWeightsTable();
 
-	// Retrieve a filter weight, given source and destination positions
-	double getWeight(int dst_pos, int src_pos) {
-			return m_WeightTable[dst_pos].Weights[src_pos];
+	// Retrieve the fixed point weights of a destination position, summing
+	// to exactly RESIZE_WEIGHT_ONE
+	const short* getFixedWeights(int dst_pos) const {
+			return m_pWeights + dst_pos * m_WindowStride;
 	}
 
 	// Retrieve left boundary of source line buffer
-	int getLeftBoundary(int dst_pos) {
-			return m_WeightTable[dst_pos].Left;
+	int getLeftBoundary(int dst_pos) const {
+			return m_pBounds[2 * dst_pos];
 	}
 
 	// Retrieve right boundary of source line buffer
-	int getRightBoundary(int dst_pos) {
-			return m_WeightTable[dst_pos].Right;
+	int getRightBoundary(int dst_pos) const {
+			return m_pBounds[2 * dst_pos + 1];
+	}
+
+	size_t SizeInBytes() const {
+			return m_LineLength * (m_WindowStride * sizeof(short) + 2 * sizeof(int));
 	}
 };
 
+typedef std::shared_ptr<const CWeightsTable> WeightsTablePtr;
+
+// The vertical pass alone, on the calling thread: dst_height rows of width
+// pixels, row u blending the source rows in window u of the table. Resample
+// runs the same rows in bands on the job system; this is for timing it.
+void ResampleVertical(RGBQUAD *pDst, const RGBQUAD *pSrc, unsigned int width,
+					  const CWeightsTable &weights, unsigned int dst_height);
+
+//-----------------------------------------------------------------------------
+// Name : CWeightsCache (Class)
+// Desc : Keeps the tables of recent resizes, keyed by the filter and both
+//		sizes, so resizing to the same geometry again (sprites every frame,
+//		a window being dragged) skips building them. Safe to call from
+//		several threads.
+//-----------------------------------------------------------------------------
+class CWeightsCache
+{
+public:
+	struct Stats
+	{
+		unsigned long	Hits;			// Requests served from the cache
+		unsigned long	Misses;			// Requests that built a table
+		unsigned long	TableCount;		// Tables currently held
+		size_t			BytesResident;	// Their size
+	};
+
+	// Tables beyond this many are dropped, least recently used first
+	enum { MAX_TABLES = 32 };
+
+	CWeightsCache();
+
+	// Returns the table for the filter and sizes, building it on first use.
+	WeightsTablePtr Acquire(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize);
+
+	// Drops tables nobody outside the cache holds anymore.
+	void Trim();
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+	CWeightsCache(const CWeightsCache &rhs);
+	CWeightsCache &operator=(const CWeightsCache &rhs);
+
+	struct Key
+	{
+		std::type_index	Type;
+		double			Width, ShapeP, ShapeQ;
+		DWORD			DstSize, SrcSize;
+
+		Key(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize);
+		bool operator<(const Key &rhs) const;
+	};
+
+	struct Entry
+	{
+		WeightsTablePtr	pTable;
+		unsigned long	LastUse;
+	};
+
+	typedef std::map<Key, Entry> TableMap;
+
+	void Evict();
+
+	mutable std::mutex	m_Lock;
+	TableMap			m_Tables;
+	unsigned long		m_nUses;
+	Stats				m_Stats;
+};
+
+// The cache Resample goes through.
+CWeightsCache &GetWeightsCache();
+
 
 class CResizableImage : public CImageFile
 {
 	CGenericFilter *m_pFilter;
 	RGBQUAD *m_pResImg;
-	CWeightsTable *m_pWeights;
+	WeightsTablePtr m_pWeights;
+	// The resize ResampleAsync queued, if any
+	CJob m_ResizeJob;
 
 public:
 	CResizableImage() { m_pFilter = NULL; }
-	virtual ~CResizableImage() {}
+	virtual ~CResizableImage();
 
 	void SetFilter(CGenericFilter *pFilter) { m_pFilter = pFilter; }
 
-	// Scale an image to the desired dimensions
+	// Scale an image to the desired dimensions. Both passes are split into
+	// bands of rows run on the job system.
 	void Resample(unsigned dst_width, unsigned dst_height);
 
+	// Resample queued for the worker threads, so a big image is scaled off
+	// the frame thread even while that runs jobs of its own. Leave the image
+	// (and its filter) alone until the future is ready. Without worker
+	// threads it resizes before returning.
+	std::future<void> ResampleAsync(unsigned dst_width, unsigned dst_height);
+
 private:
+	void ResampleImage(unsigned dst_width, unsigned dst_height);
+
 	void ScaleRow(unsigned int dst_width, unsigned int /*dst_height*/, unsigned int row);
-	void ScaleCol(unsigned int dst_width, unsigned int dst_height, unsigned int col);
+	// Computes one destination row of the vertical pass, all columns at once
+	void ScaleCols(unsigned int dst_width, unsigned int row);
 
 	// Performs horizontal image filtering
 	void HorizontalFilter(unsigned int dst_width, unsigned int dst_height);
@@ -0,0 +1,84 @@
+// SpatialHash.h
+// Uniform grid broadphase for circle colliders.
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <stddef.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CCollisionPair (Struct)
+// Desc : Ids of two colliders, in the order of the layers they were asked for.
+//-----------------------------------------------------------------------------
+struct CCollisionPair
+{
+	int A;
+	int B;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CSpatialHash (Class)
+// Desc : Buckets circle colliders into square grid cells, hashing the cell
+//		coordinates so the grid has no bounds. Rebuild it every frame with
+//		Clear() and Insert(), then ask for the overlapping pairs between two
+//		layers. Colliders are identified by a caller chosen id, typically
+//		the index of the object in its own list.
+//-----------------------------------------------------------------------------
+class CSpatialHash
+{
+public:
+	CSpatialHash(float fCellSize = 64.0f);
+
+	void SetCellSize(float fCellSize);
+	float GetCellSize() const { return m_fCellSize; }
+
+	void Clear();
+	void Insert(int layer, int id, float x, float y, float radius);
+
+	// Appends every pair of colliders from the two layers whose circles
+	// overlap, each pair once. layerA may equal layerB. Big grids are
+	// searched on the job system; the pairs come out in the same order.
+	void FindPairs(int layerA, int layerB, std::vector<CCollisionPair>& pairs);
+
+	// Appends the ids of the layer's colliders overlapping the circle.
+	void FindOverlaps(int layer, float x, float y, float radius, std::vector<int>& ids);
+
+	size_t GetColliderCount() const { return m_Colliders.size(); }
+
+private:
+	struct Collider
+	{
+		float	x, y, radius;
+		int		layer;
+		int		id;
+		int		minX, minY, maxX, maxY;	// Cells covered
+	};
+
+	struct CellEntry
+	{
+		int		cellX, cellY;
+		int		collider;
+	};
+
+	static bool Overlap(const Collider& a, const Collider& b);
+	unsigned int Bucket(int cellX, int cellY) const;
+	void Build();
+	void FindPairsInBuckets(int layerA, int layerB, size_t first, size_t last, std::vector<CCollisionPair>& pairs) const;
+
+	enum
+	{
+		PAIR_CHUNKS			= 16,		// Most pieces one FindPairs() is split into
+		PARALLEL_PAIRS_MIN	= 8192		// Fewer cell entries are not worth splitting
+	};
+
+	std::vector<Collider>		m_Colliders;
+	std::vector<CellEntry>		m_Entries;		// Sorted by bucket
+	std::vector<unsigned int>	m_BucketStart;	// Bucket i spans [start[i], start[i+1])
+	std::vector<unsigned int>	m_BucketFill;	// Build scratch, kept to avoid reallocating
+	std::vector<CCollisionPair>	m_ChunkPairs[PAIR_CHUNKS];	// FindPairs scratch
+	float						m_fCellSize;
+	float						m_fInvCellSize;
+	bool						m_bBuilt;
+};
+
+#endif // SPATIALHASH_H
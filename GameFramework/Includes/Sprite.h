@@ -4,14 +4,18 @@
 #ifndef SPRITE_H
 #define SPRITE_H
 
-#include "main.h"
+#include "Main.h"
 #include "Vec2.h"
-#include "BackBuffer.h"
+#include "WorldSnapshot.h"
+#include "AssetCache.h"
+#include <vector>
 
 class Sprite
 {
 public:
+#ifdef _WIN32
 	Sprite(int imageID, int maskID);
+#endif
 	Sprite(const char *szImageFile, const char *szMaskFile);
 	Sprite(const char *szImageFile, COLORREF crTransparentColor);
 
@@ -19,20 +23,30 @@ public:
 	virtual ~Sprite();
 
 	void setSprite(const char *szImageFile, COLORREF crTransparentColor);
-    
 
-	int width(){ return mImageBM.bmWidth; }
-	int height(){ return mImageBM.bmHeight; }
+	// Skins are alternative images preloaded up front; switching
+	// between them only swaps which cached bitmap gets drawn.
+	int addSkin(const char *szImageFile);
+	void setSkin(int iSkin);
+	int getSkin() const { return miSkin; }
+
+	int width(){ return mpImage ? mpImage->Width() : 0; }
+	int height(){ return mpImage ? mpImage->Height() : 0; }
 	void update(float dt);
 
-	void setBackBuffer(const BackBuffer *pBackBuffer);
-	virtual void draw();
+	// Adds the sprite to the frame, moving from where the previous update()
+	// left it to where it is now; the renderer draws it in between.
+	virtual void draw(CWorldSnapshot& frame);
+
+	// For owners moving the sprite themselves instead of calling update().
+	void setPrevPosition(const Vec2& prev);
 
 public:
 	// Keep these public because they need to be
 	// modified externally frequently.
 	Vec2 mPosition;
 	Vec2 mVelocity;
+	Vec2 mPrevPosition;		// Position before the last update()
 
 private:
 	// Make copy constructor and assignment operator private
@@ -43,17 +57,16 @@ private:
 	Sprite& operator=(const Sprite& rhs);
 
 protected:
-	HBITMAP mhImage;
-	HBITMAP mhMask;
-	BITMAP mImageBM;
-	BITMAP mMaskBM;
+	// Images are shared through the asset cache and carry their
+	// transparency in the alpha byte (see Blitter.h).
+	PixelImagePtr mpImage;
 
-	HDC mhSpriteDC;
-	const BackBuffer *mpBackBuffer;
+	std::vector<PixelImagePtr> mSkins;
+	int miSkin;
+	bool mbUpdated;			// mPrevPosition is valid
 
 	COLORREF mcTransparentColor;
-	void drawTransparent();
-	void drawMask();
+	void drawFrame(CWorldSnapshot& frame, int srcX, int srcY, int w, int h);
 };
 
 // AnimatedSprite
@@ -70,7 +83,7 @@ public:
 	void SetFrame(int iIndex);
 	int GetFrameCount() { return miFrameCount; }
 
-	virtual void draw();
+	virtual void draw(CWorldSnapshot& frame);
 	
 protected:
 	POINT mptFrameStartCrop;// first point of the frame (upper-left corner)
@@ -0,0 +1,55 @@
+// SpritePool.h
+// Recycled sprites for short lived entities.
+#ifndef SPRITEPOOL_H
+#define SPRITEPOOL_H
+
+#include "Sprite.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CSpritePool (Class)
+// Desc : Hands out sprites of one image from a free list. Every sprite is
+//		built up front by Reserve(); running out grows the pool by doubling
+//		it, so a pool that was sized right never allocates again. The pool
+//		owns all its sprites and must outlive anything holding them.
+//-----------------------------------------------------------------------------
+class CSpritePool
+{
+public:
+	struct Stats
+	{
+		size_t	Capacity;	// Sprites built so far
+		size_t	InUse;		// Sprites currently handed out
+		size_t	HighWater;	// Most sprites ever handed out at once
+		size_t	Grows;		// Times Acquire() had to grow the pool
+	};
+
+	CSpritePool(const char* szImageFile, COLORREF crTransparentColor);
+	~CSpritePool();
+
+	// Makes sure at least this many sprites exist.
+	void Reserve(size_t count);
+
+	// Returns a sprite at rest at the origin.
+	Sprite* Acquire();
+	void Release(Sprite* pSprite);
+
+	Stats GetStats() const;
+
+	// Size of the pooled image, 0 until the first sprite is built.
+	int GetWidth() const { return m_Sprites.empty() ? 0 : m_Sprites[0]->width(); }
+	int GetHeight() const { return m_Sprites.empty() ? 0 : m_Sprites[0]->height(); }
+
+private:
+	CSpritePool(const CSpritePool& rhs);
+	CSpritePool& operator=(const CSpritePool& rhs);
+
+	std::vector<Sprite*>	m_Sprites;		// Everything built, owned
+	std::vector<Sprite*>	m_Free;			// Free list, used as a stack
+	const char*				m_szImageFile;
+	COLORREF				m_crTransparentColor;
+	size_t					m_HighWater;
+	size_t					m_Grows;
+};
+
+#endif // SPRITEPOOL_H
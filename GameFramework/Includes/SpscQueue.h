@@ -0,0 +1,57 @@
+// SpscQueue.h
+// Lock-free, fixed size queue between one producer and one consumer thread.
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+//-----------------------------------------------------------------------------
+// Name : CSpscQueue (Template Class)
+// Desc : Ring buffer of Capacity items (a power of two). Push() is only
+//		called from the producer thread, Pop() only from the consumer; each
+//		side owns one index and only reads the other's, so no locks are
+//		needed. Nothing is allocated after construction.
+//-----------------------------------------------------------------------------
+template <typename T, size_t Capacity>
+class CSpscQueue
+{
+public:
+	CSpscQueue() : m_Head(0), m_Tail(0) {}
+
+	// Returns false, dropping the item, when the queue is full.
+	bool Push(const T& item)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if(tail - m_Head.load(std::memory_order_acquire) == Capacity)
+			return false;
+
+		m_Items[tail & (Capacity - 1)] = item;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false when there is nothing queued.
+	bool Pop(T& item)
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		if(head == m_Tail.load(std::memory_order_acquire))
+			return false;
+
+		item = m_Items[head & (Capacity - 1)];
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	CSpscQueue(const CSpscQueue& rhs);
+	CSpscQueue& operator=(const CSpscQueue& rhs);
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "CSpscQueue capacity must be a power of two");
+
+	T					m_Items[Capacity];
+	std::atomic<size_t>	m_Head;		// Next item to pop, written by the consumer
+	std::atomic<size_t>	m_Tail;		// Next slot to push, written by the producer
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,107 @@
+// TimingWheel.h
+// Hierarchical timing wheel for events in simulation ticks.
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CTimingWheel (Class)
+// Desc : Runs callbacks after a number of ticks. Time only moves when the
+//		owner calls Advance(), once per simulation step, so the same steps
+//		always fire the same events in the same order, whatever the wall
+//		clock or message queue are doing.
+//
+//		Four wheels of 256 slots cover 2^32 ticks. An event goes into the
+//		finest wheel whose range reaches it; when a coarser slot comes up its
+//		events are spread over the finer wheels, so each event moves at most
+//		three times. Events live in a pool linked into their slot, making
+//		Schedule() and Cancel() O(1) with no searching, and Advance() only
+//		touches the slots that come up.
+//-----------------------------------------------------------------------------
+class CTimingWheel
+{
+public:
+	typedef uint64_t				Handle;		// 0 is never a valid handle
+	typedef std::function<void()>	Callback;
+
+	enum
+	{
+		LEVELS		= 4,
+		SLOT_BITS	= 8,
+		SLOTS		= 1 << SLOT_BITS
+	};
+
+	static const uint64_t MAX_DELAY = ((uint64_t)1 << (LEVELS * SLOT_BITS)) - 1;
+
+	CTimingWheel();
+
+	// Runs work nDelay ticks from now (at least one, at most MAX_DELAY),
+	// then every nPeriod ticks if that is not zero. Events due on the same
+	// tick run in the order they were scheduled.
+	Handle Schedule(uint64_t nDelay, const Callback& work, uint64_t nPeriod = 0);
+
+	// Stops a pending or repeating event; safe from inside callbacks and
+	// with handles of events that are long gone. Returns false for those.
+	bool Cancel(Handle handle);
+	bool IsPending(Handle handle) const;
+
+	// Moves time on, running every event that falls due on the way.
+	void Advance(uint64_t nTicks = 1);
+
+	// Drops every event, keeping the pool.
+	void Clear();
+
+	// Clears and starts time again at zero, so a fresh run steps through
+	// the wheel exactly like the first one did. Not from inside callbacks.
+	void Reset();
+
+	uint64_t GetTime() const { return m_Now; }
+	size_t GetPendingCount() const { return m_nPending; }
+
+private:
+	enum
+	{
+		NO_NODE		= -1,
+		SLOT_FREE	= -1,	// Node is in the free list
+		SLOT_DUE	= -2,	// Node is waiting to run this tick
+		SLOT_RUNNING = -3	// Node's callback is running
+	};
+
+	struct CNode
+	{
+		Callback	Work;
+		uint64_t	Due;
+		uint64_t	Period;
+		uint32_t	Generation;		// Bumped on every reuse, stale handles don't match
+		int			Slot;			// Index into m_Slots, or one of the SLOT_ values
+		int			Prev, Next;
+	};
+
+	struct CList
+	{
+		int Head, Tail;
+	};
+
+	CNode* Find(Handle handle);
+	const CNode* Find(Handle handle) const;
+
+	int AllocNode();
+	void FreeNode(int index);
+	void Insert(int index);		// Into the slot its due time belongs in
+	void Link(CList& list, int slot, int index);
+	void Unlink(int index);
+	void Cascade(int level);
+
+	std::vector<CNode>	m_Nodes;
+	std::vector<CList>	m_Slots;	// LEVELS * SLOTS, level 0 first
+	CList				m_Due;		// Events of the current tick, in order
+	int					m_FreeList;
+	uint64_t			m_Now;
+	size_t				m_nPending;
+};
+
+#endif // TIMINGWHEEL_H
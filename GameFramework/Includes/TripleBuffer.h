@@ -0,0 +1,66 @@
+// TripleBuffer.h
+// Lock-free hand-off of whole objects from one writer thread to one reader.
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+// Name : CTripleBuffer (Template Class)
+// Desc : Three copies of T: the writer fills one, the reader holds one, and
+//		the third is the latest complete copy waiting between them. Publish()
+//		and Acquire() only swap slot indices with one atomic exchange, so
+//		neither side ever waits for the other; a reader slower than the
+//		writer simply skips the copies it never got to.
+//
+//		The slots are reused, so anything T keeps (vector capacity, ...)
+//		is only allocated while the copies warm up.
+//-----------------------------------------------------------------------------
+template <typename T>
+class CTripleBuffer
+{
+public:
+	CTripleBuffer() : m_Middle(1), m_Write(0), m_Read(2) {}
+
+	// Writer side. The slot stays the writer's until Publish().
+	T& GetWriteBuffer() { return m_Slots[m_Write]; }
+
+	// Hands the write slot to the reader and takes the stale one back.
+	void Publish()
+	{
+		unsigned int middle = m_Middle.exchange(m_Write | FRESH, std::memory_order_acq_rel);
+		m_Write = middle & INDEX_MASK;
+	}
+
+	// Reader side. Switches to the newest published copy, if there is one
+	// the reader has not seen yet; returns whether it did.
+	bool Acquire()
+	{
+		if(!(m_Middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+
+		unsigned int middle = m_Middle.exchange(m_Read, std::memory_order_acq_rel);
+		m_Read = middle & INDEX_MASK;
+		return true;
+	}
+
+	// The copy Acquire() last switched to; stays valid until the next one.
+	const T& GetReadBuffer() const { return m_Slots[m_Read]; }
+
+private:
+	CTripleBuffer(const CTripleBuffer& rhs);
+	CTripleBuffer& operator=(const CTripleBuffer& rhs);
+
+	enum
+	{
+		INDEX_MASK	= 0x03,
+		FRESH		= 0x04		// Middle slot holds a copy the reader has not seen
+	};
+
+	T							m_Slots[3];
+	std::atomic<unsigned int>	m_Middle;	// Index of the waiting slot, plus FRESH
+	unsigned int				m_Write;	// Only touched by the writer
+	unsigned int				m_Read;		// Only touched by the reader
+};
+
+#endif // TRIPLEBUFFER_H
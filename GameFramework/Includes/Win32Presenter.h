@@ -0,0 +1,52 @@
+// Win32Presenter.h
+// Presents back buffer frames to a window through GDI.
+#ifndef WIN32PRESENTER_H
+#define WIN32PRESENTER_H
+
+#include "main.h"
+#include "Presenter.h"
+
+//-----------------------------------------------------------------------------
+// Name : CWin32Presenter (Class)
+// Desc : Copies every frame to the client area of a window, scaled to fit.
+//		Only the dirty rectangles go out, unless the window changed size.
+//		PRESENT_STRETCHDIBITS sends the pixels straight from the back buffer,
+//		PRESENT_DIBSECTION stages them in a DIB section first and blits that.
+//-----------------------------------------------------------------------------
+class CWin32Presenter : public IPresenter
+{
+public:
+	enum EMode
+	{
+		PRESENT_STRETCHDIBITS,
+		PRESENT_DIBSECTION
+	};
+
+	CWin32Presenter(HWND hWnd, EMode eMode = PRESENT_STRETCHDIBITS);
+	virtual ~CWin32Presenter();
+
+	virtual void Present(const CPixelSurface& frame, const CDirtyRegion& dirty);
+
+private:
+	CWin32Presenter(const CWin32Presenter& rhs);
+	CWin32Presenter& operator=(const CWin32Presenter& rhs);
+
+	void ReleaseSection();
+	bool CreateSection(HDC hWndDC, int width, int height);
+	void PresentRect(HDC hWndDC, const CPixelSurface& frame, const CRect& rc);
+
+	HWND			m_hWnd;
+	EMode			m_eMode;
+	int				m_ClientWidth;
+	int				m_ClientHeight;
+
+	// PRESENT_DIBSECTION staging surface
+	HDC				m_hSectionDC;
+	HBITMAP			m_hSection;
+	HBITMAP			m_hOldBitmap;
+	unsigned int*	m_pSectionPixels;
+	int				m_SectionWidth;
+	int				m_SectionHeight;
+};
+
+#endif // WIN32PRESENTER_H
@@ -0,0 +1,86 @@
+// Win32Types.h
+// The few Win32 types and helpers the game objects use, for builds
+// without windows.h (the headless runner on Linux).
+#ifndef WIN32TYPES_H
+#define WIN32TYPES_H
+
+#ifndef _WIN32
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef unsigned char	BYTE, UCHAR;
+typedef unsigned short	USHORT, WORD;
+typedef unsigned int	UINT;
+typedef unsigned long	ULONG, DWORD;
+typedef long			LONG;
+typedef int				BOOL;
+typedef uint64_t		UINT64;
+typedef DWORD			COLORREF;
+
+typedef char			TCHAR;
+typedef char*			LPTSTR;
+typedef const char*		LPCTSTR;
+typedef const char*		LPCSTR;
+
+struct RECT { LONG left, top, right, bottom; };
+struct POINT { LONG x, y; };
+
+#define _T(x)			x
+#define MAX_PATH		260
+
+#define RGB(r,g,b)		((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(c)	((BYTE)(c))
+#define GetGValue(c)	((BYTE)((c) >> 8))
+#define GetBValue(c)	((BYTE)((c) >> 16))
+
+// The secure CRT's array forms, as the sources call them
+template <size_t N>
+inline int sprintf_s(char (&szBuffer)[N], const char* szFormat, ...)
+{
+	va_list args;
+	va_start(args, szFormat);
+	int result = vsnprintf(szBuffer, N, szFormat, args);
+	va_end(args);
+	return result;
+}
+#define _stprintf_s		sprintf_s
+
+// windows.h's min and max, as functions; macros would break the standard
+// headers included after this one.
+template <typename T> inline T min(T a, T b) { return b < a ? b : a; }
+template <typename T> inline T max(T a, T b) { return a < b ? b : a; }
+
+#define ZeroMemory(p, n)	memset((p), 0, (n))
+
+// Images are kept as these too, there is just nothing to draw them on.
+struct RGBQUAD { BYTE rgbBlue, rgbGreen, rgbRed, rgbReserved; };
+struct BITMAPINFOHEADER
+{
+	DWORD	biSize;
+	LONG	biWidth;
+	LONG	biHeight;
+	WORD	biPlanes;
+	WORD	biBitCount;
+	DWORD	biCompression;
+	DWORD	biSizeImage;
+	LONG	biXPelsPerMeter;
+	LONG	biYPelsPerMeter;
+	DWORD	biClrUsed;
+	DWORD	biClrImportant;
+};
+#define BI_RGB			0
+
+// Nothing to play sounds on; the headless runner is silent.
+#define SND_ASYNC		0x0001
+#define SND_FILENAME	0x00020000
+inline BOOL PlaySound(const char*, void*, DWORD) { return 0; }
+
+// There is no debugger output window; the log goes to stderr.
+inline void OutputDebugString(const char* szText) { fputs(szText, stderr); }
+
+#endif // !_WIN32
+
+#endif // WIN32TYPES_H
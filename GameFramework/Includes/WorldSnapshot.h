@@ -0,0 +1,62 @@
+// WorldSnapshot.h
+// Everything the renderer needs from one simulation step.
+#ifndef WORLDSNAPSHOT_H
+#define WORLDSNAPSHOT_H
+
+#include "BackBuffer.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Name : CDrawItem (Struct)
+// Desc : One sprite frame, with its center before and after the step.
+//		The image is not owned: sprite images stay resident in the asset
+//		cache for the whole game, so snapshots can point at them freely.
+//-----------------------------------------------------------------------------
+struct CDrawItem
+{
+	const CPixelImage*	pImage;
+	int					SrcX, SrcY, Width, Height;
+	float				PrevX, PrevY;
+	float				X, Y;
+};
+
+//-----------------------------------------------------------------------------
+// Name : CWorldSnapshot (Class)
+// Desc : What the world looked like after a simulation step: the sprites to
+//		draw, in order, plus the scroll offset and the scores for the title.
+//		The simulation records it, the renderer only reads it, so the two can
+//		run on different threads (see CTripleBuffer).
+//-----------------------------------------------------------------------------
+class CWorldSnapshot
+{
+public:
+	CWorldSnapshot();
+
+	// Empties the draw list, keeping its capacity.
+	void Clear();
+
+	void AddSprite(const CPixelImage* pImage, int srcX, int srcY, int w, int h,
+				   float prevX, float prevY, float x, float y);
+
+	// Draws every sprite fAlpha of the way from its previous position to
+	// its current one, marking what it covered on the back buffer.
+	void Draw(BackBuffer& target, float fAlpha) const;
+
+	const std::vector<CDrawItem>& Items() const { return m_Items; }
+
+public:
+	unsigned long	Step;			// Simulation steps run so far, 0 before the first
+	double			Time;			// Clock time the step stands for, in seconds
+	float			StepLength;		// Seconds per step
+	float			ScrollOffset;	// Background row on the top of the frame
+
+	int				Score, Score2;
+	int				Lives, Lives2;
+	unsigned long	LiveEntities;
+	unsigned long	FreedEntities;
+
+private:
+	std::vector<CDrawItem>	m_Items;
+};
+
+#endif // WORLDSNAPSHOT_H
@@ -0,0 +1,213 @@
+// AssetCache.cpp
+// Shared, reference counted image assets.
+#include "AssetCache.h"
+#include "Profiler.h"
+#include <fstream>
+#include <iterator>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// CPixelImage Member Functions
+//-----------------------------------------------------------------------------
+CPixelImage::CPixelImage(int width, int height)
+	: m_Width(width), m_Height(height), m_Pixels((size_t)width * height, 0)
+{
+}
+
+//-----------------------------------------------------------------------------
+// Bitmap decoding
+//-----------------------------------------------------------------------------
+namespace
+{
+	unsigned int ReadU16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+	unsigned int ReadU32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24); }
+}
+
+PixelImagePtr DecodeBitmapMemory(const unsigned char* pData, size_t size)
+{
+	const size_t FILE_HEADER_SIZE = 14;
+
+	if(!pData || size < FILE_HEADER_SIZE + 40 || pData[0] != 'B' || pData[1] != 'M')
+		return PixelImagePtr();
+
+	size_t offBits = ReadU32(pData + 10);
+	const unsigned char* pInfo = pData + FILE_HEADER_SIZE;
+	size_t infoSize = ReadU32(pInfo);
+	int width = (int)ReadU32(pInfo + 4);
+	int height = (int)ReadU32(pInfo + 8);
+	unsigned int bitCount = ReadU16(pInfo + 14);
+	unsigned int compression = ReadU32(pInfo + 16);
+	unsigned int colorsUsed = ReadU32(pInfo + 32);
+
+	// Only uncompressed (BI_RGB) images, or BI_BITFIELDS for 32 bit ones.
+	if(compression != 0 && !(compression == 3 && bitCount == 32))
+		return PixelImagePtr();
+	if(bitCount != 8 && bitCount != 24 && bitCount != 32)
+		return PixelImagePtr();
+
+	// Negative height means the rows are stored top-down.
+	bool bTopDown = height < 0;
+	if(bTopDown)
+		height = -height;
+	if(width <= 0 || height <= 0)
+		return PixelImagePtr();
+
+	size_t stride = (((size_t)width * bitCount + 31) / 32) * 4;
+	if(offBits > size || stride * height > size - offBits)
+		return PixelImagePtr();
+
+	// 8 bit images carry a palette right after the info header.
+	const unsigned char* pPalette = pInfo + infoSize;
+	if(bitCount == 8)
+	{
+		if(colorsUsed == 0 || colorsUsed > 256)
+			colorsUsed = 256;
+		if(FILE_HEADER_SIZE + infoSize + colorsUsed * 4 > offBits)
+			return PixelImagePtr();
+	}
+
+	std::shared_ptr<CPixelImage> pImage(new CPixelImage(width, height));
+
+	for(int y = 0; y < height; y++)
+	{
+		const unsigned char* src = pData + offBits + stride * (bTopDown ? y : height - 1 - y);
+		unsigned int* dst = pImage->Pixels() + (size_t)y * width;
+
+		switch(bitCount)
+		{
+		case 8:
+			for(int x = 0; x < width; x++)
+			{
+				unsigned int index = src[x];
+				dst[x] = index < colorsUsed ? (ReadU32(pPalette + index * 4) & 0x00FFFFFF) : 0;
+			}
+			break;
+
+		case 24:
+			for(int x = 0; x < width; x++, src += 3)
+				dst[x] = src[0] | (src[1] << 8) | (src[2] << 16);
+			break;
+
+		case 32:
+			memcpy(dst, src, width * sizeof(unsigned int));
+			break;
+		}
+	}
+
+	return pImage;
+}
+
+PixelImagePtr DecodeBitmapFile(const char* szFileName)
+{
+	PROFILE_ZONE("LoadAsset");
+
+	std::ifstream file(szFileName, std::ios::binary);
+	if(!file)
+		return PixelImagePtr();
+
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	return DecodeBitmapMemory(data.data(), data.size());
+}
+
+//-----------------------------------------------------------------------------
+// CAssetCache Member Functions
+//-----------------------------------------------------------------------------
+CAssetCache::CAssetCache()
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+CAssetCache::~CAssetCache()
+{
+	Clear();
+}
+
+PixelImagePtr CAssetCache::Acquire(const char* szFileName)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	AssetMap::iterator it = m_Assets.find(szFileName);
+	if(it != m_Assets.end())
+	{
+		m_Stats.Hits++;
+		return it->second;
+	}
+
+	// Decoding under the lock keeps two threads from loading the same file
+	// twice; loads only happen while the game is setting up.
+	m_Stats.Misses++;
+	PixelImagePtr pImage = DecodeBitmapFile(szFileName);
+	if(!pImage)
+	{
+		m_Stats.Failures++;
+		return pImage;
+	}
+
+	m_Assets[szFileName] = pImage;
+	m_Stats.AssetCount++;
+	m_Stats.BytesResident += pImage->SizeInBytes();
+	m_Stats.BytesLoaded += pImage->SizeInBytes();
+	return pImage;
+}
+
+PixelImagePtr CAssetCache::Find(const char* szName)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	AssetMap::iterator it = m_Assets.find(szName);
+	if(it == m_Assets.end())
+		return PixelImagePtr();
+
+	m_Stats.Hits++;
+	return it->second;
+}
+
+void CAssetCache::Insert(const char* szName, PixelImagePtr pImage)
+{
+	if(!pImage)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	PixelImagePtr& slot = m_Assets[szName];
+	if(slot)
+		m_Stats.BytesResident -= slot->SizeInBytes();
+	else
+		m_Stats.AssetCount++;
+
+	slot = pImage;
+	m_Stats.BytesResident += pImage->SizeInBytes();
+}
+
+void CAssetCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	for(AssetMap::iterator it = m_Assets.begin(); it != m_Assets.end(); )
+	{
+		if(it->second.use_count() == 1)
+		{
+			m_Stats.AssetCount--;
+			m_Stats.BytesResident -= it->second->SizeInBytes();
+			it = m_Assets.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void CAssetCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	m_Assets.clear();
+	m_Stats.AssetCount = 0;
+	m_Stats.BytesResident = 0;
+}
+
+CAssetCache::Stats CAssetCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Stats;
+}
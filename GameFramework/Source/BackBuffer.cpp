@@ -2,73 +2,101 @@
 // By Frank Luna
 // August 24, 2004.
 #include "BackBuffer.h"
+#include "Profiler.h"
+#include <algorithm>
 
 
-BackBuffer::BackBuffer(HWND hWnd, int width, int height)
+BackBuffer::BackBuffer(int width, int height, IPresenter *pPresenter)
 {
-	// Save a copy of the main window handle.
-	mhWnd = hWnd;
-
-	// Get a handle to the device context associated with
-	// the window.
-	HDC hWndDC = GetDC(hWnd);
-
 	// Save the backbuffer dimensions.
 	mWidth = width;
 	mHeight = height;
 
-	// Create system memory device context that is compatible
-	// with the window one.
-	mhDC = CreateCompatibleDC(hWndDC);
-
-	// Create the backbuffer surface bitmap that is compatible
-	// with the window device context bitmap format. That is
-	// the surface we will render onto.
-	mhSurface = CreateCompatibleBitmap(hWndDC, width, height);
+	// The surface we will render onto is plain system memory; the
+	// presenter decides how it reaches the screen (or a file).
+	mPixels.resize((size_t)width * height);
+	mpPresenter = pPresenter;
+	mPixelsPushed = 0;
 
-	// Done with window DC.
-	ReleaseDC(hWnd, hWndDC);
+	mDirty.SetBounds(width, height);
+	mDrawn.SetBounds(width, height);
+	mErase.SetBounds(width, height);
 
-	// At this point, the back buffer surface is uninitialized,
-	// so lets clear it to some non-zero value. Note that it
-	// needs to be non-zero. If it is zero then it will mess
-	// up our sprite blending logic.
-	reset();
+	// Start with a clean, fully dirty frame.
+	std::fill(mPixels.begin(), mPixels.end(), 0x00FFFFFF);
+	mDirty.AddFull();
 }
 
 void BackBuffer::reset()
 {
-	// Select the backbuffer bitmap into the DC.
-	mhOldObject = (HBITMAP)SelectObject(mhDC, mhSurface);
+	// Clear what the sprites covered last frame back to white; the rest
+	// of the frame still holds whatever was underneath them.
+	const std::vector<CRect>& rects = mErase.Rects();
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		const CRect& rc = rects[i];
+		for(int y = rc.Top; y < rc.Bottom; y++)
+			std::fill(mPixels.begin() + (size_t)y * mWidth + rc.Left,
+					  mPixels.begin() + (size_t)y * mWidth + rc.Right, 0x00FFFFFF);
+
+		mDirty.Add(rc);
+	}
+
+	mErase.Clear();
+}
+
+BackBuffer::~BackBuffer()
+{
+	delete mpPresenter;
+}
+
+CPixelSurface BackBuffer::getSurface() const
+{
+	return CPixelSurface(const_cast<unsigned int*>(mPixels.data()), mWidth, mHeight, mWidth);
+}
 
-	// Select a white brush.
-	HBRUSH white = (HBRUSH)GetStockObject(WHITE_BRUSH);
-	HBRUSH oldBrush = (HBRUSH)SelectObject(mhDC, white);
+void BackBuffer::setPresenter(IPresenter *pPresenter)
+{
+	if(pPresenter == mpPresenter)
+		return;
 
-	// Clear the backbuffer rectangle.
-	Rectangle(mhDC, 0, 0, mWidth, mHeight);
+	delete mpPresenter;
+	mpPresenter = pPresenter;
 
-	// Restore the original brush.
-	SelectObject(mhDC, oldBrush);
+	// A new presenter has not seen anything yet.
+	mDirty.AddFull();
 }
 
-BackBuffer::~BackBuffer()
+void BackBuffer::markDirty(const CRect& rc)
 {
-	SelectObject(mhDC, mhOldObject);
-	DeleteObject(mhSurface);
-	DeleteDC(mhDC);
+	mDirty.Add(rc);
 }
 
-void BackBuffer::present()
+void BackBuffer::markAllDirty()
 {
-	// Get a handle to the device context associated with
-	// the window.
-	HDC hWndDC = GetDC(mhWnd);
+	mDirty.AddFull();
+}
 
-	// Copy the backbuffer contents over to the
-	// window client area.
-	BitBlt(hWndDC, 0, 0, mWidth, mHeight, mhDC, 0, 0, SRCCOPY);
+void BackBuffer::markDrawn(const CRect& rc)
+{
+	mDirty.Add(rc);
+	mDrawn.Add(rc);
+}
 
-	// Always free window DC when done.
-	ReleaseDC(mhWnd, hWndDC);
-}
\ No newline at end of file
+void BackBuffer::present()
+{
+	PROFILE_ZONE("Present");
+
+	// Hand the changed parts of the frame over to whoever displays it.
+	mPixelsPushed = 0;
+	if(mpPresenter)
+	{
+		mpPresenter->Present(getSurface(), mDirty);
+		mPixelsPushed = mpPresenter->GetPixelsPushed();
+	}
+
+	// This frame's sprites are what the next reset() has to erase.
+	std::swap(mErase, mDrawn);
+	mDrawn.Clear();
+	mDirty.Clear();
+}
@@ -0,0 +1,78 @@
+// BackgroundLayer.cpp
+// Vertically scrolling, wrapping background image.
+#include "BackgroundLayer.h"
+#include <math.h>
+#include <string.h>
+
+CBackgroundLayer::CBackgroundLayer()
+{
+	m_fSpeed = 0.0f;
+	m_fOffset = 0.0f;
+	m_iPaintedOffset = -1;
+}
+
+void CBackgroundLayer::SetImage(PixelImagePtr pImage)
+{
+	m_pImage = pImage;
+	m_iPaintedOffset = -1;
+	SetOffset(m_fOffset);
+}
+
+void CBackgroundLayer::SetOffset(float fOffset)
+{
+	if(!m_pImage || m_pImage->Height() <= 0)
+	{
+		m_fOffset = 0.0f;
+		return;
+	}
+
+	// Keep the offset inside the image, whichever way we scroll.
+	float fHeight = (float)m_pImage->Height();
+	m_fOffset = fmodf(fOffset, fHeight);
+	if(m_fOffset < 0.0f)
+		m_fOffset += fHeight;
+	if(m_fOffset >= fHeight)
+		m_fOffset = 0.0f;
+}
+
+void CBackgroundLayer::Update(float dt)
+{
+	// Moving the picture down means showing rows further up the image.
+	SetOffset(m_fOffset - m_fSpeed * dt);
+}
+
+void CBackgroundLayer::Paint(const CPixelSurface& dst)
+{
+	Paint(dst, CRect(0, 0, dst.Width, dst.Height));
+	m_iPaintedOffset = GetOffset();
+}
+
+void CBackgroundLayer::Paint(const CPixelSurface& dst, const CRect& rc) const
+{
+	if(!m_pImage || !dst.pPixels)
+		return;
+
+	// Clip against the surface and the image width.
+	CRect clip = rc.Intersect(CRect(0, 0, dst.Width < m_pImage->Width() ? dst.Width : m_pImage->Width(), dst.Height));
+	if(clip.IsEmpty())
+		return;
+
+	int imageHeight = m_pImage->Height();
+	int srcY = (GetOffset() + clip.Top) % imageHeight;
+	size_t rowBytes = clip.Width() * sizeof(unsigned int);
+
+	// One copy per contiguous run of image rows; with an image at least
+	// as tall as the frame that is two runs at most.
+	for(int y = clip.Top; y < clip.Bottom; )
+	{
+		int run = clip.Bottom - y;
+		if(run > imageHeight - srcY)
+			run = imageHeight - srcY;
+
+		for(int row = 0; row < run; row++)
+			memcpy(dst.Row(y + row) + clip.Left, m_pImage->Row(srcY + row) + clip.Left, rowBytes);
+
+		y += run;
+		srcY = 0;
+	}
+}
@@ -0,0 +1,163 @@
+// BatchRunner.cpp
+// Many independent game sessions run side by side, for balancing.
+#include "BatchRunner.h"
+#include "InputBot.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+extern CJobSystem g_Jobs;
+
+namespace
+{
+	// Nearest rank on sorted values; p in [0, 1].
+	template <typename T>
+	T Percentile(const std::vector<T>& sorted, double p)
+	{
+		if(sorted.empty())
+			return T();
+
+		size_t rank = (size_t)(p * sorted.size());
+		return sorted[rank < sorted.size() ? rank : sorted.size() - 1];
+	}
+}
+
+bool CBatchRunner::RunSession(CGameWorld& world, const CBatchSettings& settings, unsigned long nSession, CSessionResult& result)
+{
+	PROFILE_ZONE("Session");
+
+	uint64_t seed = settings.Seed + nSession;
+
+	// Each session starts from freshly built objects, as a new game would.
+	world.Release();
+	if(!world.Build(CGameWorld::DEFAULT_VIEW_HEIGHT))
+		return false;
+	world.Setup(settings.TickRate, seed, settings.Rules);
+
+	CInputBot bot(seed);
+	float fStep = 1.0f / settings.TickRate;
+	unsigned long nMaxSteps = (unsigned long)(settings.MaxMinutes * 60.0 * settings.TickRate + 0.5);
+
+	while(!world.IsOver() && world.GetStepCount() < nMaxSteps)
+		world.Step(fStep, bot.Next());
+
+	result.Seed = seed;
+	result.Steps = world.GetStepCount();
+	result.Score = world.GetScore();
+	result.Score2 = world.GetScore2();
+	result.Lives = world.GetLives();
+	result.Lives2 = world.GetLives2();
+	result.bFinished = world.IsOver();
+	return true;
+}
+
+bool CBatchRunner::Run(const CBatchSettings& settings, std::vector<CSessionResult>& results)
+{
+	results.assign(settings.Sessions, CSessionResult());
+	std::atomic<bool> bFailed(false);
+
+	// A few runs of sessions per thread; a thread done early steals a run
+	// from a busy one. Every run gets a world of its own.
+	g_Jobs.ParallelFor(0, settings.Sessions, 1, [&](size_t first, size_t last)
+	{
+		CGameWorld world;
+		for(size_t i = first; i < last && !bFailed.load(std::memory_order_relaxed); i++)
+		{
+			if(!RunSession(world, settings, (unsigned long)i, results[i]))
+				bFailed = true;
+		}
+	});
+
+	return !bFailed;
+}
+
+CBatchSummary CBatchRunner::Summarize(const CBatchSettings& settings, const std::vector<CSessionResult>& results)
+{
+	CBatchSummary summary;
+	memset(&summary, 0, sizeof(summary));
+	summary.Sessions = (unsigned long)results.size();
+
+	std::vector<double> lengths;
+	std::vector<int> scores;
+	unsigned long nFish = 0, nShark = 0;
+	double fScoreTotal = 0.0;
+
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const CSessionResult& result = results[i];
+
+		int sessionScores[2] = { result.Score, result.Score2 };
+		for(int p = 0; p < 2; p++)
+		{
+			scores.push_back(sessionScores[p]);
+			fScoreTotal += sessionScores[p];
+			if(sessionScores[p] >= settings.Rules.FishScore) nFish++;
+			if(sessionScores[p] >= settings.Rules.SharkScore) nShark++;
+		}
+
+		if(!result.bFinished)
+			continue;
+
+		summary.Finished++;
+		lengths.push_back(result.Steps / settings.TickRate / 60.0);
+		if(result.Lives > result.Lives2) summary.Wins++;
+		else if(result.Lives2 > result.Lives) summary.Wins2++;
+		else summary.Draws++;
+	}
+
+	std::sort(lengths.begin(), lengths.end());
+	std::sort(scores.begin(), scores.end());
+
+	for(size_t i = 0; i < lengths.size(); i++)
+		summary.LengthMean += lengths[i];
+	if(!lengths.empty())
+		summary.LengthMean /= lengths.size();
+	summary.LengthP10 = Percentile(lengths, 0.10);
+	summary.LengthP50 = Percentile(lengths, 0.50);
+	summary.LengthP90 = Percentile(lengths, 0.90);
+
+	if(!scores.empty())
+	{
+		summary.ScoreMean = fScoreTotal / scores.size();
+		summary.ScoreMax = scores.back();
+		summary.FishRate = (double)nFish / scores.size();
+		summary.SharkRate = (double)nShark / scores.size();
+	}
+	summary.ScoreP50 = Percentile(scores, 0.50);
+	summary.ScoreP90 = Percentile(scores, 0.90);
+
+	return summary;
+}
+
+void CBatchRunner::PrintSummary(FILE* pFile, const CBatchSettings& settings, const CBatchSummary& summary)
+{
+	fprintf(pFile, "Rules: crates every %u ms, coins every %u ms, fish at %d, shark at %d\n",
+		settings.Rules.CrateInterval, settings.Rules.CoinInterval, settings.Rules.FishScore, settings.Rules.SharkScore);
+	fprintf(pFile, "Sessions: %lu, %lu finished, %lu called off after %.1f minutes\n",
+		summary.Sessions, summary.Finished, summary.Sessions - summary.Finished, settings.MaxMinutes);
+	fprintf(pFile, "Game length: mean %.2f min, p10 %.2f, p50 %.2f, p90 %.2f\n",
+		summary.LengthMean, summary.LengthP10, summary.LengthP50, summary.LengthP90);
+	fprintf(pFile, "Wins: player 1 %lu, player 2 %lu, draws %lu\n", summary.Wins, summary.Wins2, summary.Draws);
+	fprintf(pFile, "Score: mean %.0f, p50 %d, p90 %d, max %d\n", summary.ScoreMean, summary.ScoreP50, summary.ScoreP90, summary.ScoreMax);
+	fprintf(pFile, "Upgrades: %.1f%% of players reach fish, %.1f%% reach shark\n", summary.FishRate * 100.0, summary.SharkRate * 100.0);
+}
+
+bool CBatchRunner::SaveResults(const char* szFileName, const CBatchSettings& settings, const std::vector<CSessionResult>& results)
+{
+	FILE* pFile = fopen(szFileName, "w");
+	if(!pFile)
+		return false;
+
+	fprintf(pFile, "seed,steps,minutes,finished,score,score2,lives,lives2\n");
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const CSessionResult& result = results[i];
+		fprintf(pFile, "%llu,%lu,%.3f,%d,%d,%d,%d,%d\n", (unsigned long long)result.Seed, result.Steps,
+			result.Steps / settings.TickRate / 60.0, result.bFinished ? 1 : 0,
+			result.Score, result.Score2, result.Lives, result.Lives2);
+	}
+
+	return fclose(pFile) == 0;
+}
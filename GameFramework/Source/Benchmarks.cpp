@@ -0,0 +1,1291 @@
+// Benchmarks.cpp
+// Headless timings of the engine's hot paths, with checks that the fast
+// paths still give the results of the plain ones.
+#include "Benchmarks.h"
+#include "Blitter.h"
+#include "BackgroundLayer.h"
+#include "BatchRunner.h"
+#include "EntityList.h"
+#include "FramePacer.h"
+#include "GameWorld.h"
+#include "InputBot.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "ResizeEngine.h"
+#include "SpatialHash.h"
+#include "SpritePool.h"
+#include "TripleBuffer.h"
+#include "WorldSnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+extern CJobSystem g_Jobs;
+
+namespace
+{
+	double ClockSeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// FNV-1a, to tell two results apart.
+	uint64_t HashBytes(const void* pData, size_t length, uint64_t hash = 14695981039346656037ULL)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for(size_t i = 0; i < length; i++)
+			hash = (hash ^ pBytes[i]) * 1099511628211ULL;
+		return hash;
+	}
+
+	// Small deterministic generator, so every path sees the same scene.
+	struct CBenchRandom
+	{
+		uint32_t State;
+
+		explicit CBenchRandom(uint32_t seed) : State(seed) {}
+
+		uint32_t Next() { State = State * 1664525u + 1013904223u; return State >> 8; }
+		int Below(int n) { return (int)(Next() % (uint32_t)n); }
+	};
+
+	bool ReadFile(const char* szFileName, std::vector<unsigned char>& data)
+	{
+		FILE* pFile = fopen(szFileName, "rb");
+		if(!pFile)
+			return false;
+
+		unsigned char buffer[65536];
+		size_t length;
+		data.clear();
+		while((length = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+			data.insert(data.end(), buffer, buffer + length);
+		fclose(pFile);
+		return !data.empty();
+	}
+
+	// The visible rows of a wrapping image, copied the plain way.
+	void CopyWrapped(const CPixelSurface& dst, const CPixelImage& image, int offset)
+	{
+		int width = dst.Width < image.Width() ? dst.Width : image.Width();
+		for(int y = 0; y < dst.Height; y++)
+			memcpy(dst.Row(y), image.Row((offset + y) % image.Height()), width * sizeof(unsigned int));
+	}
+
+	// A pair with its ids in order, for comparing pair lists of one layer
+	// whichever way round they came out.
+	std::pair<int, int> SortedPair(const CCollisionPair& pair, bool bSameLayer)
+	{
+		if(bSameLayer && pair.B < pair.A)
+			return std::make_pair(pair.B, pair.A);
+		return std::make_pair(pair.A, pair.B);
+	}
+
+	// Start and end of some work on the steady clock
+	struct CBusySpan
+	{
+		double Start, End;
+	};
+
+	// Time two threads were busy at once, given what each was doing in
+	// time order; also counts the spans of the second that overlapped any
+	// span of the first.
+	double OverlapTime(const std::vector<CBusySpan>& first, const std::vector<CBusySpan>& second, unsigned long& nOverlapped)
+	{
+		double fTotal = 0.0;
+		size_t i = 0;
+		nOverlapped = 0;
+		for(size_t j = 0; j < second.size(); j++)
+		{
+			while(i < first.size() && first[i].End <= second[j].Start)
+				i++;
+
+			bool bOverlapped = false;
+			for(size_t k = i; k < first.size() && first[k].Start < second[j].End; k++)
+			{
+				double fFrom = std::max(first[k].Start, second[j].Start);
+				double fTo = std::min(first[k].End, second[j].End);
+				if(fTo > fFrom)
+				{
+					fTotal += fTo - fFrom;
+					bOverlapped = true;
+				}
+			}
+			if(bOverlapped)
+				nOverlapped++;
+		}
+		return fTotal;
+	}
+
+	bool SameResults(const std::vector<CSessionResult>& a, const std::vector<CSessionResult>& b)
+	{
+		if(a.size() != b.size())
+			return false;
+
+		for(size_t i = 0; i < a.size(); i++)
+		{
+			if(a[i].Seed != b[i].Seed || a[i].Steps != b[i].Steps || a[i].Score != b[i].Score ||
+			   a[i].Score2 != b[i].Score2 || a[i].Lives != b[i].Lives || a[i].Lives2 != b[i].Lives2 ||
+			   a[i].bFinished != b[i].bFinished)
+				return false;
+		}
+		return true;
+	}
+
+	uint64_t HashPixels(const CImageFile& image)
+	{
+		return HashBytes(image.GetPixels(), (size_t)image.Width() * image.Height() * sizeof(RGBQUAD));
+	}
+
+	// Something with detail everywhere, so no kernel gets an easy ride.
+	void FillResizeImage(CResizableImage& image, LONG nWidth, LONG nHeight)
+	{
+		image.Create(nWidth, nHeight);
+		RGBQUAD* pPixel = image.GetPixels();
+		for(LONG y = 0; y < nHeight; y++)
+		{
+			for(LONG x = 0; x < nWidth; x++, pPixel++)
+			{
+				pPixel->rgbRed = (BYTE)(x * 255 / nWidth);
+				pPixel->rgbGreen = (BYTE)(y * 255 / nHeight);
+				pPixel->rgbBlue = (BYTE)((x ^ y) * 7);
+				pPixel->rgbReserved = 0;
+			}
+		}
+	}
+
+	// One pass of the resize in double precision, along rows or columns:
+	// the table's windows, but weights straight from the filter, normalized
+	// and never rounded, and sums rounded to bytes only at the end.
+	void ReferencePass(const std::vector<RGBQUAD>& src, int srcWidth, int srcHeight, std::vector<RGBQUAD>& dst,
+					   int dstSize, bool bRows, CGenericFilter* pFilter)
+	{
+		int srcSize = bRows ? srcWidth : srcHeight;
+		int lines = bRows ? srcHeight : srcWidth;
+		int dstWidth = bRows ? dstSize : srcWidth;
+		WeightsTablePtr pTable = GetWeightsCache().Acquire(pFilter, dstSize, srcSize);
+
+		double dScale = (double)dstSize / srcSize;
+		double dFScale = dScale < 1.0 ? dScale : 1.0;
+		std::vector<double> weights;
+		dst.resize((size_t)dstWidth * (bRows ? srcHeight : dstSize));
+
+		for(int u = 0; u < dstSize; u++)
+		{
+			int iLeft = pTable->getLeftBoundary(u);
+			int iTaps = pTable->getRightBoundary(u) - iLeft + 1;
+			weights.resize(iTaps);
+			pFilter->Sample(u / dScale, dFScale, iLeft, iTaps, &weights[0]);
+
+			double dTotal = 0.0;
+			for(int i = 0; i < iTaps; i++)
+				dTotal += weights[i] *= dFScale;
+			for(int i = 0; i < iTaps && dTotal > 0.0; i++)
+				weights[i] /= dTotal;
+
+			for(int line = 0; line < lines; line++)
+			{
+				double r = 0.0, g = 0.0, b = 0.0;
+				for(int i = 0; i < iTaps; i++)
+				{
+					const RGBQUAD& tap = bRows ? src[(size_t)line * srcWidth + iLeft + i] : src[(size_t)(iLeft + i) * srcWidth + line];
+					r += weights[i] * tap.rgbRed;
+					g += weights[i] * tap.rgbGreen;
+					b += weights[i] * tap.rgbBlue;
+				}
+
+				RGBQUAD& out = bRows ? dst[(size_t)line * dstWidth + u] : dst[(size_t)u * dstWidth + line];
+				out.rgbRed = (BYTE)std::min(std::max(floor(r + 0.5), 0.0), 255.0);
+				out.rgbGreen = (BYTE)std::min(std::max(floor(g + 0.5), 0.0), 255.0);
+				out.rgbBlue = (BYTE)std::min(std::max(floor(b + 0.5), 0.0), 255.0);
+				out.rgbReserved = 0;
+			}
+		}
+	}
+
+	// The whole resize as ReferencePass does it, in the order Resample
+	// picks, so both round the same intermediate image.
+	void ReferenceResample(const CImageFile& source, CGenericFilter* pFilter, int dstWidth, int dstHeight, std::vector<RGBQUAD>& dst)
+	{
+		int srcWidth = source.Width(), srcHeight = source.Height();
+		std::vector<RGBQUAD> src(source.GetPixels(), source.GetPixels() + (size_t)srcWidth * srcHeight), between;
+
+		if((long long)dstWidth * srcHeight <= (long long)dstHeight * srcWidth)
+		{
+			ReferencePass(src, srcWidth, srcHeight, between, dstWidth, true, pFilter);
+			ReferencePass(between, dstWidth, srcHeight, dst, dstHeight, false, pFilter);
+		}
+		else
+		{
+			ReferencePass(src, srcWidth, srcHeight, between, dstHeight, false, pFilter);
+			ReferencePass(between, srcWidth, dstHeight, dst, dstWidth, true, pFilter);
+		}
+	}
+
+	// The vertical pass as it ran before it blended whole rows: a column at
+	// a time, every pixel gathering its taps a source row apart. Same
+	// weights and rounding, so the pixels match ResampleVertical's.
+	void ColumnWalk(RGBQUAD* pDst, const RGBQUAD* pSrc, unsigned int width, const CWeightsTable& weights, unsigned int dstHeight)
+	{
+		for(unsigned int x = 0; x < width; x++)
+		{
+			for(unsigned int u = 0; u < dstHeight; u++)
+			{
+				int iLeft = weights.getLeftBoundary(u);
+				int iTaps = weights.getRightBoundary(u) - iLeft + 1;
+				const short* pWeights = weights.getFixedWeights(u);
+				const RGBQUAD* pTap = pSrc + (size_t)iLeft * width + x;
+
+				int r = RESIZE_WEIGHT_ONE / 2, g = RESIZE_WEIGHT_ONE / 2, b = RESIZE_WEIGHT_ONE / 2;
+				for(int i = 0; i < iTaps; i++, pTap += width)
+				{
+					r += pWeights[i] * pTap->rgbRed;
+					g += pWeights[i] * pTap->rgbGreen;
+					b += pWeights[i] * pTap->rgbBlue;
+				}
+
+				RGBQUAD& out = pDst[(size_t)u * width + x];
+				out.rgbRed = (BYTE)std::min(std::max(r >> RESIZE_WEIGHT_BITS, 0), 255);
+				out.rgbGreen = (BYTE)std::min(std::max(g >> RESIZE_WEIGHT_BITS, 0), 255);
+				out.rgbBlue = (BYTE)std::min(std::max(b >> RESIZE_WEIGHT_BITS, 0), 255);
+				out.rgbReserved = 0;
+			}
+		}
+	}
+
+	// Lanczos3 from sin directly, as it was before the kernel read a table.
+	class CExactLanczos3Filter : public CGenericFilter
+	{
+	public:
+		CExactLanczos3Filter() : CGenericFilter(CLanczos3Kernel::Width()) {}
+
+		double Filter(double dVal) { return CLanczos3Kernel::Exact(dVal); }
+	};
+
+	// Bicubic that notes whether one thread ever samples it, to tell which
+	// thread built a resize's tables (and so ran the resize).
+	class CWatchedFilter : public CBicubicFilter
+	{
+	public:
+		std::thread::id		Watched;
+		std::atomic<bool>	bSampled;
+
+		CWatchedFilter() : bSampled(false) {}
+
+		void Sample(double dCenter, double dScale, int iFirst, int nTaps, double* pOut)
+		{
+			if(std::this_thread::get_id() == Watched)
+				bSampled = true;
+			CBicubicFilter::Sample(dCenter, dScale, iFirst, nTaps, pOut);
+		}
+	};
+
+	// Client area of the game's 800x600 window.
+	const int VIEW_WIDTH = 784;
+
+	//-------------------------------------------------------------------------
+	// The game's frame drawing (CGameApp::DrawObjects) on a back buffer of
+	// its own, presenting to nowhere.
+	//-------------------------------------------------------------------------
+	class CBenchRenderer
+	{
+	public:
+		CBenchRenderer() : m_BackBuffer(VIEW_WIDTH, CGameWorld::DEFAULT_VIEW_HEIGHT, new CNullPresenter) {}
+
+		void SetBackground(const CBackgroundLayer& scroll)
+		{
+			m_Background.SetImage(scroll.GetImage());
+			m_Background.SetOffset((float)scroll.GetOffset());
+		}
+
+		void Draw(const CWorldSnapshot& frame, float fAlpha)
+		{
+			m_BackBuffer.reset();
+
+			CPixelSurface surface = m_BackBuffer.getSurface();
+			m_Background.SetOffset(frame.ScrollOffset);
+			if(m_Background.HasMoved())
+			{
+				m_Background.Paint(surface);
+				m_BackBuffer.markAllDirty();
+			}
+			else
+			{
+				const std::vector<CRect>& rects = m_BackBuffer.getDirtyRegion().Rects();
+				for(size_t i = 0; i < rects.size(); i++)
+					m_Background.Paint(surface, rects[i]);
+			}
+
+			frame.Draw(m_BackBuffer, fAlpha);
+			m_BackBuffer.present();
+		}
+
+		unsigned long GetPixelsPushed() const { return m_BackBuffer.getPixelsPushed(); }
+		CPixelSurface GetSurface() const { return m_BackBuffer.getSurface(); }
+
+	private:
+		BackBuffer			m_BackBuffer;
+		CBackgroundLayer	m_Background;
+	};
+}
+
+bool CBenchmarks::RunBlit()
+{
+	static const int SURFACE_WIDTH = 1024, SURFACE_HEIGHT = 768;
+	static const int SIZES[] = { 8, 16, 32, 64, 128, 256 };
+	static const int PIXELS_PER_RUN = 32 << 20;		// Blits per size are scaled to this
+	static const int RUNS = 3;
+	const int nSizes = sizeof(SIZES) / sizeof(SIZES[0]);
+
+	struct { EBlitPath Path; const char* szName; } paths[] =
+	{
+		{ BLIT_SCALAR, "scalar" }, { BLIT_SSE2, "SSE2" }, { BLIT_AVX2, "AVX2" }
+	};
+	const int nPaths = sizeof(paths) / sizeof(paths[0]);
+
+	std::vector<unsigned int> pixels((size_t)SURFACE_WIDTH * SURFACE_HEIGHT);
+	CPixelSurface surface(&pixels[0], SURFACE_WIDTH, SURFACE_HEIGHT, SURFACE_WIDTH);
+
+	// Sprites with a transparent border and holes, a quarter of them
+	// clear, like the game's keyed art.
+	std::vector<PixelImagePtr> sprites;
+	for(int s = 0; s < nSizes; s++)
+	{
+		int size = SIZES[s];
+		CPixelImage image(size, size);
+		for(int y = 0; y < size; y++)
+		{
+			for(int x = 0; x < size; x++)
+			{
+				bool bEdge = x < size / 8 || y < size / 8 || x >= size - size / 8 || y >= size - size / 8;
+				unsigned int color = bEdge || ((x ^ y) & 7) == 0 ? 0xFF00FF : (x * 2654435761u + y * 40503u) & 0xFFFFFF;
+				image.Pixels()[y * size + x] = color;
+			}
+		}
+		sprites.push_back(BuildColorKeyImage(image, 0xFF00FF));
+	}
+
+	EBlitPath best = GetBlitPath();
+	printf("Blit: keyed sprites onto %dx%d, sprites/ms, best of %d\n", SURFACE_WIDTH, SURFACE_HEIGHT, RUNS);
+	printf("  %-7s", "path");
+	for(int s = 0; s < nSizes; s++)
+	{
+		char szSize[16];
+		snprintf(szSize, sizeof(szSize), "%dx%d", SIZES[s], SIZES[s]);
+		printf("  %9s", szSize);
+	}
+	printf("\n");
+
+	bool bSame = true;
+	uint64_t reference = 0;
+	for(int p = 0; p < nPaths; p++)
+	{
+		SetBlitPath(paths[p].Path);
+		if(GetBlitPath() != paths[p].Path)
+		{
+			printf("  %-7s  not supported on this CPU\n", paths[p].szName);
+			continue;
+		}
+
+		printf("  %-7s", paths[p].szName);
+		uint64_t hash = 14695981039346656037ULL;
+		for(int s = 0; s < nSizes; s++)
+		{
+			int size = SIZES[s];
+			int nBlits = PIXELS_PER_RUN / (size * size);
+			const CPixelImage& sprite = *sprites[s];
+
+			double fBest = 0.0;
+			for(int r = 0; r < RUNS; r++)
+			{
+				std::fill(pixels.begin(), pixels.end(), 0x203040u);
+
+				// Positions reach past every edge, so clipping is timed too.
+				CBenchRandom random(size);
+				double fStart = ClockSeconds();
+				for(int i = 0; i < nBlits; i++)
+				{
+					int x = random.Below(SURFACE_WIDTH + size) - size / 2;
+					int y = random.Below(SURFACE_HEIGHT + size) - size / 2;
+					BlitKeyed(surface, x, y, sprite);
+				}
+				double fTime = ClockSeconds() - fStart;
+				if(r == 0 || fTime < fBest)
+					fBest = fTime;
+			}
+
+			hash = HashBytes(&pixels[0], pixels.size() * sizeof(unsigned int), hash);
+			printf("  %9.0f", nBlits / (fBest * 1e3));
+		}
+		printf("\n");
+		fflush(stdout);
+
+		if(p == 0)
+			reference = hash;
+		else if(hash != reference)
+			bSame = false;
+	}
+	SetBlitPath(best);
+
+	printf("Pixels %s on every path\n", bSame ? "identical" : "DIFFER");
+	return bSame;
+}
+
+bool CBenchmarks::RunRender(unsigned long nFrames, uint64_t seed)
+{
+	const float fTickRate = 120.0f;
+	if(nFrames == 0)
+		nFrames = 1;
+
+	CGameWorld world;
+	if(!world.Build(CGameWorld::DEFAULT_VIEW_HEIGHT))
+	{
+		fprintf(stderr, "Could not load the game assets; run from the directory holding data/\n");
+		return false;
+	}
+	world.Setup(fTickRate, seed);
+
+	CBenchRenderer renderer;
+	renderer.SetBackground(world.GetScroll());
+
+	CInputBot bot(seed);
+	CWorldSnapshot frame;
+	unsigned long long nSprites = 0, nPixels = 0;
+	double fStepTime = 0.0, fDrawTime = 0.0, fWorst = 0.0;
+	unsigned long nGames = 1;
+
+	printf("Render: %lu frames of %dx%d, one per step at %.0f steps/s, seed %llu\n",
+		nFrames, VIEW_WIDTH, (int)CGameWorld::DEFAULT_VIEW_HEIGHT, fTickRate, (unsigned long long)seed);
+	fflush(stdout);
+
+	for(unsigned long n = 0; n < nFrames; n++)
+	{
+		double fStart = ClockSeconds();
+		world.Step(1.0f / fTickRate, bot.Next());
+		if(world.IsOver())
+		{
+			world.Release();
+			if(!world.Build(CGameWorld::DEFAULT_VIEW_HEIGHT))
+				return false;
+			world.Setup(fTickRate, seed + nGames++);
+		}
+
+		frame.Clear();
+		world.Record(frame);
+		double fRecorded = ClockSeconds();
+
+		// Halfway between steps, as a display faster than the tick would be
+		renderer.Draw(frame, 0.5f);
+		double fDrawn = ClockSeconds();
+
+		fStepTime += fRecorded - fStart;
+		fDrawTime += fDrawn - fRecorded;
+		if(fDrawn - fRecorded > fWorst)
+			fWorst = fDrawn - fRecorded;
+		nSprites += frame.Items().size();
+		nPixels += renderer.GetPixelsPushed();
+	}
+
+	double fFramePixels = (double)VIEW_WIDTH * CGameWorld::DEFAULT_VIEW_HEIGHT;
+	printf("  draw:   %8.3f ms a frame on average, %.3f ms worst, %.0f frames/s\n",
+		fDrawTime * 1e3 / nFrames, fWorst * 1e3, nFrames / fDrawTime);
+	printf("  step:   %8.3f ms a step, with recording the snapshot\n", fStepTime * 1e3 / nFrames);
+	printf("  frames: %.1f sprites, %.0f%% of the pixels presented on average, %lu games\n",
+		(double)nSprites / nFrames, nPixels * 100.0 / (fFramePixels * nFrames), nGames);
+
+	world.Release();
+	return true;
+}
+
+bool CBenchmarks::RunScroll(unsigned long nFrames)
+{
+	const char* szFileName = "data/scrollingbg.bmp";
+	const int frameHeight = CGameWorld::DEFAULT_VIEW_HEIGHT;
+	if(nFrames == 0)
+		nFrames = 1;
+
+	std::vector<unsigned char> file;
+	PixelImagePtr pImage;
+	if(!ReadFile(szFileName, file) || !(pImage = DecodeBitmapMemory(&file[0], file.size())))
+	{
+		fprintf(stderr, "Could not load %s; run from the directory holding data/\n", szFileName);
+		return false;
+	}
+
+	std::vector<unsigned int> pixels((size_t)VIEW_WIDTH * frameHeight);
+	CPixelSurface surface(&pixels[0], VIEW_WIDTH, frameHeight, VIEW_WIDTH);
+	CPixelImage staging(pImage->Width(), pImage->Height());
+
+	// One row a frame, the game's 60 px/s at 60 frames/s, from the bottom
+	// of the image up and around.
+	int start = pImage->Height() - frameHeight;
+	enum { SCROLL_RELOAD, SCROLL_FULL_COPY, SCROLL_RESIDENT, SCROLL_PATHS };
+	const char* names[SCROLL_PATHS] =
+	{
+		"decode the file every frame", "copy the whole image every frame", "resident wrapping layer"
+	};
+
+	printf("Scroll: %lu frames of %dx%d from a %dx%d background, one row a frame\n",
+		nFrames, VIEW_WIDTH, frameHeight, pImage->Width(), pImage->Height());
+
+	double times[SCROLL_PATHS];
+	uint64_t hashes[SCROLL_PATHS];
+	for(int path = 0; path < SCROLL_PATHS; path++)
+	{
+		CBackgroundLayer layer;
+		layer.SetImage(pImage);
+
+		uint64_t hash = 14695981039346656037ULL;
+		double fStart = ClockSeconds();
+		for(unsigned long n = 0; n < nFrames; n++)
+		{
+			int offset = (int)((start + pImage->Height() - (long)(n % pImage->Height())) % pImage->Height());
+			switch(path)
+			{
+			case SCROLL_RELOAD:
+				{
+					PixelImagePtr pReloaded = DecodeBitmapMemory(&file[0], file.size());
+					CopyWrapped(surface, *pReloaded, offset);
+				}
+				break;
+
+			case SCROLL_FULL_COPY:
+				memcpy(staging.Pixels(), pImage->Pixels(), pImage->SizeInBytes());
+				CopyWrapped(surface, staging, offset);
+				break;
+
+			default:
+				layer.SetOffset((float)offset);
+				layer.Paint(surface);
+				break;
+			}
+
+			// Only the last rows; hashing whole frames would swamp the copies.
+			hash = HashBytes(surface.Row(frameHeight - 1), VIEW_WIDTH * sizeof(unsigned int), hash);
+		}
+		times[path] = ClockSeconds() - fStart;
+		hashes[path] = hash;
+
+		printf("  %-33s %8.1f us a frame  %5.2fx\n", names[path], times[path] * 1e6 / nFrames, times[0] / times[path]);
+		fflush(stdout);
+	}
+
+	// The layer against the plain copy, whole frames, at offsets either
+	// side of the seam.
+	bool bSame = hashes[SCROLL_RESIDENT] == hashes[SCROLL_RELOAD] && hashes[SCROLL_FULL_COPY] == hashes[SCROLL_RELOAD];
+	std::vector<unsigned int> expected(pixels.size());
+	CPixelSurface reference(&expected[0], VIEW_WIDTH, frameHeight, VIEW_WIDTH);
+	CBackgroundLayer layer;
+	layer.SetImage(pImage);
+	for(int offset = 0; offset < pImage->Height() && bSame; offset += 7)
+	{
+		layer.SetOffset((float)offset);
+		layer.Paint(surface);
+		CopyWrapped(reference, *pImage, offset);
+		bSame = memcmp(&pixels[0], &expected[0], pixels.size() * sizeof(unsigned int)) == 0;
+	}
+
+	printf("Frames %s on every path\n", bSame ? "identical" : "DIFFER");
+	return bSame;
+}
+
+bool CBenchmarks::RunBroadphase(unsigned long nColliders)
+{
+	static const float WORLD_SIZE = 4000.0f;
+	static const int FRAMES = 5;
+
+	struct CBody { float x, y, vx, vy, radius; int layer; };
+	std::vector<CBody> bodies(nColliders);
+
+	// Mostly small, some big enough to cover several cells, a third of them
+	// on the second layer; the world straddles the origin.
+	CBenchRandom random(7);
+	for(size_t i = 0; i < bodies.size(); i++)
+	{
+		CBody& body = bodies[i];
+		body.x = random.Below(4000) * (WORLD_SIZE / 4000) - WORLD_SIZE / 2;
+		body.y = random.Below(4000) * (WORLD_SIZE / 4000) - WORLD_SIZE / 2;
+		body.vx = (float)(random.Below(41) - 20);
+		body.vy = (float)(random.Below(41) - 20);
+		body.radius = random.Below(50) == 0 ? 64.0f + random.Below(192) : 2.0f + random.Below(30);
+		body.layer = random.Below(3) == 0 ? 1 : 0;
+	}
+
+	printf("Broadphase: %lu circles over %.0fx%.0f, %d frames, checked against every pair\n",
+		nColliders, WORLD_SIZE, WORLD_SIZE, FRAMES);
+	printf("  %5s  %-9s  %9s  %10s  %10s\n", "frame", "layers", "pairs", "hash ms", "brute ms");
+
+	CSpatialHash hash(64.0f);
+	std::vector<CCollisionPair> pairs;
+	std::vector<std::pair<int, int> > found, expected;
+	bool bSame = true;
+	for(int frame = 0; frame < FRAMES; frame++)
+	{
+		static const int LAYERS[][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 } };
+		for(int l = 0; l < 3; l++)
+		{
+			int layerA = LAYERS[l][0], layerB = LAYERS[l][1];
+			bool bSameLayer = layerA == layerB;
+
+			double fStart = ClockSeconds();
+			hash.Clear();
+			for(size_t i = 0; i < bodies.size(); i++)
+				hash.Insert(bodies[i].layer, (int)i, bodies[i].x, bodies[i].y, bodies[i].radius);
+			pairs.clear();
+			hash.FindPairs(layerA, layerB, pairs);
+			double fHash = ClockSeconds() - fStart;
+
+			// Every pair of the two layers, with the hash's own circle test.
+			fStart = ClockSeconds();
+			expected.clear();
+			for(size_t a = 0; a < bodies.size(); a++)
+			{
+				if(bodies[a].layer != layerA)
+					continue;
+				for(size_t b = bSameLayer ? a + 1 : 0; b < bodies.size(); b++)
+				{
+					if(bodies[b].layer != layerB)
+						continue;
+
+					float dx = bodies[a].x - bodies[b].x;
+					float dy = bodies[a].y - bodies[b].y;
+					float r = bodies[a].radius + bodies[b].radius;
+					if(dx * dx + dy * dy <= r * r)
+						expected.push_back(std::make_pair((int)a, (int)b));
+				}
+			}
+			double fBrute = ClockSeconds() - fStart;
+
+			// Same set, and no pair twice.
+			found.clear();
+			for(size_t i = 0; i < pairs.size(); i++)
+				found.push_back(SortedPair(pairs[i], bSameLayer));
+			std::sort(found.begin(), found.end());
+			std::sort(expected.begin(), expected.end());
+			bool bMatch = found == expected;
+			bSame = bSame && bMatch;
+
+			printf("  %5d  %d with %d     %9lu  %10.2f  %10.2f%s\n", frame, layerA, layerB,
+				(unsigned long)pairs.size(), fHash * 1e3, fBrute * 1e3, bMatch ? "" : "  MISMATCH");
+			fflush(stdout);
+		}
+
+		// A second's worth of movement between frames
+		for(size_t i = 0; i < bodies.size(); i++)
+		{
+			bodies[i].x += bodies[i].vx;
+			bodies[i].y += bodies[i].vy;
+		}
+	}
+
+	printf("Pairs %s the brute force ones\n", bSame ? "match" : "DIFFER from");
+	return bSame;
+}
+
+bool CBenchmarks::RunEntities(unsigned long nEntities)
+{
+	static const int FRAMES = 200;
+	static const float STEP = 1.0f / 120.0f;
+	static const float MIN_Y = -1.0e6f, MAX_Y = 1.0e6f;	// Nobody leaves, so both keep every entity
+	if(nEntities == 0)
+		nEntities = 1;
+
+	// One pool for both sides; the old loop gets the first half.
+	CSpritePool pool("data/bullet.bmp", RGB(0xff, 0x00, 0xff));
+	pool.Reserve(2 * (size_t)nEntities);
+	if(pool.GetWidth() == 0)
+	{
+		fprintf(stderr, "Could not load data/bullet.bmp; run from the directory holding data/\n");
+		return false;
+	}
+
+	std::vector<Sprite*> sprites(nEntities);
+	CEntityList list;
+	list.SetPool(&pool);
+	list.Reserve(nEntities);
+
+	CBenchRandom random(10);
+	for(unsigned long i = 0; i < nEntities; i++)
+	{
+		float x = (float)random.Below(800), y = (float)random.Below(600);
+		float vx = (float)(random.Below(201) - 100), vy = (float)(random.Below(2001) - 1000);
+
+		sprites[i] = pool.Acquire();
+		sprites[i]->mPosition = Vec2(x, y);
+		sprites[i]->mVelocity = Vec2(vx, vy);
+		list.Add(pool.Acquire(), x, y, vx, vy);
+	}
+
+	printf("Entities: %lu moving sprites, %d steps of %.4f s, %lu threads\n",
+		nEntities, FRAMES, STEP, (unsigned long)g_Jobs.GetThreadCount());
+
+	// What every owner did per frame before the arrays: update each sprite
+	// through its pointer, then test where it went.
+	std::vector<size_t> kills;
+	double fStart = ClockSeconds();
+	for(int frame = 0; frame < FRAMES; frame++)
+	{
+		for(size_t i = 0; i < sprites.size(); i++)
+		{
+			Sprite* pSprite = sprites[i];
+			pSprite->update(STEP);
+			if(pSprite->mPosition.y < MIN_Y || pSprite->mPosition.y > MAX_Y)
+				kills.push_back(i);
+		}
+	}
+	double fObjects = (ClockSeconds() - fStart) / FRAMES;
+
+	fStart = ClockSeconds();
+	for(int frame = 0; frame < FRAMES; frame++)
+	{
+		list.Update(STEP, MIN_Y, MAX_Y);
+		list.Flush();
+	}
+	double fArrays = (ClockSeconds() - fStart) / FRAMES;
+
+	printf("  %-32s %8.1f us a step %8.1f M entities/s\n", "Sprite::update per object", fObjects * 1e6, nEntities / fObjects / 1e6);
+	printf("  %-32s %8.1f us a step %8.1f M entities/s  %5.2fx\n", "CEntityList::Update", fArrays * 1e6, nEntities / fArrays / 1e6, fObjects / fArrays);
+
+	// The two must still agree, up to float against double rounding.
+	double fMaxError = 0.0;
+	bool bSame = kills.empty() && list.Size() == nEntities;
+	for(size_t i = 0; i < sprites.size() && bSame; i++)
+	{
+		double dx = fabs(sprites[i]->mPosition.x - list.X(i));
+		double dy = fabs(sprites[i]->mPosition.y - list.Y(i));
+		fMaxError = std::max(fMaxError, std::max(dx, dy));
+	}
+	const double MAX_ERROR = 0.1;
+	bSame = bSame && fMaxError <= MAX_ERROR;
+
+	printf("Positions %s: %.4f px apart at most (allowed %.1f)\n", bSame ? "agree" : "DIFFER", fMaxError, MAX_ERROR);
+
+	for(size_t i = 0; i < sprites.size(); i++)
+		pool.Release(sprites[i]);
+	return bSame;
+}
+
+bool CBenchmarks::RunPipeline(double fSeconds, uint64_t seed)
+{
+	const float fTickRate = 120.0f;
+	const double fFramePeriod = 1.0 / 60.0;
+
+	CGameWorld world;
+	if(!world.Build(CGameWorld::DEFAULT_VIEW_HEIGHT))
+	{
+		fprintf(stderr, "Could not load the game assets; run from the directory holding data/\n");
+		return false;
+	}
+	world.Setup(fTickRate, seed);
+
+	CBenchRenderer renderer;
+	renderer.SetBackground(world.GetScroll());
+
+	CTripleBuffer<CWorldSnapshot> snapshots;
+	std::vector<CBusySpan> steps, draws;
+	steps.reserve((size_t)(fSeconds * fTickRate) + 16);
+	draws.reserve((size_t)(fSeconds / fFramePeriod) + 16);
+
+	printf("Pipeline: %.1f s of play, %.0f steps/s on a simulation thread, %.0f frames/s drawn from the triple buffer\n",
+		fSeconds, fTickRate, 1.0 / fFramePeriod);
+	fflush(stdout);
+
+	// The simulation thread, as CGameApp::SimulationThread runs it: a step
+	// when one is due, publishing the world after each.
+	std::atomic<bool> bRunning(true);
+	std::atomic<bool> bFailed(false);
+	std::thread simulation([&]()
+	{
+		PROFILE_THREAD("Simulation");
+
+		CInputBot bot(seed);
+		CFramePacer pacer;
+		unsigned long nGames = 1;
+		while(bRunning.load(std::memory_order_relaxed))
+		{
+			pacer.Pace(1.0 / fTickRate);
+
+			CBusySpan span;
+			span.Start = ClockSeconds();
+			{
+				PROFILE_ZONE("Step");
+				world.Step(1.0f / fTickRate, bot.Next());
+				if(world.IsOver())
+				{
+					world.Release();
+					if(!world.Build(CGameWorld::DEFAULT_VIEW_HEIGHT))
+					{
+						bFailed = true;
+						return;
+					}
+					world.Setup(fTickRate, seed + nGames++);
+				}
+
+				CWorldSnapshot& frame = snapshots.GetWriteBuffer();
+				frame.Clear();
+				world.Record(frame);
+				frame.Time = ClockSeconds();
+				snapshots.Publish();
+			}
+			span.End = ClockSeconds();
+			steps.push_back(span);
+		}
+	});
+
+	// This thread is the renderer: a frame every period, drawing the newest
+	// step it can get, between it and the one before by the clock.
+	CFramePacer pacer;
+	unsigned long nStalls = 0, nAcquired = 0, nBackwards = 0, nLastStep = 0;
+	double fEnd = ClockSeconds() + fSeconds;
+	while(ClockSeconds() < fEnd && !bFailed)
+	{
+		pacer.Pace(fFramePeriod);
+
+		CBusySpan span;
+		span.Start = ClockSeconds();
+		{
+			PROFILE_ZONE("Draw");
+			if(snapshots.Acquire())
+				nAcquired++;
+			else
+				nStalls++;
+
+			const CWorldSnapshot& frame = snapshots.GetReadBuffer();
+			if(frame.Step < nLastStep)
+				nBackwards++;
+			nLastStep = frame.Step;
+
+			float fAlpha = frame.StepLength > 0.0f ? (float)((span.Start - frame.Time) / frame.StepLength) : 0.0f;
+			renderer.Draw(frame, std::min(std::max(fAlpha, 0.0f), 1.0f));
+		}
+		span.End = ClockSeconds();
+		draws.push_back(span);
+	}
+
+	bRunning = false;
+	simulation.join();
+	world.Release();
+	if(bFailed)
+		return false;
+
+	double fStepBusy = 0.0, fDrawBusy = 0.0, fWorstDraw = 0.0;
+	for(size_t i = 0; i < steps.size(); i++)
+		fStepBusy += steps[i].End - steps[i].Start;
+	for(size_t i = 0; i < draws.size(); i++)
+	{
+		fDrawBusy += draws[i].End - draws[i].Start;
+		fWorstDraw = std::max(fWorstDraw, draws[i].End - draws[i].Start);
+	}
+
+	unsigned long nOverlapped;
+	double fOverlap = OverlapTime(steps, draws, nOverlapped);
+	unsigned long nSkipped = steps.size() > nAcquired ? (unsigned long)(steps.size() - nAcquired) : 0;
+
+	printf("  simulation: %6lu steps, %.3f ms a step with the snapshot, %.1f%% busy\n",
+		(unsigned long)steps.size(), fStepBusy * 1e3 / std::max<size_t>(steps.size(), 1), fStepBusy * 100.0 / fSeconds);
+	printf("  render:     %6lu frames, %.3f ms a frame, %.3f ms worst, %.1f%% busy\n",
+		(unsigned long)draws.size(), fDrawBusy * 1e3 / std::max<size_t>(draws.size(), 1), fWorstDraw * 1e3, fDrawBusy * 100.0 / fSeconds);
+	printf("  hand-off:   %6lu frames stalled (no new step), %lu steps never drawn\n", nStalls, nSkipped);
+	printf("  overlap:    %6lu frames drawn while a step ran, %.2f ms with both threads busy (%.1f%% of the drawing)\n",
+		nOverlapped, fOverlap * 1e3, fDrawBusy > 0.0 ? fOverlap * 100.0 / fDrawBusy : 0.0);
+
+	printf("Snapshots %s\n", nBackwards ? "went BACKWARDS" : "always in step order");
+	return nBackwards == 0;
+}
+
+bool CBenchmarks::RunScaling(int nMaxThreads, const CBatchSettings& settings)
+{
+	static const size_t ENTITIES = 100000;
+	static const int ENTITY_STEPS = 50;
+	static const size_t COLLIDERS = 50000;
+	static const int PAIR_ROUNDS = 10;
+
+	CSpritePool pool("data/bullet.bmp", RGB(0xff, 0x00, 0xff));
+	pool.Reserve(ENTITIES);
+	if(pool.GetWidth() == 0)
+	{
+		fprintf(stderr, "Could not load the game assets; run from the directory holding data/\n");
+		return false;
+	}
+
+	// The same starting entities and circles for every thread count
+	struct CStart { float x, y, vx, vy; };
+	std::vector<CStart> starts(ENTITIES);
+	std::vector<CStart> circles(COLLIDERS);
+	CBenchRandom random(13);
+	for(size_t i = 0; i < ENTITIES; i++)
+	{
+		CStart start = { (float)random.Below(800), (float)random.Below(600), (float)(random.Below(201) - 100), (float)(random.Below(2001) - 1000) };
+		starts[i] = start;
+	}
+	for(size_t i = 0; i < COLLIDERS; i++)
+	{
+		CStart circle = { (float)random.Below(8000), (float)random.Below(8000), 2.0f + random.Below(30), (float)random.Below(3) };
+		circles[i] = circle;
+	}
+
+	printf("Scaling: 1 to %d threads; batch of %lu sessions of at most %.1f minutes, %lu entities x %d updates, %lu circles x %d FindPairs\n",
+		nMaxThreads, settings.Sessions, settings.MaxMinutes, (unsigned long)ENTITIES, ENTITY_STEPS, (unsigned long)COLLIDERS, PAIR_ROUNDS);
+	printf("  %7s  %21s  %21s  %21s\n", "threads", "batch", "entity update", "find pairs");
+	fflush(stdout);
+
+	std::vector<CSessionResult> results, firstResults;
+	std::vector<float> positions, firstPositions;
+	std::vector<CCollisionPair> pairs, firstPairs;
+	double fSingle[3] = { 0.0, 0.0, 0.0 };
+	bool bSame = true;
+	for(int nThreads = 1; nThreads <= nMaxThreads; nThreads++)
+	{
+		g_Jobs.Stop();
+		g_Jobs.Start(nThreads - 1);
+
+		double times[3];
+		double fStart = ClockSeconds();
+		if(!CBatchRunner::Run(settings, results))
+		{
+			fprintf(stderr, "Could not load the game assets; run from the directory holding data/\n");
+			return false;
+		}
+		times[0] = ClockSeconds() - fStart;
+
+		{
+			CEntityList list;
+			list.SetPool(&pool);
+			list.Reserve(ENTITIES);
+			for(size_t i = 0; i < ENTITIES; i++)
+				list.Add(pool.Acquire(), starts[i].x, starts[i].y, starts[i].vx, starts[i].vy);
+
+			fStart = ClockSeconds();
+			for(int step = 0; step < ENTITY_STEPS; step++)
+			{
+				list.Update(1.0f / 120.0f, -1.0e6f, 1.0e6f);
+				list.Flush();
+			}
+			times[1] = ClockSeconds() - fStart;
+
+			positions.clear();
+			for(size_t i = 0; i < list.Size(); i++)
+			{
+				positions.push_back(list.X(i));
+				positions.push_back(list.Y(i));
+			}
+		}
+
+		CSpatialHash hash(64.0f);
+		fStart = ClockSeconds();
+		for(int round = 0; round < PAIR_ROUNDS; round++)
+		{
+			hash.Clear();
+			for(size_t i = 0; i < COLLIDERS; i++)
+				hash.Insert(circles[i].vy > 0.0f ? 1 : 0, (int)i, circles[i].x, circles[i].y, circles[i].vx);
+			pairs.clear();
+			hash.FindPairs(0, 1, pairs);
+		}
+		times[2] = ClockSeconds() - fStart;
+
+		// Threads must only change the time, never the outcome.
+		if(nThreads == 1)
+		{
+			firstResults = results;
+			firstPositions = positions;
+			firstPairs = pairs;
+			for(int i = 0; i < 3; i++)
+				fSingle[i] = times[i];
+		}
+		else
+		{
+			bool bPairs = pairs.size() == firstPairs.size();
+			for(size_t i = 0; i < pairs.size() && bPairs; i++)
+				bPairs = pairs[i].A == firstPairs[i].A && pairs[i].B == firstPairs[i].B;
+			if(!SameResults(results, firstResults) || positions != firstPositions || !bPairs)
+				bSame = false;
+		}
+
+		printf("  %7d", nThreads);
+		for(int i = 0; i < 3; i++)
+			printf("  %10.1f ms %6.2fx", times[i] * 1e3, fSingle[i] / times[i]);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	printf("Results %s on every thread count\n", bSame ? "identical" : "DIFFER");
+	return bSame;
+}
+
+bool CBenchmarks::RunResize(const char* szSizes, int nMaxThreads)
+{
+	unsigned long srcWidth = 1920, srcHeight = 1080, dstWidth = 3840, dstHeight = 2160;
+	if(*szSizes && (sscanf(szSizes, "%lux%lu:%lux%lu", &srcWidth, &srcHeight, &dstWidth, &dstHeight) != 4 ||
+		!srcWidth || !srcHeight || !dstWidth || !dstHeight))
+	{
+		fprintf(stderr, "Sizes are source and destination, as in -resize:1920x1080:3840x2160\n");
+		return false;
+	}
+
+	CBoxFilter box;
+	CBilinearFilter bilinear;
+	CBicubicFilter bicubic;
+	CBSplineFilter bspline;
+	CLanczos3Filter lanczos3;
+	struct { const char* szName; CGenericFilter* pFilter; } filters[] =
+	{
+		{ "box", &box }, { "bilinear", &bilinear }, { "bicubic", &bicubic }, { "bspline", &bspline }, { "lanczos3", &lanczos3 }
+	};
+	const int nFilters = sizeof(filters) / sizeof(filters[0]);
+	const int nRuns = 5;
+
+	CResizableImage source;
+	FillResizeImage(source, (LONG)srcWidth, (LONG)srcHeight);
+
+	printf("Resize: %lux%lu to %lux%lu (%.1f MP out), best of %d, 1 to %d threads\n",
+		srcWidth, srcHeight, dstWidth, dstHeight, dstWidth * dstHeight / 1e6, nRuns, nMaxThreads);
+	printf("  %-8s  %7s  %11s  %10s  %7s\n", "filter", "threads", "time", "rate", "speedup");
+
+	CResizableImage image;
+	double fSingle[nFilters];
+	uint64_t hashes[nFilters];
+	bool bSame = true;
+	for(int nThreads = 1; nThreads <= nMaxThreads; nThreads++)
+	{
+		g_Jobs.Stop();
+		g_Jobs.Start(nThreads - 1);
+
+		for(int f = 0; f < nFilters; f++)
+		{
+			image.SetFilter(filters[f].pFilter);
+
+			double fBest = 0.0;
+			for(int r = 0; r < nRuns; r++)
+			{
+				image.Create(source.Width(), source.Height());
+				memcpy(image.GetPixels(), source.GetPixels(), srcWidth * srcHeight * sizeof(RGBQUAD));
+
+				double fStart = ClockSeconds();
+				image.Resample(dstWidth, dstHeight);
+				double fTime = ClockSeconds() - fStart;
+				if(r == 0 || fTime < fBest)
+					fBest = fTime;
+			}
+
+			uint64_t hash = HashPixels(image);
+			if(nThreads == 1)
+			{
+				fSingle[f] = fBest;
+				hashes[f] = hash;
+			}
+			else if(hash != hashes[f])
+				bSame = false;
+
+			printf("  %-8s  %7d  %8.2f ms  %5.0f MP/s  %6.2fx\n", filters[f].szName, nThreads,
+				fBest * 1e3, dstWidth * dstHeight / fBest / 1e6, fSingle[f] / fBest);
+		}
+		fflush(stdout);
+	}
+
+	// The frame thread's view of an async resize: how long the call takes,
+	// and how long until the result is there.
+	image.SetFilter(&lanczos3);
+	image.Create(source.Width(), source.Height());
+	memcpy(image.GetPixels(), source.GetPixels(), srcWidth * srcHeight * sizeof(RGBQUAD));
+
+	double fStart = ClockSeconds();
+	std::future<void> done = image.ResampleAsync(dstWidth, dstHeight);
+	double fQueued = ClockSeconds() - fStart;
+	done.wait();
+	double fDone = ClockSeconds() - fStart;
+	if(HashPixels(image) != hashes[nFilters - 1])
+		bSame = false;
+
+	printf("Async lanczos3 on %d threads: returned after %.3f ms, done after %.2f ms\n", nMaxThreads, fQueued * 1e3, fDone * 1e3);
+	printf("Pixels %s on every thread count\n", bSame ? "identical" : "DIFFER");
+
+	// A frame thread runs a ParallelFor of its own while the async resize
+	// is pending, then waits on a job. The workers are held busy meanwhile,
+	// so if the resize were anywhere the frame thread takes jobs from, it
+	// would run it there.
+	static const double HOLD_SECONDS = 0.1;
+	if(g_Jobs.GetWorkerCount() == 0)
+	{
+		g_Jobs.Stop();
+		g_Jobs.Start(1);
+	}
+
+	int nWorkers = g_Jobs.GetWorkerCount();
+	std::atomic<int> nHeld(0);
+	double fHoldStart = ClockSeconds();
+	std::vector<std::unique_ptr<CJob> > holds;
+	for(int i = 0; i < nWorkers; i++)
+	{
+		holds.push_back(std::unique_ptr<CJob>(new CJob([&]()
+		{
+			nHeld++;
+			while(ClockSeconds() - fHoldStart < HOLD_SECONDS)
+				std::this_thread::yield();
+		})));
+		g_Jobs.Submit(*holds.back());
+	}
+	while(nHeld < nWorkers)
+		std::this_thread::yield();
+
+	CWatchedFilter watched;
+	watched.Watched = std::this_thread::get_id();
+	GetWeightsCache().Clear();
+	image.SetFilter(&watched);
+	image.Create(source.Width(), source.Height());
+	memcpy(image.GetPixels(), source.GetPixels(), srcWidth * srcHeight * sizeof(RGBQUAD));
+	done = image.ResampleAsync(dstWidth, dstHeight);
+
+	std::atomic<size_t> nItems(0);
+	g_Jobs.ParallelFor(0, 4096, 64, [&](size_t first, size_t last) { nItems += last - first; });
+	bool bPending = done.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+
+	for(int i = 0; i < nWorkers; i++)
+		g_Jobs.Wait(*holds[i]);
+	done.wait();
+
+	bool bBackground = bPending && !watched.bSampled && nItems == 4096;
+	printf("Async resize %s while the caller ran jobs\n", bBackground ? "stayed on the workers" : "RAN ON THE CALLER");
+
+	// The vertical pass alone, source height to destination height at the
+	// source width, against the column walk it replaced.
+	struct { EResamplePath Path; const char* szName; } paths[] =
+	{
+		{ RESAMPLE_SCALAR, "scalar" }, { RESAMPLE_SSE2, "SSE2" }, { RESAMPLE_AVX2, "AVX2" }
+	};
+	const int nPaths = sizeof(paths) / sizeof(paths[0]);
+	EResamplePath best = GetResamplePath();
+	double fPixels = (double)srcWidth * dstHeight;
+
+	std::vector<RGBQUAD> columns((size_t)srcWidth * dstHeight), rows(columns.size());
+	bool bSameVertical = true;
+	printf("Vertical pass alone, %lux%lu to %lux%lu, one thread, MP/s, best of %d\n", srcWidth, srcHeight, srcWidth, dstHeight, nRuns);
+	printf("  %-8s  %7s", "filter", "columns");
+	for(int p = 0; p < nPaths; p++)
+		printf("  %7s", paths[p].szName);
+	printf("\n");
+	for(int f = 0; f < nFilters; f++)
+	{
+		WeightsTablePtr pTable = GetWeightsCache().Acquire(filters[f].pFilter, dstHeight, srcHeight);
+
+		double fBest = 0.0;
+		for(int r = 0; r < nRuns; r++)
+		{
+			double fStart = ClockSeconds();
+			ColumnWalk(&columns[0], source.GetPixels(), (unsigned int)srcWidth, *pTable, (unsigned int)dstHeight);
+			double fTime = ClockSeconds() - fStart;
+			if(r == 0 || fTime < fBest)
+				fBest = fTime;
+		}
+		printf("  %-8s  %7.0f", filters[f].szName, fPixels / fBest / 1e6);
+
+		for(int p = 0; p < nPaths; p++)
+		{
+			SetResamplePath(paths[p].Path);
+			if(GetResamplePath() != paths[p].Path)
+			{
+				printf("  %7s", "-");
+				continue;
+			}
+
+			for(int r = 0; r < nRuns; r++)
+			{
+				double fStart = ClockSeconds();
+				ResampleVertical(&rows[0], source.GetPixels(), (unsigned int)srcWidth, *pTable, (unsigned int)dstHeight);
+				double fTime = ClockSeconds() - fStart;
+				if(r == 0 || fTime < fBest)
+					fBest = fTime;
+			}
+			if(memcmp(&rows[0], &columns[0], rows.size() * sizeof(RGBQUAD)) != 0)
+				bSameVertical = false;
+			printf("  %7.0f", fPixels / fBest / 1e6);
+		}
+		printf("\n");
+		fflush(stdout);
+	}
+	SetResamplePath(best);
+	printf("Vertical pass %s the column walk on every path\n", bSameVertical ? "matches" : "DIFFERS from");
+
+	// Building both tables of the benchmark's resize, which is what a miss
+	// in the weights cache costs.
+	CExactLanczos3Filter exact;
+	printf("Weights tables for %lux%lu to %lux%lu, best of %d:\n", srcWidth, srcHeight, dstWidth, dstHeight, nRuns);
+	for(int f = 0; f <= nFilters; f++)
+	{
+		CGenericFilter* pFilter = f < nFilters ? filters[f].pFilter : &exact;
+		double fBest = 0.0;
+		for(int r = 0; r < nRuns; r++)
+		{
+			double fStart = ClockSeconds();
+			CWeightsTable across(pFilter, dstWidth, srcWidth);
+			CWeightsTable down(pFilter, dstHeight, srcHeight);
+			double fTime = ClockSeconds() - fStart;
+			if(r == 0 || fTime < fBest)
+				fBest = fTime;
+		}
+		printf("  %-14s  %6.3f ms\n", f < nFilters ? filters[f].szName : "lanczos3 (sin)", fBest * 1e3);
+	}
+
+	// The Lanczos3 table against sin, between and on its samples. A
+	// hundredth of a weight step cannot move a weight.
+	static const double LUT_TOLERANCE = 0.01 / RESIZE_WEIGHT_ONE;
+	static const int LUT_CHECKS = 1000003;
+	CLanczos3Kernel kernel;
+	double dLutError = 0.0;
+	for(int i = 0; i <= LUT_CHECKS; i++)
+	{
+		double dVal = 3.0 * i / LUT_CHECKS;
+		dLutError = std::max(dLutError, fabs(kernel.Filter(dVal) - CLanczos3Kernel::Exact(dVal)));
+	}
+	bool bLut = dLutError <= LUT_TOLERANCE;
+	printf("Lanczos3 table off sin by %.2g at most, %s %.2g\n", dLutError, bLut ? "within" : "OUTSIDE", LUT_TOLERANCE);
+
+	// Fixed point against double weights, enlarging and shrinking: rounding
+	// the weights to 14 bits may move a result across a rounding edge, but
+	// never by more than one level.
+	static const int MAX_LEVEL_ERROR = 1;
+	static const LONG CHECK_SIZES[][4] = { { 640, 480, 1000, 750 }, { 640, 480, 237, 178 } };
+	bool bAccurate = true;
+	printf("Accuracy against double precision weights, %d level%s allowed:\n", MAX_LEVEL_ERROR, MAX_LEVEL_ERROR == 1 ? "" : "s");
+	for(int c = 0; c < 2; c++)
+	{
+		const LONG* pSizes = CHECK_SIZES[c];
+		printf("  %ldx%ld to %ldx%ld:", pSizes[0], pSizes[1], pSizes[2], pSizes[3]);
+		for(int f = 0; f < nFilters; f++)
+		{
+			CResizableImage check;
+			FillResizeImage(check, pSizes[0], pSizes[1]);
+
+			std::vector<RGBQUAD> reference;
+			ReferenceResample(check, filters[f].pFilter, pSizes[2], pSizes[3], reference);
+			check.SetFilter(filters[f].pFilter);
+			check.Resample(pSizes[2], pSizes[3]);
+
+			const BYTE* pFixed = (const BYTE*)check.GetPixels();
+			const BYTE* pDouble = (const BYTE*)&reference[0];
+			int iMaxError = 0;
+			size_t nOff = 0, nBytes = reference.size() * sizeof(RGBQUAD);
+			for(size_t i = 0; i < nBytes; i++)
+			{
+				int iError = abs((int)pFixed[i] - (int)pDouble[i]);
+				iMaxError = std::max(iMaxError, iError);
+				nOff += iError != 0;
+			}
+			if(iMaxError > MAX_LEVEL_ERROR)
+				bAccurate = false;
+
+			printf("  %s %d (%.2f%%)", filters[f].szName, iMaxError, nOff * 100.0 / (reference.size() * 3));
+		}
+		printf("\n");
+	}
+	printf("Fixed point %s\n", bAccurate ? "within tolerance" : "OUT OF TOLERANCE");
+
+	return bSame && bBackground && bSameVertical && bLut && bAccurate;
+}
@@ -0,0 +1,172 @@
+// Blitter.cpp
+// Software sprite compositing on 32 bit pixel buffers.
+#include "Blitter.h"
+
+#include "CpuFeatures.h"
+
+namespace
+{
+	const unsigned int OPAQUE_PIXEL = 0xFF000000;
+	const unsigned int COLOR_MASK	= 0x00FFFFFF;
+
+	//-------------------------------------------------------------------------
+	// Row kernels: dst[i] = opaque(src[i]) ? src[i] : dst[i]
+	//-------------------------------------------------------------------------
+	void BlitRowScalar(unsigned int* dst, const unsigned int* src, int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			unsigned int s = src[i];
+			if(s & OPAQUE_PIXEL)
+				dst[i] = s;
+		}
+	}
+
+#ifdef CPU_X86
+	void BlitRowSSE2(unsigned int* dst, const unsigned int* src, int count)
+	{
+		int i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+
+			// Sign-extend the alpha byte into a whole-pixel select mask.
+			__m128i m = _mm_srai_epi32(s, 31);
+			d = _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d));
+
+			_mm_storeu_si128((__m128i*)(dst + i), d);
+		}
+
+		BlitRowScalar(dst + i, src + i, count - i);
+	}
+
+	CPU_AVX2_FUNC void BlitRowAVX2(unsigned int* dst, const unsigned int* src, int count)
+	{
+		int i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			__m256i m = _mm256_srai_epi32(s, 31);
+
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(d, s, m));
+		}
+
+		BlitRowSSE2(dst + i, src + i, count - i);
+	}
+#endif
+
+	typedef void (*BlitRowFunc)(unsigned int* dst, const unsigned int* src, int count);
+
+	EBlitPath BestBlitPath()
+	{
+#ifdef CPU_X86
+		return CpuHasAVX2() ? BLIT_AVX2 : BLIT_SSE2;
+#else
+		return BLIT_SCALAR;
+#endif
+	}
+
+	EBlitPath	g_BlitPath = BestBlitPath();
+
+	BlitRowFunc RowKernel(EBlitPath path)
+	{
+		switch(path)
+		{
+#ifdef CPU_X86
+		case BLIT_AVX2:	return BlitRowAVX2;
+		case BLIT_SSE2:	return BlitRowSSE2;
+#endif
+		default:		return BlitRowScalar;
+		}
+	}
+
+	BlitRowFunc	g_BlitRow = RowKernel(g_BlitPath);
+}
+
+EBlitPath GetBlitPath()
+{
+	return g_BlitPath;
+}
+
+void SetBlitPath(EBlitPath path)
+{
+	// Never select a kernel the CPU cannot run.
+	if(path > BestBlitPath())
+		path = BestBlitPath();
+
+	g_BlitPath = path;
+	g_BlitRow = RowKernel(path);
+}
+
+//-----------------------------------------------------------------------------
+// Mask building (load time)
+//-----------------------------------------------------------------------------
+PixelImagePtr BuildColorKeyImage(const CPixelImage& image, unsigned int colorKey)
+{
+	std::shared_ptr<CPixelImage> pKeyed(new CPixelImage(image.Width(), image.Height()));
+
+	const unsigned int* src = image.Pixels();
+	unsigned int* dst = pKeyed->Pixels();
+	size_t count = (size_t)image.Width() * image.Height();
+	colorKey &= COLOR_MASK;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		unsigned int c = src[i] & COLOR_MASK;
+		dst[i] = c == colorKey ? c : c | OPAQUE_PIXEL;
+	}
+
+	return pKeyed;
+}
+
+PixelImagePtr BuildMaskedImage(const CPixelImage& image, const CPixelImage& mask)
+{
+	if(image.Width() != mask.Width() || image.Height() != mask.Height())
+		return PixelImagePtr();
+
+	std::shared_ptr<CPixelImage> pMasked(new CPixelImage(image.Width(), image.Height()));
+
+	const unsigned int* src = image.Pixels();
+	const unsigned int* msk = mask.Pixels();
+	unsigned int* dst = pMasked->Pixels();
+	size_t count = (size_t)image.Width() * image.Height();
+
+	for(size_t i = 0; i < count; i++)
+	{
+		unsigned int c = src[i] & COLOR_MASK;
+		dst[i] = (msk[i] & COLOR_MASK) == 0 ? c | OPAQUE_PIXEL : c;
+	}
+
+	return pMasked;
+}
+
+//-----------------------------------------------------------------------------
+// Drawing
+//-----------------------------------------------------------------------------
+void BlitKeyed(const CPixelSurface& dst, int x, int y,
+			   const CPixelImage& src, int srcX, int srcY, int w, int h)
+{
+	if(!dst.pPixels)
+		return;
+
+	// Keep the source window inside the image.
+	if(srcX < 0) { x -= srcX; w += srcX; srcX = 0; }
+	if(srcY < 0) { y -= srcY; h += srcY; srcY = 0; }
+	if(srcX + w > src.Width())	w = src.Width() - srcX;
+	if(srcY + h > src.Height())	h = src.Height() - srcY;
+
+	// Clip against the surface edges.
+	if(x < 0) { srcX -= x; w += x; x = 0; }
+	if(y < 0) { srcY -= y; h += y; y = 0; }
+	if(x + w > dst.Width)	w = dst.Width - x;
+	if(y + h > dst.Height)	h = dst.Height - y;
+
+	if(w <= 0 || h <= 0)
+		return;
+
+	BlitRowFunc blitRow = g_BlitRow;
+	for(int row = 0; row < h; row++)
+		blitRow(dst.Row(y + row) + x, src.Row(srcY + row) + srcX, w);
+}
@@ -11,10 +11,63 @@
 //-----------------------------------------------------------------------------
 #include<math.h>
 #include "CGameApp.h"
-#define TIMER_SEC 3
-#define TIMER_SEC2 4
+#include "Profiler.h"
+#include <chrono>
+
+// Messages between the window and the simulation, besides the window's own
+#define WM_GAME_MOVE		(WM_APP + 1)	// wParam: held direction keys
 
 extern HINSTANCE g_hInst;
+extern CAssetCache g_Assets;
+
+// Fixed step limits (see FrameAdvance)
+static const float	MIN_TICK_RATE		= 10.0f;
+static const float	MAX_TICK_RATE		= 1000.0f;
+static const float	MAX_FRAME_DELTA		= 0.25f;
+static const int	MAX_STEPS_PER_FRAME	= 8;
+
+//-----------------------------------------------------------------------------
+// Name : CommandLineValue () (Static)
+// Desc : Returns the number following the option on the command line
+//		(e.g. "-tick:60"), or the default if the option is not there.
+//-----------------------------------------------------------------------------
+static float CommandLineValue( LPCTSTR szCmdLine, LPCTSTR szOption, float fDefault )
+{
+	LPCTSTR szValue = strstr( szCmdLine, szOption );
+	if ( !szValue ) return fDefault;
+
+	return (float)atof( szValue + strlen( szOption ) );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CommandLineString () (Static)
+// Desc : Copies the text following the option up to the next space (e.g. the
+//		file in "-replay:data/run.rec"). Returns false if the option is not
+//		there, leaving szValue alone.
+//-----------------------------------------------------------------------------
+static bool CommandLineString( LPCTSTR szCmdLine, LPCTSTR szOption, LPTSTR szValue, size_t size )
+{
+	LPCTSTR szStart = strstr( szCmdLine, szOption );
+	if ( !szStart ) return false;
+
+	szStart += strlen( szOption );
+	size_t length = strcspn( szStart, _T(" \t") );
+	if ( length == 0 ) return true;
+	if ( length >= size ) length = size - 1;
+
+	memcpy( szValue, szStart, length * sizeof(TCHAR) );
+	szValue[length] = 0;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ClockSeconds () (Static)
+// Desc : Monotonic clock shared by the simulation and render threads.
+//-----------------------------------------------------------------------------
+static double ClockSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 //-----------------------------------------------------------------------------
 // CGameApp Member Functions
@@ -30,8 +83,20 @@ CGameApp::CGameApp()
 	m_hIcon			= NULL;
 	m_hMenu			= NULL;
 	m_pBBuffer		= NULL;
-	m_pPlayer		= NULL;
 	m_LastFrameRate = 0;
+	m_szCmdLine[0]	= 0;
+	m_fTickRate		= 120.0f;
+	m_fAccumulator	= 0.0f;
+	m_fRenderLimit	= 0.0f;
+	m_bActive		= false;
+	m_bThreaded		= true;
+	m_bSimRunning	= false;
+	m_fSimClock		= 0.0;
+	m_ulKeys		= 0;
+	m_ulKeysSent	= 0;
+	m_ulActions		= 0;
+	m_nSeed			= 0;
+	m_bGameOver		= false;
 }
 
 //-----------------------------------------------------------------------------
@@ -50,6 +115,25 @@ CGameApp::~CGameApp()
 //-----------------------------------------------------------------------------
 bool CGameApp::InitInstance( LPCTSTR lpCmdLine, int iCmdShow )
 {
+	// Keep the command line around for the option checks.
+	strncpy_s( m_szCmdLine, lpCmdLine ? lpCmdLine : _T(""), _TRUNCATE );
+
+	// Simulation and render rates
+	m_fTickRate = CommandLineValue( m_szCmdLine, "-tick:", m_fTickRate );
+	if ( m_fTickRate < MIN_TICK_RATE ) m_fTickRate = MIN_TICK_RATE;
+	if ( m_fTickRate > MAX_TICK_RATE ) m_fTickRate = MAX_TICK_RATE;
+	m_fRenderLimit = CommandLineValue( m_szCmdLine, "-fps:", 0.0f );
+	if ( m_fRenderLimit < 0.0f ) m_fRenderLimit = 0.0f;
+	m_bThreaded = strstr( m_szCmdLine, "-sim:inline" ) == NULL;
+
+	// Input recording and replay. A replay brings its own tick rate and
+	// seed, so it runs the steps it was recorded with.
+	if ( !SetupInputLog() ) return false;
+
+	// Frames over budget count as hitches in the frame time statistics
+	float fBudget = CommandLineValue( m_szCmdLine, "-budget:", 1000.0f / 30.0f );
+	if ( fBudget > 0.0f ) m_Timer.SetHitchBudget( fBudget / 1000.0f );
+
 	// Create the primary display device
 	if (!CreateDisplay()) { ShutDown(); return false; }
 
@@ -127,6 +211,17 @@ int CGameApp::BeginGame()
 {
 	MSG		msg;
 
+	PROFILE_THREAD("Window");
+
+	// Publish the starting positions, so there is a world to draw before
+	// the first step, then let the simulation go.
+	m_fSimClock = ClockSeconds();
+	RecordSnapshot( m_fSimClock );
+	if ( m_bThreaded ) StartSimulation();
+
+	// Loading is over; frame times start counting here.
+	m_Timer.Restart();
+
 	// Start main loop
 	while(true) 
 	{
@@ -137,6 +232,11 @@ int CGameApp::BeginGame()
 			TranslateMessage( &msg );
 			DispatchMessage ( &msg );
 		} 
+		else if ( !m_bActive )
+		{
+			// Minimized: nothing to draw, so block until something happens.
+			WaitMessage();
+		}
 		else 
 		{
 			// Advance Game Frame.
@@ -146,6 +246,10 @@ int CGameApp::BeginGame()
 	
 	} // Until quit message is receieved
 
+	// Write the frame time statistics for the whole run, if asked to
+	if ( strstr( m_szCmdLine, "-stats" ) ) SaveFrameStats();
+
+	StopSimulation();
 	return 0;
 }
 
@@ -155,6 +259,10 @@ int CGameApp::BeginGame()
 //-----------------------------------------------------------------------------
 bool CGameApp::ShutDown()
 {
+	// Nothing may be simulating while the objects go away
+	StopSimulation();
+	m_Recorder.Close();
+
 	// Release any previously built objects
 	ReleaseObjects ( );
 	
@@ -202,15 +310,10 @@ LRESULT CALLBACK CGameApp::StaticWndProc(HWND hWnd, UINT Message, WPARAM wParam,
 //-----------------------------------------------------------------------------
 LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM lParam )
 {
-	static UINT			fTimer;	
-
 	// Determine message type
 	switch (Message)
 	{
 		case WM_CREATE:
-			SetTimer(hWnd, TIMER_SEC, 500, NULL);
-		
-			SetTimer(hWnd, TIMER_SEC2, 10000, NULL);
 			break;
 		
 		case WM_CLOSE:
@@ -230,7 +333,8 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 			} // App has been minimized
 			else
 			{
-				// App is active
+				// App is active; the time spent minimized is not a frame
+				if ( !m_bActive ) m_Timer.Resume();
 				m_bActive = true;
 
 				// Store new viewport sizes
@@ -242,6 +346,12 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 
 			break;
 
+		case WM_PAINT:
+			// Whatever got uncovered is repainted with the next frame.
+			ValidateRect(hWnd, NULL);
+			if ( m_pBBuffer ) m_pBBuffer->markAllDirty();
+			break;
+
 		case WM_LBUTTONDOWN:
 			// Capture the mouse
 			SetCapture( m_hWnd );
@@ -255,100 +365,28 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 			break;
 
 		case WM_KEYDOWN:
-			switch(wParam)
+			if ( wParam == VK_ESCAPE )
 			{
-			case VK_ESCAPE:
 				PostQuitMessage(0);
 				break;
-			case VK_RETURN:
-				fTimer = SetTimer(m_hWnd, 1, 100, NULL);
-				m_pPlayer->Explode();
-				break;
-		
-			case 0x46:
-				m_pRacheta->BulletExplosion();
-				break;
-
-
-			}
-			break;
-		case WM_KEYUP: {
-			switch (wParam) {
-			case VK_SPACE:
-				m_pPlayer->BulletExplosion();
-				break;
-			}
-
-			}
-		case WM_CHAR:
-		{
-			switch (wParam) {
-			case 'q':
-				fTimer = SetTimer(m_hWnd, 2, 100, NULL);
-				m_pRacheta->Explode();
-				break;
-
-			case 't':
-				RotateIt++;
-				m_pPlayer->RotateSprite(RotateIt%4);
-				break;
-
-			case 'r': 
-				m_pPlayer->RotateSprite(RotateIt % 4);
-			    RotateIt--;	
-				if (RotateIt < 0) {
-					RotateIt = 3;
-				}
-			case 'b':
-				RotateIt++;
-				m_pRacheta->RotateSprite(RotateIt2 % 4);
-				break;
-			case 'n':
-				m_pRacheta->RotateSprite(RotateIt2 % 4);
-				RotateIt2--;
-				if (RotateIt2 < 0) {
-					RotateIt2 = 3;
-				}
-				
-				break;
-			case 'h':
-				SaveGame();
-				break;
-			case 'g':
-				LoadGame();
-				break;
-
 			}
-			
-			
-		
-
-		}
 
-		case WM_TIMER:
-			switch(wParam)
+			// Frame time statistics so far, whenever asked for
+			if ( wParam == VK_F9 )
 			{
-			case 1:
-				if(!m_pPlayer->AdvanceExplosion())
-			
-					KillTimer(m_hWnd, 1);
+				SaveFrameStats();
 				break;
-			case 2:
-				if (!m_pRacheta->AdvanceExplosion())
+			}
 
-					KillTimer(m_hWnd, 2);
-				break;
-			case TIMER_SEC: 
-				Crate->SpawnCrate();
-				break;
-			case TIMER_SEC2:
-				Crate->spawncoins();
-				break;
+			PostInput( Message, wParam );
+			break;
 
-			}
+		case WM_KEYUP:
+		case WM_CHAR:
+			// Game keys act on the world, which belongs to the
+			// simulation; see HandleGameMessage.
+			PostInput( Message, wParam );
 			break;
-		
-		
 
 		case WM_COMMAND:
 			break;
@@ -367,27 +405,47 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 //-----------------------------------------------------------------------------
 bool CGameApp::BuildObjects()
 {
-	m_pBBuffer = new BackBuffer(m_hWnd, m_nViewWidth, m_nViewHeight);
-	m_pPlayer = new CPlayer(m_pBBuffer);
-	m_pRacheta = new CPlayer2(m_pBBuffer);
-	Crate = new Enemy(m_pBBuffer);
-	if(!m_imgBackground.LoadBitmapFromFile("data/scrollingbg.bmp", GetDC(m_hWnd)))
+	m_pBBuffer = new BackBuffer(m_nViewWidth, m_nViewHeight, CreatePresenter());
+	if (!m_World.Build((int)m_nViewHeight))
 		return false;
 
+	// Decoded once and kept resident; every frame is just row copies. The
+	// world scrolls its own copy, the snapshots carry the offset.
+	m_Background.SetImage(m_World.GetScroll().GetImage());
+	m_Background.SetOffset((float)m_World.GetScroll().GetOffset());
+	m_Background.SetSpeed(m_World.GetScroll().GetSpeed());
+
 	// Success!
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Name : CreatePresenter ()
+// Desc : Picks where finished frames go, based on the command line:
+//		-present:memory	keeps frames in memory only (profiling)
+//		-present:dump	appends raw frames to data/frames.raw
+//		-present:dib		window, staged through a DIB section
+//		otherwise		window, through StretchDIBits
+//-----------------------------------------------------------------------------
+IPresenter* CGameApp::CreatePresenter()
+{
+	if (strstr(m_szCmdLine, "-present:memory"))
+		return new CMemoryPresenter();
+	if (strstr(m_szCmdLine, "-present:dump"))
+		return new CFrameDumpPresenter("data/frames.raw");
+	if (strstr(m_szCmdLine, "-present:dib"))
+		return new CWin32Presenter(m_hWnd, CWin32Presenter::PRESENT_DIBSECTION);
+
+	return new CWin32Presenter(m_hWnd);
+}
+
 //-----------------------------------------------------------------------------
 // Name : SetupGameState ()
 // Desc : Sets up all the initial states required by the game.
 //-----------------------------------------------------------------------------
 void CGameApp::SetupGameState()
 {
-	m_pPlayer->Position() = Vec2(100, 400);
-	m_pRacheta->Position() = Vec2(400, 400);
-
-
+	m_World.Setup( m_fTickRate, m_nSeed );
 }
 
 //-----------------------------------------------------------------------------
@@ -397,26 +455,14 @@ void CGameApp::SetupGameState()
 //-----------------------------------------------------------------------------
 void CGameApp::ReleaseObjects( )
 {
-	if(m_pPlayer != NULL)
-	{
-		delete m_pPlayer;
-		m_pPlayer = NULL;
-	}
-	if (m_pRacheta != NULL)
-	{
-		delete m_pRacheta;
-		m_pRacheta = NULL;
-	}
+	m_World.ReportPools();
+	m_World.Release();
+
 	if(m_pBBuffer != NULL)
 	{
 		delete m_pBBuffer;
 		m_pBBuffer = NULL;
 	}
-	if (Crate != NULL)
-	{
-		delete Crate;
-		Crate = NULL;
-	}
 }
 
 //-----------------------------------------------------------------------------
@@ -425,357 +471,441 @@ void CGameApp::ReleaseObjects( )
 //-----------------------------------------------------------------------------
 void CGameApp::FrameAdvance()
 {
-	static TCHAR FrameRate[ 50 ];
-	static TCHAR TitleBuffer[ 255 ];
+	TCHAR FrameRate[ 50 ];
+	TCHAR TitleBuffer[ 255 ];
 
 	// Advance the timer
-	m_Timer.Tick( );
+	m_Timer.Tick( m_fRenderLimit );
+	PROFILE_ZONE("FrameAdvance");
 
 	// Skip if app is inactive
 	if ( !m_bActive ) return;
 	
+	// Poll input devices; the simulation picks the keys up on its next step
+	ProcessInput();
+
+	// Without a simulation thread, run the steps that are due right here
+	if ( !m_bThreaded ) SimulateFrame();
+
+	// Draw the newest complete step the simulation published
+	m_Snapshots.Acquire();
+	const CWorldSnapshot& frame = m_Snapshots.GetReadBuffer();
+
 	// Get / Display the framerate
 	if ( m_LastFrameRate != m_Timer.GetFrameRate() )
 	{
 		m_LastFrameRate = m_Timer.GetFrameRate( FrameRate, 50 );
-		sprintf_s( TitleBuffer, _T("Game : %s  Score: %d Score2: %d  Lives: %d Lives2: %d")  , FrameRate,Score,Score2, Lives,Lives2 );
+		CFrameStats stats = m_Timer.GetFrameStats();
+		sprintf_s( TitleBuffer, _T("Game : %s (p99 %.1f ms, %lu hitches)  Score: %d Score2: %d  Lives: %d Lives2: %d  Pushed: %lu px  Entities: %lu (-%lu)")  , FrameRate, stats.P99 * 1000.0, (ULONG)stats.Hitches, frame.Score, frame.Score2, frame.Lives, frame.Lives2, m_pBBuffer ? m_pBBuffer->getPixelsPushed() : 0UL, frame.LiveEntities, frame.FreedEntities );
 		SetWindowText( m_hWnd, TitleBuffer );
 
 	} // End if Frame Rate Altered
 
-	// Poll & Process input devices
-	ProcessInput();
-
-	// Animate the game objects
-	AnimateObjects();
-
-	// Drawing the game objects
-	DrawObjects();
-
-	//Collision();
-
-	PlaneCrateCollision();
-	BulletCrateCollision();
-	FishCoinCollision();
-	FishUpgrade();
-	
-	HeartCollision();
-
-
+	// Draw the objects between the last two steps, by how far into the
+	// next step the clock already is.
+	float fAlpha = (float)((ClockSeconds() - frame.Time) / frame.StepLength);
+	if ( fAlpha < 0.0f ) fAlpha = 0.0f;
+	if ( fAlpha > 1.0f ) fAlpha = 1.0f;
 
+	DrawObjects( frame, fAlpha );
 }
 
 //-----------------------------------------------------------------------------
-// Name : ProcessInput () (Private)
-// Desc : Simply polls the input devices and performs basic input operations
+// Name : StartSimulation () (Private)
+// Desc : Starts the simulation thread. From here on the game objects belong
+//		to it; the window thread only renders the snapshots it publishes.
 //-----------------------------------------------------------------------------
-void CGameApp::ProcessInput()
+void CGameApp::StartSimulation()
 {
-	static UCHAR pKeyBuffer[256];
-	ULONG		Direction = 0;
-	ULONG       Direction2 = 0;
-	POINT		CursorPos;
-	float		X = 0.0f, Y = 0.0f;
-
-	// Retrieve keyboard state
-	if (!GetKeyboardState(pKeyBuffer)) return;
-
-	// Check the relevant keys
-	if (pKeyBuffer[VK_UP] & 0xF0) Direction |= CPlayer::DIR_FORWARD;
-	if (pKeyBuffer[VK_DOWN] & 0xF0) Direction |= CPlayer::DIR_BACKWARD;
-	if (pKeyBuffer[VK_LEFT] & 0xF0) Direction |= CPlayer::DIR_LEFT;
-	if (pKeyBuffer[VK_RIGHT] & 0xF0) Direction |= CPlayer::DIR_RIGHT;
+	if ( m_SimThread.joinable() ) return;
 
+	m_bSimRunning = true;
+	m_SimThread = std::thread( &CGameApp::SimulationThread, this );
+}
 
-	// Move the player
-	m_pPlayer->Move(Direction);
+//-----------------------------------------------------------------------------
+// Name : StopSimulation () (Private)
+// Desc : Stops the simulation thread, if running, and waits for it.
+//-----------------------------------------------------------------------------
+void CGameApp::StopSimulation()
+{
+	if ( !m_SimThread.joinable() ) return;
 
-	if (pKeyBuffer[0x57] & 0xF0) Direction2 |= CPlayer2::DIR_FORWARD;
-	if (pKeyBuffer[0x53] & 0xF0) Direction2 |= CPlayer2::DIR_BACKWARD;
-	if (pKeyBuffer[0x41] & 0xF0) Direction2 |= CPlayer2::DIR_LEFT;
-	if (pKeyBuffer[0x44] & 0xF0) Direction2 |= CPlayer2::DIR_RIGHT;
+	m_bSimRunning = false;
+	m_SimThread.join();
+}
 
-	m_pRacheta->Move(Direction2);
-	 
+//-----------------------------------------------------------------------------
+// Name : SimulationThread () (Private)
+// Desc : Runs the simulation steps as they fall due, until stopped.
+//-----------------------------------------------------------------------------
+void CGameApp::SimulationThread()
+{
+	PROFILE_THREAD("Simulation");
 
-	// Now process the mouse (if the button is pressed)
-	if ( GetCapture() == m_hWnd )
+	while ( m_bSimRunning )
 	{
-		// Hide the mouse pointer
-		SetCursor( NULL );
-
-		// Retrieve the cursor position
-		GetCursorPos( &CursorPos );
+		// Minimized: the world stands still, and the time away is not
+		// caught up on later.
+		if ( !m_bActive )
+		{
+			std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+			m_fSimClock = ClockSeconds();
+			continue;
+		}
 
-		// Reset our cursor position so we can keep going forever :)
-		SetCursorPos( m_OldCursorPos.x, m_OldCursorPos.y );
+		if ( SimulateFrame() > 0 ) continue;
 
-	} // End if Captured
+		// Nothing due yet; sleep until the next step is, spinning only
+		// for the last bit a sleep cannot be trusted with.
+		m_SimPacer.WaitUntil( m_fSimClock + (1.0f / m_fTickRate - m_fAccumulator) );
+	}
 }
 
 //-----------------------------------------------------------------------------
-// Name : AnimateObjects () (Private)
-// Desc : Animates the objects we currently have loaded.
+// Name : SimulateFrame () (Private)
+// Desc : Runs the fixed steps due for the time passed since the last call,
+//		publishing a snapshot when there were any. Returns the step count.
 //-----------------------------------------------------------------------------
-void CGameApp::AnimateObjects()
+int CGameApp::SimulateFrame()
 {
-	m_pPlayer->Update(m_Timer.GetTimeElapsed());
-	m_pPlayer->UpdateHeart(m_Timer.GetTimeElapsed());
-	m_pRacheta->Update(m_Timer.GetTimeElapsed());
-	Crate->Update(m_Timer.GetTimeElapsed());
-	Crate->updatecoins(m_Timer.GetTimeElapsed());
-	
-}
+	// A long stall (dragging the window, a breakpoint) is clamped so the
+	// game does not try to catch up on all of it at once.
+	double fNow = ClockSeconds();
+	float fStep = 1.0f / m_fTickRate;
+	float fDelta = (float)(fNow - m_fSimClock);
+	if ( fDelta > MAX_FRAME_DELTA ) fDelta = MAX_FRAME_DELTA;
+
+	m_fSimClock = fNow;
+	m_fAccumulator += fDelta;
+
+	int nSteps = 0;
+	while ( m_fAccumulator >= fStep )
+	{
+		if ( nSteps == MAX_STEPS_PER_FRAME )
+		{
+			// Still behind; drop the backlog rather than spiral.
+			m_fAccumulator = 0.0f;
+			break;
+		}
 
-//-----------------------------------------------------------------------------
-// Name : DrawObjects () (Private)
-// Desc : Draws the game objects
-//-----------------------------------------------------------------------------
-void CGameApp::DrawObjects()
-{
-	m_pBBuffer->reset();
+		SimulateStep( fStep );
+		m_fAccumulator -= fStep;
+		nSteps++;
+	}
 
-	Scrolling();
+	// The last step stands for the time the accumulator is behind now.
+	if ( nSteps > 0 ) RecordSnapshot( fNow - m_fAccumulator );
 
-	m_pPlayer->Draw();
-	m_pPlayer->DrawHeart();
-	m_pRacheta->Draw();
-	Crate->Draw();
-	Crate->drawcoins();
-	
-	m_pBBuffer->present();
+	return nSteps;
 }
-void CGameApp::SaveGame() {
 
-	SaveData data;
-	
-	data.posPlayer1 = m_pPlayer->Position();
-    data.posPlayer2 = m_pRacheta->Position();
-	std::ofstream DataInput("data/Text.txt");
-	DataInput.write((char*)&data, sizeof(data));
+//-----------------------------------------------------------------------------
+// Name : SimulateStep () (Private)
+// Desc : Advances the game by one fixed step of dt seconds.
+//-----------------------------------------------------------------------------
+void CGameApp::SimulateStep( float dt )
+{
+	// Collect what the window queued since the last step
+	CInputEvent input;
+	while ( m_Input.Pop( input ) )
+		HandleGameMessage( input.Message, input.wParam );
 
+	ULONG ulInput = (m_ulKeys & CGameWorld::INPUT_KEYS) | m_ulActions;
+	m_ulActions = 0;
 
-}
-void CGameApp::LoadGame() {
-	SaveData data;
-	std::ifstream DataInput("data/Text.txt");
-	DataInput.read((char*)&data, sizeof(data));
-	m_pPlayer->Position() = data.posPlayer1;
-	m_pRacheta->Position() = data.posPlayer2;
-}
-void CGameApp::Collision() {
-
-	static UINT fTimer;
-	double Distance = m_pPlayer->Position().Distance(m_pRacheta->Position());
-	if (Distance <= (m_pPlayer->getPlayerWidth() + m_pRacheta->getPlayerWidth())/2 && !m_pPlayer->CheckExplosion()&& !m_pRacheta->CheckExplosion()){
-		fTimer = SetTimer(m_hWnd, 1, 100, NULL);
-		m_pPlayer->Velocity() = Vec2(0, 0);
-		m_pPlayer->Explode();
-		m_pPlayer->Position() = Vec2(100, 400);
-		fTimer = SetTimer(m_hWnd, 2, 100, NULL);
-		m_pRacheta->Velocity() = Vec2(0, 0);
-		m_pRacheta->Explode();
-		m_pRacheta->Position() = Vec2(400, 400);
+	// A replay stands in for the live input; a recording keeps whatever
+	// was used, so a replay can be recorded again.
+	if ( m_Replay.IsOpen() )
+	{
+		uint32_t mask;
+		if ( m_Replay.Next( mask ) ) ulInput = mask;
+		else EndReplay();
 	}
+	m_Recorder.Record( ulInput );
 
+	m_World.Step( dt, ulInput );
 
-
-
+	// Out of lives; the window closes once
+	if ( m_World.IsOver() && !m_bGameOver )
+	{
+		m_bGameOver = true;
+		PostMessage( m_hWnd, WM_CLOSE, 0, 0 );
+	}
 }
-void CGameApp::BulletCrateCollision()
+
+//-----------------------------------------------------------------------------
+// Name : HandleGameMessage () (Private)
+// Desc : Turns a game key message the window passed on into input for this
+//		step; the world acts on it in CGameWorld::Step.
+//-----------------------------------------------------------------------------
+void CGameApp::HandleGameMessage( UINT Message, WPARAM wParam )
 {
-	std::vector <Sprite*> crates = Crate->getVectorCrate();
-	std::vector <Sprite*> bulletsC = m_pPlayer->getVectorCplayer();
-	std::vector <Sprite*> bulletsC2 = m_pRacheta->getVectorCplayer2();
-	int p1 = 0;
-	int p2 = 0;
-	int p3 = 0;
-	int p4 = 0;
-
-	for (Sprite* bullet : bulletsC)
+	switch (Message)
 	{
-		p1 = 0;
-		for (Sprite* cratev : crates)
-		{
-			double distance = cratev->mPosition.Distance(bullet->mPosition);
-			
-			if (distance <= (cratev->width() + bullet->width()) / 2)
+		case WM_GAME_MOVE:
+			m_ulKeys = (ULONG)wParam;
+			break;
+
+		case WM_KEYDOWN:
+			switch(wParam)
 			{
-				crates.erase(crates.begin() + p1);
-				Crate->updatecrate(crates);
-				bulletsC.erase(bulletsC.begin() + p2);
-				m_pPlayer->updatebullets(bulletsC);
-				Score=Score+100;
+			case VK_RETURN:
+				m_ulActions |= CGameWorld::INPUT_EXPLODE;
+				break;
+		
+			case 0x46:
+				m_ulActions |= CGameWorld::INPUT_FIRE2;
+				break;
 
-			}
 
+			}
+			break;
+		case WM_KEYUP: {
+			switch (wParam) {
+			case VK_SPACE:
+				m_ulActions |= CGameWorld::INPUT_FIRE;
+				break;
+			}
 
-			
-			p1++;
-		}
-		p2++;
-	}
-	for (Sprite* bullet : bulletsC2)
-	{
-		p3 = 0;
-		for (Sprite* cratev : crates)
+			}
+		case WM_CHAR:
 		{
-			double distance = cratev->mPosition.Distance(bullet->mPosition);
-
-			if (distance <= (cratev->width() + bullet->width()) / 2)
-			{
-				crates.erase(crates.begin() + p3);
-				Crate->updatecrate(crates);
-				bulletsC2.erase(bulletsC2.begin() + p4);
-				m_pRacheta->updatebullets2(bulletsC2);
-				Score2 = Score2 + 100;
+			switch (wParam) {
+			case 'q':
+				m_ulActions |= CGameWorld::INPUT_EXPLODE2;
+				break;
 
-			}
+			case 't':
+				m_ulActions |= CGameWorld::INPUT_ROTATE;
+				break;
 
+			case 'r': 
+				m_ulActions |= CGameWorld::INPUT_ROTATE_BACK;
+			case 'b':
+				m_ulActions |= CGameWorld::INPUT_ROTATE2;
+				break;
+			case 'n':
+				m_ulActions |= CGameWorld::INPUT_ROTATE2_BACK;
+				break;
+			case 'h':
+				m_ulActions |= CGameWorld::INPUT_SAVE;
+				break;
+			case 'g':
+				m_ulActions |= CGameWorld::INPUT_LOAD;
+				break;
 
+			}
+			
+			
+		
 
-			p3++;
 		}
-		p4++;
+		break;
 	}
 }
 
-void CGameApp::PlaneCrateCollision()
+//-----------------------------------------------------------------------------
+// Name : SetupInputLog () (Private)
+// Desc : Opens the recording or replay asked for on the command line and
+//		seeds the game's random numbers. Returns false if a replay was asked
+//		for and cannot be read.
+//-----------------------------------------------------------------------------
+bool CGameApp::SetupInputLog()
 {
-	std::vector <Sprite*> crates = Crate->getVectorCrate();
-	int p1 = 0, p2=0;
-	for (Sprite* cratev : crates)
+	TCHAR szFile[MAX_PATH];
+	TCHAR szSeed[32];
+
+	// Live games differ every time unless given a seed
+	uint64_t seed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+	if ( CommandLineString( m_szCmdLine, _T("-seed:"), szSeed, 32 ) )
+		seed = strtoull( szSeed, NULL, 10 );
+
+	strcpy_s( szFile, MAX_PATH, "data/session.rec" );
+	if ( CommandLineString( m_szCmdLine, _T("-replay"), szFile, MAX_PATH ) )
 	{
-		double distance = cratev->mPosition.Distance(m_pPlayer->Position());
-		if (distance <= (cratev->width() + m_pPlayer->getPlayerWidth()) / 2 && !m_pPlayer->CheckExplosion())
+		// "-replay:file", or just "-replay" for the default file
+		LPTSTR szName = szFile[0] == ':' ? szFile + 1 : szFile;
+		if ( !m_Replay.Open( szName ) )
 		{
-			SetTimer(m_hWnd, 1, 50, NULL);
-			m_pPlayer->Velocity() = Vec2(0, 0);
-			m_pPlayer->Explode();
-			m_pPlayer->Position() = Vec2(100, 400);
-			
-			crates.erase(crates.begin() + p1);
-			Crate->updatecrate(crates);
-			Lives--;
-			LifeSpawn();
-			if (Lives <= 0) {
-				PostQuitMessage(0);
-			}
-			
+			MessageBox( 0, _T("Could not read the input recording."), _T("Replay"), MB_OK | MB_ICONSTOP );
+			return false;
 		}
-		p1++;
 
+		m_fTickRate = m_Replay.GetHeader().TickRate;
+		seed = m_Replay.GetHeader().Seed;
 	}
-	for (Sprite* cratev : crates)
-	{
-		double distance = cratev->mPosition.Distance(m_pRacheta->Position());
-		if (distance <= (cratev->width() + m_pRacheta->getPlayerWidth()) / 2 && !m_pRacheta->CheckExplosion())
-		{
-			SetTimer(m_hWnd, 2, 50, NULL);
-			m_pRacheta->Velocity() = Vec2(0, 0);
-			m_pRacheta->Explode();
-			m_pRacheta->Position() = Vec2(400, 400);
-
-			crates.erase(crates.begin() + p2);
-			Crate->updatecrate(crates);
-			Lives2--;
-			LifeSpawn();
-			if (Lives2 <= 0) {
-				PostQuitMessage(0);
-			}
-
-		}
-		p2++;
 
+	strcpy_s( szFile, MAX_PATH, "data/session.rec" );
+	if ( CommandLineString( m_szCmdLine, _T("-record"), szFile, MAX_PATH ) )
+	{
+		LPTSTR szName = szFile[0] == ':' ? szFile + 1 : szFile;
+
+		CInputLogHeader header;
+		header.Version	= CInputLogHeader::VERSION;
+		header.TickRate	= m_fTickRate;
+		header.Seed		= seed;
+		if ( !m_Recorder.Open( szName, header ) )
+			OutputDebugString( _T("Could not create the input recording.\n") );
 	}
+
+	m_nSeed = seed;
+	return true;
 }
-void CGameApp::FishCoinCollision()
+
+//-----------------------------------------------------------------------------
+// Name : EndReplay () (Private)
+// Desc : The recording ran out; the session is over.
+//-----------------------------------------------------------------------------
+void CGameApp::EndReplay()
 {
-	std::vector <Sprite*> crates = Crate->getVectorCoin();
-	int p1 = 0, p2 = 0;
-	for (Sprite* cratev : crates)
-	{
-		double distance = cratev->mPosition.Distance(m_pPlayer->Position());
-		if (distance <= (cratev->width() + m_pPlayer->getPlayerWidth()) / 2 && !m_pPlayer->CheckExplosion())
-		{
-			
+	TCHAR szReplay[128];
+	_stprintf_s( szReplay, _T("Replay: finished after %lu steps\n"), (ULONG)m_Replay.GetStepCount() );
+	OutputDebugString( szReplay );
 
-			crates.erase(crates.begin() + p1);
-			Crate->updatevectorcoin(crates);
-			
-			Score = Score + 500;
-		}
-		p1++;
+	m_Replay.Close();
+	PostMessage( m_hWnd, WM_CLOSE, 0, 0 );
+}
 
-	}
-	for (Sprite* cratev : crates)
-	{
-		double distance = cratev->mPosition.Distance(m_pRacheta->Position());
-		if (distance <= (cratev->width() + m_pRacheta->getPlayerWidth()) / 2 && !m_pRacheta->CheckExplosion())
-		{
+//-----------------------------------------------------------------------------
+// Name : PostInput () (Private)
+// Desc : Queues a message for the simulation. Window thread only.
+//-----------------------------------------------------------------------------
+bool CGameApp::PostInput( UINT Message, WPARAM wParam )
+{
+	CInputEvent input;
+	input.Message = Message;
+	input.wParam = wParam;
+	return m_Input.Push( input );
+}
 
+//-----------------------------------------------------------------------------
+// Name : RecordSnapshot () (Private)
+// Desc : Records the world as the last step left it and publishes it to the
+//		renderer. fTime is the clock time the step stands for.
+//-----------------------------------------------------------------------------
+void CGameApp::RecordSnapshot( double fTime )
+{
+	PROFILE_ZONE("RecordSnapshot");
 
-			crates.erase(crates.begin() + p2);
-			Crate->updatevectorcoin(crates);
+	CWorldSnapshot& frame = m_Snapshots.GetWriteBuffer();
+	frame.Clear();
 
-			Score2 = Score2 + 500;
-		}
-		p2++;
+	m_World.Record( frame );
+	frame.Time			= fTime;
 
-	}
+	m_Snapshots.Publish();
 }
 
-void CGameApp::FishUpgrade() {
-	if (Score >= 1000) {
-		m_pPlayer->lvl1();
-		
-	}
-	if (Score >= 5000) {
-		m_pPlayer->lvl2();
-		
-	}
-	if (Score2 >= 1000) {
-		
-		m_pRacheta->lvl21();
-	}
-	if (Score2 >= 5000) {
-		
-		m_pRacheta->lvl22();
+//-----------------------------------------------------------------------------
+// Name : SaveFrameStats () (Private)
+// Desc : Writes the frame time percentiles and histogram to data/, as CSV
+//		with -stats:csv and JSON otherwise, and logs the summary.
+//-----------------------------------------------------------------------------
+void CGameApp::SaveFrameStats()
+{
+	const char* szFileName = strstr( m_szCmdLine, "-stats:csv" ) ? "data/frametimes.csv" : "data/frametimes.json";
+	if ( !m_Timer.SaveFrameStats( szFileName ) ) return;
+
+	CFrameStats stats = m_Timer.GetFrameStats();
+	TCHAR szStats[256];
+	_stprintf_s( szStats, _T("Frames: %lu, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms, %lu over %.1f ms\n"),
+		(ULONG)stats.Count, stats.P50 * 1000.0, stats.P90 * 1000.0, stats.P99 * 1000.0, stats.P999 * 1000.0,
+		stats.Max * 1000.0, (ULONG)stats.Hitches, stats.Budget * 1000.0 );
+	OutputDebugString( szStats );
+
+	// With -fps:N, also how closely frames kept to that rate
+	CPacingStats pacing = m_Timer.GetPacingStats();
+	if ( pacing.Frames > 0 )
+	{
+		_stprintf_s( szStats, _T("Pacing: %.3f ms target, %.3f ms achieved, jitter p50 %.3f ms p99 %.3f ms max %.3f ms, margin %.3f ms, %lu late wakes\n"),
+			pacing.TargetPeriod * 1000.0, pacing.MeanPeriod * 1000.0, pacing.JitterP50 * 1000.0, pacing.JitterP99 * 1000.0,
+			pacing.JitterMax * 1000.0, pacing.SleepMargin * 1000.0, pacing.LateWakes );
+		OutputDebugString( szStats );
 	}
 }
 
-void CGameApp::LifeSpawn()
+//-----------------------------------------------------------------------------
+// Name : ProcessInput () (Private)
+// Desc : Simply polls the input devices and performs basic input operations.
+//		Window thread; the keys are queued for the simulation.
+//-----------------------------------------------------------------------------
+void CGameApp::ProcessInput()
 {
+	PROFILE_ZONE("ProcessInput");
 
+	UCHAR		pKeyBuffer[256];
+	ULONG		Direction = 0;
+	ULONG       Direction2 = 0;
+	POINT		CursorPos;
+	float		X = 0.0f, Y = 0.0f;
 
+	// Retrieve keyboard state
+	if (!GetKeyboardState(pKeyBuffer)) return;
 
-	if (Lives <= 2)
+	// Check the relevant keys
+	if (pKeyBuffer[VK_UP] & 0xF0) Direction |= CPlayer::DIR_FORWARD;
+	if (pKeyBuffer[VK_DOWN] & 0xF0) Direction |= CPlayer::DIR_BACKWARD;
+	if (pKeyBuffer[VK_LEFT] & 0xF0) Direction |= CPlayer::DIR_LEFT;
+	if (pKeyBuffer[VK_RIGHT] & 0xF0) Direction |= CPlayer::DIR_RIGHT;
+
+	if (pKeyBuffer[0x57] & 0xF0) Direction2 |= CPlayer2::DIR_FORWARD;
+	if (pKeyBuffer[0x53] & 0xF0) Direction2 |= CPlayer2::DIR_BACKWARD;
+	if (pKeyBuffer[0x41] & 0xF0) Direction2 |= CPlayer2::DIR_LEFT;
+	if (pKeyBuffer[0x44] & 0xF0) Direction2 |= CPlayer2::DIR_RIGHT;
+
+	// Only changes are queued; the simulation keeps moving the players
+	// with the last keys it got.
+	ULONG Keys = Direction | (Direction2 << 8);
+	if (Keys != m_ulKeysSent && PostInput(WM_GAME_MOVE, Keys))
+		m_ulKeysSent = Keys;
+
+	// Now process the mouse (if the button is pressed)
+	if ( GetCapture() == m_hWnd )
 	{
-		m_pPlayer->SpawnHeart();
-		
-	}
-	
+		// Hide the mouse pointer
+		SetCursor( NULL );
+
+		// Retrieve the cursor position
+		GetCursorPos( &CursorPos );
+
+		// Reset our cursor position so we can keep going forever :)
+		SetCursorPos( m_OldCursorPos.x, m_OldCursorPos.y );
 
+	} // End if Captured
 }
-void CGameApp::HeartCollision()
+
+//-----------------------------------------------------------------------------
+// Name : DrawObjects () (Private)
+// Desc : Draws a snapshot of the game objects, fAlpha of the way from the
+//		step before it to its own.
+//-----------------------------------------------------------------------------
+void CGameApp::DrawObjects( const CWorldSnapshot& frame, float fAlpha )
 {
-	int i = 0;
-	std::vector<Sprite*> heartsSpawn = m_pPlayer->GetVectorHeart();
-	for (Sprite* heart : heartsSpawn)
-	{
-		double distance = heart->mPosition.Distance(m_pPlayer->Position());
-		if (distance <= (heart->width() + m_pPlayer->getPlayerWidth()) / 2)
-		{
-			Lives++;
-			heartsSpawn.erase(heartsSpawn.begin() + i);
-			m_pPlayer->UpdateVectorHeart(heartsSpawn);
-		}
-		i++;
-	}
+	PROFILE_ZONE("DrawObjects");
+
+	m_pBBuffer->reset();
+
+	m_Background.SetOffset(frame.ScrollOffset);
+	Scrolling();
+
+	frame.Draw(*m_pBBuffer, fAlpha);
+	
+	m_pBBuffer->present();
 }
 void CGameApp::Scrolling() {
-	m_imgBackground.Paint(m_pBBuffer->getDC(), 0, y);
-	y++;
-	if (y == 0)
-		y = -600;
+	CPixelSurface surface = m_pBBuffer->getSurface();
+
+	if (m_Background.HasMoved())
+	{
+		// New rows are visible, the whole frame changes.
+		m_Background.Paint(surface);
+		m_pBBuffer->markAllDirty();
+		return;
+	}
+
+	// Same rows as last frame, only put back what reset() erased.
+	const std::vector<CRect>& rects = m_pBBuffer->getDirtyRegion().Rects();
+	for (size_t i = 0; i < rects.size(); i++)
+		m_Background.Paint(surface, rects[i]);
 }
\ No newline at end of file
@@ -11,18 +11,41 @@
 // CPlayer Specific Includes
 //-----------------------------------------------------------------------------
 #include "CPlayer.h"
+#include <float.h>
 #include <vector>
 #include <vector>
 
+//-----------------------------------------------------------------------------
+// Skins for every upgrade level, in RotateSprite order (up, right, down, left).
+// They are all loaded when the player is built, so rotating or upgrading
+// never touches the disk.
+//-----------------------------------------------------------------------------
+static const char* const s_PlayerSkins[CPlayer::LEVEL_COUNT][4] =
+{
+	{ "data/PlaneImgAndMask.bmp", "data/PlaneImgAndMaskRight.bmp", "data/PlaneImgAndMaskDown.bmp", "data/PlaneImgAndMaskLeft.bmp" },
+	{ "data/peste.bmp", "data/pesteright.bmp", "data/pestedown.bmp", "data/pesteleft.bmp" },
+	{ "data/rechin.bmp", "data/rechin.bmp", "data/rechin.bmp", "data/rechin.bmp" }
+};
+
 //-----------------------------------------------------------------------------
 // Name : CPlayer () (Constructor)
 // Desc : CPlayer Class Constructor
 //-----------------------------------------------------------------------------
-CPlayer::CPlayer(const BackBuffer *pBackBuffer)
+CPlayer::CPlayer()
+	: m_BulletPool("data/bullet.bmp", RGB(0xff, 0x00, 0xff)),
+	  m_HeartPool("data/inimaa.bmp", RGB(0xff, 0x00, 0xff))
 {
 	//m_pSprite = new Sprite("data/planeimg.bmp", "data/planemask.bmp");
 	m_pSprite = new Sprite("data/PlaneImgAndMask.bmp", RGB(0xff,0x00, 0xff));
-	m_pSprite->setBackBuffer( pBackBuffer );
+
+	// Preload every level / orientation, skin index is level * 4 + orientation.
+	for (int iLevel = 0; iLevel < LEVEL_COUNT; iLevel++)
+		for (int iOrientation = 0; iOrientation < 4; iOrientation++)
+			m_pSprite->addSkin(s_PlayerSkins[iLevel][iOrientation]);
+	m_iLevel = LEVEL_START;
+	m_iOrientation = 0;
+	m_pSprite->setSkin(0);
+
 	m_eSpeedState = SPEED_STOP;
 	m_fTimer = 0;
 
@@ -34,12 +57,11 @@ CPlayer::CPlayer(const BackBuffer *pBackBuffer)
 	r.bottom = 128;
 
 	m_pExplosionSprite	= new AnimatedSprite("data/explosion.bmp", "data/explosionmask.bmp", r, 16);
-	m_pExplosionSprite->setBackBuffer( pBackBuffer );
 	m_bExplosion		= false;
 	m_iExplosionFrame	= 0;
 
-	this->pBackBuffer = pBackBuffer;
-	
+	Bullets.SetPool(&m_BulletPool);
+	heart.SetPool(&m_HeartPool);
 }
 
 //-----------------------------------------------------------------------------
@@ -57,16 +79,9 @@ void CPlayer::Update(float dt)
 {
 	// Update sprite
 	m_pSprite->update(dt);
-	int it = 0;
-	RECT Desktop;
-	GetWindowRect(GetDesktopWindow(), &Desktop);
-	for (Sprite* Bullet : Bullets) {
-		Bullet->update(dt);
-		if (Bullet->mPosition.y > Desktop.bottom) {
-			Bullets.erase(Bullets.begin() + it);
-		}
-		it++;
-	}
+	// Bullets fly up; the ones past the top of the screen are freed at
+	// the end of the frame.
+	Bullets.Update(dt, -(float)m_BulletPool.GetHeight(), FLT_MAX);
 
 
 	// Get velocity
@@ -113,18 +128,14 @@ void CPlayer::Update(float dt)
 	// http://www.codeproject.com/KB/audio-video/midiwrapper.aspx (with code also)
 }
 
-void CPlayer::Draw()
+void CPlayer::Draw(CWorldSnapshot& frame)
 {
 	if(!m_bExplosion)
-		m_pSprite->draw();
+		m_pSprite->draw(frame);
 	else
-		m_pExplosionSprite->draw();
+		m_pExplosionSprite->draw(frame);
 
-	for (Sprite* Bullet : Bullets) {
-		Bullet->setBackBuffer(pBackBuffer);
-		Bullet->draw();
-		
-	}
+	Bullets.Draw(frame);
 	
 		
 }
@@ -192,22 +203,16 @@ bool CPlayer::AdvanceExplosion()
 }
 
 void CPlayer::BulletExplosion() {
-	Bullets.push_back(new Sprite("data/bullet.bmp", RGB(0xff, 0x00, 0xff)));
-	Bullets.back()->mPosition = m_pSprite->mPosition;
-	Bullets.back()->mVelocity.y = -1000;
+	Bullets.Add(m_BulletPool.Acquire(), (float)m_pSprite->mPosition.x, (float)m_pSprite->mPosition.y, 0.0f, -1000.0f);
 
 }
 
 void CPlayer::RotateSprite(int i)
 {
-	std::vector<char*> Rotate;
+	assert(i >= 0 && i < 4);
 
-	Rotate.push_back("data/PlaneImgAndMask.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskRight.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskDown.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskLeft.bmp");
-
-	m_pSprite->setSprite(Rotate.at(i), RGB(0xff, 0x00, 0xff));
+	m_iOrientation = i;
+	m_pSprite->setSkin(m_iLevel * 4 + m_iOrientation);
 }
 double CPlayer::getPlayerWidth() {
 	return m_pSprite->width();
@@ -218,48 +223,39 @@ bool CPlayer::CheckExplosion() {
 	else return false;
 
 }
-std::vector<Sprite*> CPlayer::getVectorCplayer()
+void CPlayer::Flush()
 {
-	return Bullets;
+	Bullets.Flush();
+	heart.Flush();
 }
 
-void CPlayer::updatebullets(std::vector <Sprite*> bulletsP1)
+void CPlayer::ReservePools(size_t nBullets, size_t nHearts)
 {
-	this->Bullets = bulletsP1;
+	m_BulletPool.Reserve(nBullets);
+	m_HeartPool.Reserve(nHearts);
+	Bullets.Reserve(nBullets);
+	heart.Reserve(nHearts);
 }
-void CPlayer::lvl1() {
+void CPlayer::SetLevel(int iLevel)
+{
+	assert(iLevel >= 0 && iLevel < LEVEL_COUNT);
 
+	// Only real transitions switch the skin.
+	if(iLevel == m_iLevel)
+		return;
 
-	m_pSprite->setSprite("data/peste.bmp", RGB(0xff, 0x00, 0xff));
+	m_iLevel = iLevel;
+	m_pSprite->setSkin(m_iLevel * 4 + m_iOrientation);
 }
-void CPlayer::lvl2() {
-
 
-	m_pSprite->setSprite("data/rechin.bmp", RGB(0xff, 0x00, 0xff));
+void CPlayer::SpawnHeart(CRandom& random) {
+	float x = (float)(random.Range(700) + 100);
+	float y = (float)(random.Range(300) + 100);
+	heart.Add(m_HeartPool.Acquire(), x, y);
 }
-
-void CPlayer::SpawnHeart() {
-	heart.push_back(new Sprite("data/inimaa.bmp", RGB(0xff, 0x00, 0xff)));
-	heart.back()->mPosition.x = rand() % 700 + 100;
-	heart.back()->mPosition.y = rand() % 300 + 100;
-}
-void CPlayer::DrawHeart() {
-	for (Sprite* inima : heart) {
-		inima->setBackBuffer(pBackBuffer);
-		inima->draw();
-
-	}
+void CPlayer::DrawHeart(CWorldSnapshot& frame) {
+	heart.Draw(frame);
 }
 void CPlayer::UpdateHeart(float dt) {
-	for (Sprite* inima : heart) {
-		inima->update(dt);
-
-	}
-}
-std::vector<Sprite*> CPlayer::GetVectorHeart() {
-	return heart;
-
+	heart.Update(dt, -FLT_MAX, FLT_MAX);
 }
-void CPlayer::UpdateVectorHeart(std::vector<Sprite*> heart) {
-	this->heart = heart;
-}
\ No newline at end of file
@@ -11,17 +11,39 @@
 // CPlayer Specific Includes
 //-----------------------------------------------------------------------------
 #include "CPlayer2.h"
+#include <float.h>
 #include <vector>
 
+//-----------------------------------------------------------------------------
+// Skins for every upgrade level, in RotateSprite order (up, right, down, left).
+// They are all loaded when the player is built, so rotating or upgrading
+// never touches the disk.
+//-----------------------------------------------------------------------------
+static const char* const s_Player2Skins[CPlayer2::LEVEL_COUNT][4] =
+{
+	{ "data/racheta.bmp", "data/rachetaright.bmp", "data/rachetadown.bmp", "data/rachetaleft.bmp" },
+	{ "data/peste.bmp", "data/pesteright.bmp", "data/pestedown.bmp", "data/pesteleft.bmp" },
+	{ "data/rechin.bmp", "data/rechin.bmp", "data/rechin.bmp", "data/rechin.bmp" }
+};
+
 //-----------------------------------------------------------------------------
 // Name : CPlayer () (Constructor)
 // Desc : CPlayer Class Constructor
 //-----------------------------------------------------------------------------
-CPlayer2::CPlayer2(const BackBuffer* pBackBuffer)
+CPlayer2::CPlayer2()
+	: m_BulletPool("data/bullet.bmp", RGB(0xff, 0x00, 0xff))
 {
 	//m_pSprite = new Sprite("data/planeimg.bmp", "data/planemask.bmp");
 	m_pSprite = new Sprite("data/racheta.bmp", RGB(0xff, 0x00, 0xff));
-	m_pSprite->setBackBuffer(pBackBuffer);
+
+	// Preload every level / orientation, skin index is level * 4 + orientation.
+	for (int iLevel = 0; iLevel < LEVEL_COUNT; iLevel++)
+		for (int iOrientation = 0; iOrientation < 4; iOrientation++)
+			m_pSprite->addSkin(s_Player2Skins[iLevel][iOrientation]);
+	m_iLevel = LEVEL_START;
+	m_iOrientation = 0;
+	m_pSprite->setSkin(0);
+
 	m_eSpeedState = SPEED_STOP;
 	m_fTimer = 0;
 
@@ -33,13 +55,10 @@ CPlayer2::CPlayer2(const BackBuffer* pBackBuffer)
 	r.bottom = 128;
 
 	m_pExplosionSprite = new AnimatedSprite("data/explosion.bmp", "data/explosionmask.bmp", r, 16);
-	m_pExplosionSprite->setBackBuffer(pBackBuffer);
 	m_bExplosion = false;
 	m_iExplosionFrame = 0;
 
-	
-	this->pBackBuffer = pBackBuffer;
-
+	Bullets.SetPool(&m_BulletPool);
 }
 
 //-----------------------------------------------------------------------------
@@ -57,16 +76,9 @@ void CPlayer2::Update(float dt)
 {
 	// Update sprite
 	m_pSprite->update(dt);
-	int it = 0;
-	RECT Desktop;
-	GetWindowRect(GetDesktopWindow(), &Desktop);
-	for (Sprite* Bullet : Bullets) {
-		Bullet->update(dt);
-		if (Bullet->mPosition.y > Desktop.bottom) {
-			Bullets.erase(Bullets.begin() + it);
-		}
-		it++;
-	}
+	// Bullets fly up; the ones past the top of the screen are freed at
+	// the end of the frame.
+	Bullets.Update(dt, -(float)m_BulletPool.GetHeight(), FLT_MAX);
 
 	// Get velocity
 	double v = m_pSprite->mVelocity.Magnitude();
@@ -112,18 +124,14 @@ void CPlayer2::Update(float dt)
 	// http://www.codeproject.com/KB/audio-video/midiwrapper.aspx (with code also)
 }
 
-void CPlayer2::Draw()
+void CPlayer2::Draw(CWorldSnapshot& frame)
 {
 	if (!m_bExplosion)
-		m_pSprite->draw();
+		m_pSprite->draw(frame);
 	else
-		m_pExplosionSprite->draw();
-
-	for (Sprite* Bullet : Bullets) {
-		Bullet->setBackBuffer(pBackBuffer);
-		Bullet->draw();
+		m_pExplosionSprite->draw(frame);
 
-	}
+	Bullets.Draw(frame);
 }
 
 void CPlayer2::Move(ULONG ulDirection2)
@@ -190,9 +198,7 @@ bool CPlayer2::AdvanceExplosion()
 }
 
 void CPlayer2::BulletExplosion() {
-	Bullets.push_back(new Sprite("data/bullet.bmp", RGB(0xff, 0x00, 0xff)));
-	Bullets.back()->mPosition = m_pSprite->mPosition;
-	Bullets.back()->mVelocity.y = -1000;
+	Bullets.Add(m_BulletPool.Acquire(), (float)m_pSprite->mPosition.x, (float)m_pSprite->mPosition.y, 0.0f, -1000.0f);
 
 }
 double CPlayer2::getPlayerWidth() {
@@ -207,30 +213,29 @@ bool CPlayer2::CheckExplosion() {
 
 void CPlayer2::RotateSprite(int i)
 {
-	std::vector<char*> Rotate;
+	assert(i >= 0 && i < 4);
 
-	Rotate.push_back("data/PlaneImgAndMask.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskRight.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskDown.bmp");
-	Rotate.push_back("data/PlaneImgAndMaskLeft.bmp");
-
-	m_pSprite->setSprite(Rotate.at(i), RGB(0xff, 0x00, 0xff));
+	m_iOrientation = i;
+	m_pSprite->setSkin(m_iLevel * 4 + m_iOrientation);
 }
-std::vector<Sprite*> CPlayer2::getVectorCplayer2()
+void CPlayer2::SetLevel(int iLevel)
 {
-	return Bullets;
-}
-void CPlayer2::lvl21() {
+	assert(iLevel >= 0 && iLevel < LEVEL_COUNT);
 
+	// Only real transitions switch the skin.
+	if(iLevel == m_iLevel)
+		return;
 
-	m_pSprite->setSprite("data/peste.bmp", RGB(0xff, 0x00, 0xff));
+	m_iLevel = iLevel;
+	m_pSprite->setSkin(m_iLevel * 4 + m_iOrientation);
 }
-void CPlayer2::lvl22() {
-
-
-	m_pSprite->setSprite("data/rechin.bmp", RGB(0xff, 0x00, 0xff));
+void CPlayer2::Flush()
+{
+	Bullets.Flush();
 }
-void CPlayer2::updatebullets2(std::vector <Sprite*> bulletsP1)
+
+void CPlayer2::ReservePools(size_t nBullets)
 {
-	this->Bullets = bulletsP1;
+	m_BulletPool.Reserve(nBullets);
+	Bullets.Reserve(nBullets);
 }
\ No newline at end of file
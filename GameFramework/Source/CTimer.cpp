@@ -39,6 +39,10 @@ CTimer::CTimer()
 
 	// Clear any needed values
 	m_SampleCount		= 0;
+	m_SampleNext		= 0;
+	m_SampleTotal		= 0.0;
+	m_TimeElapsed		= 0.0f;
+	m_FrameDelta		= 0.0f;
 	m_FrameRate			= 0;
 	m_FPSFrameCount		= 0;
 	m_FPSTimeElapsed	= 0.0f;
@@ -62,6 +66,11 @@ void CTimer::Tick( float fLockFPS )
 {
 	float fTimeElapsed; 
 
+	// Should we lock the frame rate ? Sleep through most of the time left,
+	// and only spin for the last moment.
+	if ( fLockFPS > 0.0f ) m_Pacer.Pace( 1.0 / fLockFPS );
+	else m_Pacer.Reset();
+
 	// Is performance hardware available?
 	if ( m_PerfHardware ) 
 	{
@@ -80,41 +89,26 @@ void CTimer::Tick( float fLockFPS )
 
 	// Smoothly ramp up frame rate to prevent jittering
 	//if ( fLockFPS == 0.0f ) fLockFPS = (1.0f / GetTimeElapsed()) + 20.0f;
-	
-	// Should we lock the frame rate ?
-	if ( fLockFPS > 0.0f )
-	{
-		while ( fTimeElapsed < (1.0f / fLockFPS))
-		{
-			// Is performance hardware available?
-			if ( m_PerfHardware ) 
-			{
-				// Query high-resolution performance hardware
-				QueryPerformanceCounter((LARGE_INTEGER*)&m_CurrentTime);
-			} 
-			else 
-			{
-				// Fall back to less accurate timer
-				m_CurrentTime = timeGetTime();
-
-			} // End If no hardware available
-
-			// Calculate elapsed time in seconds
-			fTimeElapsed = (m_CurrentTime - m_LastTime) * m_TimeScale;
-
-		} // End While
-	} // End If
 
 	// Save current frame time
 	m_LastTime = m_CurrentTime;
+	m_FrameDelta = fTimeElapsed;
+
+	// Every frame counts towards the statistics, hitches most of all
+	m_History.Add( fTimeElapsed );
 
 	// Filter out values wildly different from current average
 	if ( fabsf(fTimeElapsed - m_TimeElapsed) < 1.0f  )
 	{
-		// Wrap FIFO frame time buffer.
-		memmove( &m_FrameTime[1], m_FrameTime, (MAX_SAMPLE_COUNT - 1) * sizeof(float) );
-		m_FrameTime[ 0 ] = fTimeElapsed;
-		if ( m_SampleCount < MAX_SAMPLE_COUNT ) m_SampleCount++;
+		// Replace the oldest sample in the ring, keeping the sum in step.
+		// The sum is a double, which adds up float frame times exactly, so
+		// it does not drift however long the game runs.
+		if ( m_SampleCount == MAX_SAMPLE_COUNT ) m_SampleTotal -= m_FrameTime[ m_SampleNext ];
+		else m_SampleCount++;
+
+		m_FrameTime[ m_SampleNext ] = fTimeElapsed;
+		m_SampleTotal += fTimeElapsed;
+		m_SampleNext = (m_SampleNext + 1) % MAX_SAMPLE_COUNT;
 
 	} // End if
 	
@@ -129,10 +123,8 @@ void CTimer::Tick( float fLockFPS )
 		m_FPSTimeElapsed	= 0.0f;
 	} // End If Second Elapsed
 
-	// Count up the new average elapsed time
-	m_TimeElapsed = 0.0f;
-	for ( ULONG i = 0; i < m_SampleCount; i++ ) m_TimeElapsed += m_FrameTime[ i ];
-	if ( m_SampleCount > 0 ) m_TimeElapsed /= m_SampleCount;
+	// The new average elapsed time
+	if ( m_SampleCount > 0 ) m_TimeElapsed = (float)(m_SampleTotal / m_SampleCount);
 
 }
 
@@ -164,3 +156,74 @@ float CTimer::GetTimeElapsed() const
 {
 	return m_TimeElapsed;
 }
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameDelta () 
+// Desc : Returns the time actually measured for the last frame (Seconds),
+//		without the smoothing GetTimeElapsed applies.
+//-----------------------------------------------------------------------------
+float CTimer::GetFrameDelta() const
+{
+	return m_FrameDelta;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Restart () 
+// Desc : Makes the next Tick measure from now, and clears the frame time
+//		statistics. Time spent loading is not a frame.
+//-----------------------------------------------------------------------------
+void CTimer::Restart()
+{
+	Resume();
+	m_History.Clear();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Resume () 
+// Desc : Makes the next Tick measure from now, e.g. after the window was
+//		minimized, so the pause does not show up as one very long frame.
+//-----------------------------------------------------------------------------
+void CTimer::Resume()
+{
+	if ( m_PerfHardware ) QueryPerformanceCounter((LARGE_INTEGER *)&m_LastTime);
+	else m_LastTime = timeGetTime();
+
+	m_Pacer.Reset();
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetHitchBudget () 
+// Desc : Frames taking longer than this many seconds count as hitches.
+//-----------------------------------------------------------------------------
+void CTimer::SetHitchBudget( float fSeconds )
+{
+	m_History.SetBudget( fSeconds );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameStats () 
+// Desc : Percentiles, extremes and hitch count of the frames since Restart.
+//-----------------------------------------------------------------------------
+CFrameStats CTimer::GetFrameStats() const
+{
+	return m_History.GetStats();
+}
+
+//-----------------------------------------------------------------------------
+// Name : SaveFrameStats () 
+// Desc : Writes the frame time statistics and histogram, as CSV if the name
+//		ends in .csv and as JSON otherwise.
+//-----------------------------------------------------------------------------
+bool CTimer::SaveFrameStats( const char* szFileName ) const
+{
+	return m_History.Save( szFileName );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetPacingStats () 
+// Desc : Achieved against target frame period, while the rate is locked.
+//-----------------------------------------------------------------------------
+CPacingStats CTimer::GetPacingStats() const
+{
+	return m_Pacer.GetStats();
+}
@@ -0,0 +1,120 @@
+// DirtyRegion.cpp
+// Tracks which parts of the back buffer changed during a frame.
+#include "DirtyRegion.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// CRect Member Functions
+//-----------------------------------------------------------------------------
+CRect CRect::Union(const CRect& r) const
+{
+	if(IsEmpty()) return r;
+	if(r.IsEmpty()) return *this;
+
+	return CRect(std::min(Left, r.Left), std::min(Top, r.Top), std::max(Right, r.Right), std::max(Bottom, r.Bottom));
+}
+
+CRect CRect::Intersect(const CRect& r) const
+{
+	return CRect(std::max(Left, r.Left), std::max(Top, r.Top), std::min(Right, r.Right), std::min(Bottom, r.Bottom));
+}
+
+//-----------------------------------------------------------------------------
+// CDirtyRegion Member Functions
+//-----------------------------------------------------------------------------
+CDirtyRegion::CDirtyRegion()
+{
+	m_Area = 0;
+	m_fFullThreshold = 0.5f;
+	m_bFull = false;
+}
+
+void CDirtyRegion::SetBounds(int width, int height)
+{
+	m_Bounds = CRect(0, 0, width, height);
+	Clear();
+}
+
+void CDirtyRegion::Clear()
+{
+	m_Rects.clear();
+	m_Area = 0;
+	m_bFull = false;
+}
+
+void CDirtyRegion::AddFull()
+{
+	m_Rects.assign(1, m_Bounds);
+	m_Area = m_Bounds.Area();
+	m_bFull = true;
+}
+
+void CDirtyRegion::Add(const CRect& rc)
+{
+	if(m_bFull)
+		return;
+
+	CRect r = rc.Intersect(m_Bounds);
+	if(r.IsEmpty())
+		return;
+
+	// Swallow every rectangle that overlaps, or is close enough that one
+	// copy of the union costs about the same as two separate copies.
+	// Merging can grow r into new neighbours, so scan until stable.
+	bool bMerged = true;
+	while(bMerged)
+	{
+		bMerged = false;
+		for(size_t i = 0; i < m_Rects.size(); i++)
+		{
+			CRect u = r.Union(m_Rects[i]);
+			if(u.Area() <= r.Area() + m_Rects[i].Area() + (u.Width() + u.Height()) * 4)
+			{
+				r = u;
+				m_Rects[i] = m_Rects.back();
+				m_Rects.pop_back();
+				bMerged = true;
+				break;
+			}
+		}
+	}
+
+	m_Rects.push_back(r);
+	while(m_Rects.size() > MAX_RECTS)
+		MergeClosestPair();
+
+	UpdateArea();
+}
+
+void CDirtyRegion::MergeClosestPair()
+{
+	// Merge the pair whose union wastes the fewest clean pixels.
+	size_t bestA = 0, bestB = 1;
+	long bestWaste = -1;
+	for(size_t a = 0; a < m_Rects.size(); a++)
+		for(size_t b = a + 1; b < m_Rects.size(); b++)
+		{
+			long waste = m_Rects[a].Union(m_Rects[b]).Area() - m_Rects[a].Area() - m_Rects[b].Area();
+			if(bestWaste < 0 || waste < bestWaste)
+			{
+				bestWaste = waste;
+				bestA = a;
+				bestB = b;
+			}
+		}
+
+	m_Rects[bestA] = m_Rects[bestA].Union(m_Rects[bestB]);
+	m_Rects[bestB] = m_Rects.back();
+	m_Rects.pop_back();
+}
+
+void CDirtyRegion::UpdateArea()
+{
+	m_Area = 0;
+	for(size_t i = 0; i < m_Rects.size(); i++)
+		m_Area += m_Rects[i].Area();
+
+	// Past the threshold a single full copy is cheaper.
+	if(m_Area >= (long)(m_fFullThreshold * m_Bounds.Area()))
+		AddFull();
+}
@@ -1,13 +1,17 @@
 #include "Enemy.h"
+#include <float.h>
 
 
 //-----------------------------------------------------------------------------
 // Name : CPlayer () (Constructor)
 // Desc : CPlayer Class Constructor
 //-----------------------------------------------------------------------------
-Enemy::Enemy(const BackBuffer* pBackBuffer)
+Enemy::Enemy()
+	: cratePool("data/crate.bmp", RGB(0xff, 0x00, 0xff)),
+	  coinPool("data/coin.bmp", RGB(0xff, 0x00, 0xff))
 {
-	this->pBackBuffer = pBackBuffer;
+	crates.SetPool(&cratePool);
+	coins.SetPool(&coinPool);
 
 
 	RECT r;
@@ -15,7 +19,6 @@ Enemy::Enemy(const BackBuffer* pBackBuffer)
 	r.top = 0;
 	r.right = 128;
 	r.bottom = 128;
-	srand(time(NULL));
 }
 //-----------------------------------------------------------------------------
 // Name : ~CPlayer () (Destructor)
@@ -30,85 +33,57 @@ void Enemy::Update(float dt)
 {
 	// Update sprite
 
-	int i = 0;
-	RECT desktop;
-	GetWindowRect(GetDesktopWindow(), &desktop);
-	for (Sprite* crate : crates) {
-		crate->update(dt);
-
-		if (crate->mPosition.y > desktop.bottom)
-		{
-			crates.erase(crates.begin() + i);
-		}
-		i++;
-	}
+	// Crates that fell off the bottom of the playfield are freed at the end
+	// of the frame. The playfield, not the desktop, so the same steps free
+	// the same crates on any machine.
+	crates.Update(dt, -FLT_MAX, (float)(PLAYFIELD_HEIGHT + cratePool.GetHeight()));
 
 
 }
 
-void Enemy::Draw()
+void Enemy::Draw(CWorldSnapshot& frame)
 {
 
-	for (Sprite* bullet : crates)
-	{
-		bullet->setBackBuffer(pBackBuffer);
-		bullet->draw();
-	}
+	crates.Draw(frame);
 
 
 }
 
-void Enemy::SpawnCrate()
+void Enemy::SpawnCrate(CRandom& random)
 {
-	crates.push_back(new Sprite("data/crate.bmp", RGB(0xff, 0x00, 0xff)));
-	crates.back()->mPosition.x = 0;
-	crates.back()->mPosition.x = rand() % 600 + 100;
-	crates.back()->mVelocity.y = 300 ;
+	float x = (float)(random.Range(600) + 100);
+	crates.Add(cratePool.Acquire(), x, 0.0f, 0.0f, 300.0f);
 }
 
 
-std::vector<Sprite*> Enemy::getVectorCrate()
-{
-	return crates;
-}
 void Enemy::GetCratePos()
 
 {
-	for (Sprite* crate : crates)
-	{
+}
 
-  	}
+void Enemy::Flush()
+{
+	crates.Flush();
+	coins.Flush();
 }
 
-void Enemy::updatecrate(std::vector <Sprite*> crates)
+void Enemy::ReservePools(size_t nCrates, size_t nCoins)
 {
-	this->crates = crates;
+	cratePool.Reserve(nCrates);
+	coinPool.Reserve(nCoins);
+	crates.Reserve(nCrates);
+	coins.Reserve(nCoins);
 }
-void Enemy::spawncoins(){
-	coins.push_back(new Sprite("data/coin.bmp", RGB(0xff, 0x00, 0xff)));
-	coins.back()->mPosition.x = rand() % 750 + 50;
-	coins.back()->mPosition.y = rand() % 500 + 50;
+void Enemy::spawncoins(CRandom& random){
+	float x = (float)(random.Range(750) + 50);
+	float y = (float)(random.Range(500) + 50);
+	coins.Add(coinPool.Acquire(), x, y);
 }
 void Enemy::updatecoins(float dt){
-	for (Sprite* crate :coins) {
-		crate->update(dt);
-
-		
-	}
+	coins.Update(dt, -FLT_MAX, FLT_MAX);
 }
-void Enemy::drawcoins(){
-	for (Sprite* crate : coins) {
-		crate->setBackBuffer(pBackBuffer);
-		crate->draw();
+void Enemy::drawcoins(CWorldSnapshot& frame){
+	coins.Draw(frame);
 
-	}
-
-}
-std::vector<Sprite*> Enemy::getVectorCoin()
-{
-	return coins;
-}
-void Enemy::updatevectorcoin(std::vector <Sprite*> crates)
-{
-	this->coins = crates;
 }
+
@@ -0,0 +1,199 @@
+// EntityList.cpp
+// Moving sprites stored as structure of arrays, with removal deferred to
+// the end of the frame.
+#include "EntityList.h"
+#include "SpritePool.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define ENTITYLIST_SSE2
+#include <emmintrin.h>
+#endif
+
+extern CJobSystem g_Jobs;
+
+CEntityList::CEntityList()
+{
+	m_pPool = NULL;
+	m_FreedLastFlush = 0;
+	m_FreedTotal = 0;
+}
+
+CEntityList::~CEntityList()
+{
+	for(size_t i = 0; i < m_Sprites.size(); i++)
+		Free(m_Sprites[i]);
+}
+
+void CEntityList::Free(Sprite* pSprite)
+{
+	if(m_pPool)
+		m_pPool->Release(pSprite);
+	else
+		delete pSprite;
+}
+
+void CEntityList::Reserve(size_t count)
+{
+	m_X.reserve(count);
+	m_Y.reserve(count);
+	m_PrevX.reserve(count);
+	m_PrevY.reserve(count);
+	m_VX.reserve(count);
+	m_VY.reserve(count);
+	m_Life.reserve(count);
+	m_Flags.reserve(count);
+	m_Sprites.reserve(count);
+	m_KillQueue.reserve(count);
+}
+
+void CEntityList::Add(Sprite* pSprite, float x, float y, float vx, float vy, float fLifetime)
+{
+	m_X.push_back(x);
+	m_Y.push_back(y);
+	m_PrevX.push_back(x);
+	m_PrevY.push_back(y);
+	m_VX.push_back(vx);
+	m_VY.push_back(vy);
+	m_Life.push_back(fLifetime < 0.0f ? std::numeric_limits<float>::infinity() : fLifetime);
+	m_Flags.push_back(0);
+	m_Sprites.push_back(pSprite);
+}
+
+void CEntityList::Update(float dt, float fMinY, float fMaxY)
+{
+	size_t count = m_Sprites.size();
+	size_t chunks = 1;
+	if(count >= PARALLEL_UPDATE_MIN)
+	{
+		chunks = (size_t)g_Jobs.GetThreadCount() * 4;
+		if(chunks > UPDATE_CHUNKS)
+			chunks = UPDATE_CHUNKS;
+	}
+
+	// Whole SSE2 groups per chunk; the last chunk takes the remainder.
+	size_t chunkSize = ((count + chunks - 1) / chunks + 3) & ~(size_t)3;
+
+	g_Jobs.ParallelFor(0, chunks, 1, [&](size_t c0, size_t c1)
+	{
+		for(size_t c = c0; c < c1; c++)
+		{
+			size_t first = c * chunkSize;
+			size_t last = first + chunkSize < count ? first + chunkSize : count;
+			if(first < last)
+				UpdateRange(first, last, dt, fMinY, fMaxY, m_ChunkKills[c]);
+		}
+	});
+
+	// Kill in index order, as a single pass would have.
+	for(size_t c = 0; c < chunks; c++)
+	{
+		for(size_t i = 0; i < m_ChunkKills[c].size(); i++)
+			Kill(m_ChunkKills[c][i]);
+		m_ChunkKills[c].clear();
+	}
+}
+
+void CEntityList::UpdateRange(size_t first, size_t last, float dt, float fMinY, float fMaxY, std::vector<size_t>& kills)
+{
+	float* x = m_X.data();
+	float* y = m_Y.data();
+	float* prevX = m_PrevX.data();
+	float* prevY = m_PrevY.data();
+	float* life = m_Life.data();
+	const float* vx = m_VX.data();
+	const float* vy = m_VY.data();
+	size_t i = first;
+
+#ifdef ENTITYLIST_SSE2
+	__m128 vdt = _mm_set1_ps(dt);
+	__m128 vmin = _mm_set1_ps(fMinY);
+	__m128 vmax = _mm_set1_ps(fMaxY);
+	__m128 vzero = _mm_setzero_ps();
+
+	for(; i + 4 <= last; i += 4)
+	{
+		__m128 ox = _mm_loadu_ps(x + i);
+		__m128 oy = _mm_loadu_ps(y + i);
+		__m128 nx = _mm_add_ps(ox, _mm_mul_ps(_mm_loadu_ps(vx + i), vdt));
+		__m128 ny = _mm_add_ps(oy, _mm_mul_ps(_mm_loadu_ps(vy + i), vdt));
+		__m128 nl = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+		_mm_storeu_ps(prevX + i, ox);
+		_mm_storeu_ps(prevY + i, oy);
+		_mm_storeu_ps(x + i, nx);
+		_mm_storeu_ps(y + i, ny);
+		_mm_storeu_ps(life + i, nl);
+
+		// One bit per lane that has to go; nearly always zero.
+		__m128 out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(ny, vmin), _mm_cmpgt_ps(ny, vmax)), _mm_cmple_ps(nl, vzero));
+		int mask = _mm_movemask_ps(out);
+		for(int lane = 0; mask; lane++, mask >>= 1)
+			if(mask & 1)
+				kills.push_back(i + lane);
+	}
+#endif
+
+	for(; i < last; i++)
+	{
+		prevX[i] = x[i];
+		prevY[i] = y[i];
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		life[i] -= dt;
+		if(y[i] < fMinY || y[i] > fMaxY || life[i] <= 0.0f)
+			kills.push_back(i);
+	}
+}
+
+void CEntityList::Draw(CWorldSnapshot& frame)
+{
+	for(size_t i = 0; i < m_Sprites.size(); i++)
+	{
+		Sprite* pSprite = m_Sprites[i];
+		pSprite->setPrevPosition(Vec2((double)m_PrevX[i], (double)m_PrevY[i]));
+		pSprite->mPosition = Vec2((double)m_X[i], (double)m_Y[i]);
+		pSprite->draw(frame);
+	}
+}
+
+void CEntityList::Kill(size_t index)
+{
+	assert(index < m_Sprites.size() && "CEntityList index must be in range!");
+
+	if(m_Flags[index] & FLAG_DYING)
+		return;
+
+	m_Flags[index] |= FLAG_DYING;
+	m_KillQueue.push_back(index);
+}
+
+void CEntityList::Flush()
+{
+	m_FreedLastFlush = m_KillQueue.size();
+	m_FreedTotal += (unsigned long)m_KillQueue.size();
+
+	// Going from the highest index down, whatever gets swapped in from the
+	// back is never an entry still waiting to be removed.
+	std::sort(m_KillQueue.begin(), m_KillQueue.end(), std::greater<size_t>());
+
+	for(size_t i = 0; i < m_KillQueue.size(); i++)
+	{
+		size_t index = m_KillQueue[i];
+		Free(m_Sprites[index]);
+
+		m_X[index] = m_X.back();			m_X.pop_back();
+		m_Y[index] = m_Y.back();			m_Y.pop_back();
+		m_PrevX[index] = m_PrevX.back();	m_PrevX.pop_back();
+		m_PrevY[index] = m_PrevY.back();	m_PrevY.pop_back();
+		m_VX[index] = m_VX.back();			m_VX.pop_back();
+		m_VY[index] = m_VY.back();			m_VY.pop_back();
+		m_Life[index] = m_Life.back();		m_Life.pop_back();
+		m_Flags[index] = m_Flags.back();	m_Flags.pop_back();
+		m_Sprites[index] = m_Sprites.back();	m_Sprites.pop_back();
+	}
+
+	m_KillQueue.clear();
+}
@@ -0,0 +1,185 @@
+// FrameHistogram.cpp
+// Log-linear histogram of frame times with percentiles and hitch counts.
+#include "FrameHistogram.h"
+#include <fstream>
+#include <string.h>
+
+CFrameHistogram::CFrameHistogram(double fBudget)
+	: m_Budget(fBudget)
+{
+	Clear();
+}
+
+void CFrameHistogram::Clear()
+{
+	memset(m_Counts, 0, sizeof(m_Counts));
+	m_Count = 0;
+	m_Hitches = 0;
+	m_Total = 0.0;
+	m_Min = 0.0;
+	m_Max = 0.0;
+}
+
+int CFrameHistogram::BucketIndex(uint64_t us)
+{
+	if(us < SUB_BUCKETS)
+		return (int)us;
+
+	// Keep the top SUB_BUCKET_BITS bits; the highest one is always set, so
+	// the rest pick one of HALF_BUCKETS buckets for this power of two.
+	int shift = 0;
+	uint64_t top = us;
+	while(top >= SUB_BUCKETS)
+	{
+		top >>= 1;
+		shift++;
+	}
+
+	if(shift > MAX_SHIFT)
+		return BUCKET_COUNT - 1;
+
+	return SUB_BUCKETS + (shift - 1) * HALF_BUCKETS + (int)(top - HALF_BUCKETS);
+}
+
+uint64_t CFrameHistogram::BucketUpperBound(int index)
+{
+	if(index < SUB_BUCKETS)
+		return (uint64_t)index;
+
+	int shift = (index - SUB_BUCKETS) / HALF_BUCKETS + 1;
+	uint64_t top = (uint64_t)((index - SUB_BUCKETS) % HALF_BUCKETS + HALF_BUCKETS);
+	return ((top + 1) << shift) - 1;
+}
+
+void CFrameHistogram::Add(double fSeconds)
+{
+	if(fSeconds < 0.0)
+		fSeconds = 0.0;
+
+	// Anything past the last bucket lands in it.
+	double fMicroseconds = fSeconds * 1000000.0 + 0.5;
+	if(fMicroseconds > 4294967295.0) fMicroseconds = 4294967295.0;
+	m_Counts[BucketIndex((uint64_t)fMicroseconds)]++;
+
+	if(m_Count == 0 || fSeconds < m_Min) m_Min = fSeconds;
+	if(fSeconds > m_Max) m_Max = fSeconds;
+	if(fSeconds > m_Budget) m_Hitches++;
+
+	m_Total += fSeconds;
+	m_Count++;
+}
+
+double CFrameHistogram::Percentile(double fPercent) const
+{
+	if(m_Count == 0)
+		return 0.0;
+
+	// The frame at that rank, counting from 1.
+	uint64_t rank = (uint64_t)(fPercent / 100.0 * (double)m_Count + 0.5);
+	if(rank < 1) rank = 1;
+	if(rank > m_Count) rank = m_Count;
+
+	uint64_t seen = 0;
+	for(int i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += m_Counts[i];
+		if(seen >= rank)
+		{
+			// The bucket edge can lie past the slowest frame, and the
+			// last bucket has no real edge.
+			if(i == BUCKET_COUNT - 1)
+				return m_Max;
+
+			double fValue = (double)BucketUpperBound(i) / 1000000.0;
+			return fValue < m_Max ? fValue : m_Max;
+		}
+	}
+
+	return m_Max;
+}
+
+CFrameStats CFrameHistogram::GetStats() const
+{
+	CFrameStats stats;
+	stats.Count		= m_Count;
+	stats.Mean		= m_Count ? m_Total / (double)m_Count : 0.0;
+	stats.P50		= Percentile(50.0);
+	stats.P90		= Percentile(90.0);
+	stats.P99		= Percentile(99.0);
+	stats.P999		= Percentile(99.9);
+	stats.Min		= m_Min;
+	stats.Max		= m_Max;
+	stats.Budget	= m_Budget;
+	stats.Hitches	= m_Hitches;
+	return stats;
+}
+
+bool CFrameHistogram::Save(const char* szFileName) const
+{
+	size_t length = strlen(szFileName);
+	if(length >= 4 && strcmp(szFileName + length - 4, ".csv") == 0)
+		return SaveCsv(szFileName);
+
+	return SaveJson(szFileName);
+}
+
+bool CFrameHistogram::SaveCsv(const char* szFileName) const
+{
+	std::ofstream file(szFileName, std::ios::trunc);
+	if(!file.is_open())
+		return false;
+
+	// Summary as comment lines, so the table loads as is.
+	CFrameStats stats = GetStats();
+	file << "# frames " << stats.Count << ", hitches " << stats.Hitches << " over " << stats.Budget * 1000.0 << " ms\n";
+	file << "# ms: mean " << stats.Mean * 1000.0 << ", p50 " << stats.P50 * 1000.0 << ", p90 " << stats.P90 * 1000.0
+		 << ", p99 " << stats.P99 * 1000.0 << ", p99.9 " << stats.P999 * 1000.0 << ", max " << stats.Max * 1000.0 << "\n";
+	file << "upper_us,count,cumulative\n";
+
+	uint64_t seen = 0;
+	for(int i = 0; i < BUCKET_COUNT; i++)
+	{
+		if(!m_Counts[i])
+			continue;
+
+		seen += m_Counts[i];
+		file << BucketUpperBound(i) << ',' << m_Counts[i] << ',' << (double)seen / (double)m_Count << "\n";
+	}
+
+	return file.good();
+}
+
+bool CFrameHistogram::SaveJson(const char* szFileName) const
+{
+	std::ofstream file(szFileName, std::ios::trunc);
+	if(!file.is_open())
+		return false;
+
+	CFrameStats stats = GetStats();
+	file << "{\n"
+		 << "\t\"frames\": " << stats.Count << ",\n"
+		 << "\t\"budget_ms\": " << stats.Budget * 1000.0 << ",\n"
+		 << "\t\"hitches\": " << stats.Hitches << ",\n"
+		 << "\t\"mean_ms\": " << stats.Mean * 1000.0 << ",\n"
+		 << "\t\"min_ms\": " << stats.Min * 1000.0 << ",\n"
+		 << "\t\"p50_ms\": " << stats.P50 * 1000.0 << ",\n"
+		 << "\t\"p90_ms\": " << stats.P90 * 1000.0 << ",\n"
+		 << "\t\"p99_ms\": " << stats.P99 * 1000.0 << ",\n"
+		 << "\t\"p999_ms\": " << stats.P999 * 1000.0 << ",\n"
+		 << "\t\"max_ms\": " << stats.Max * 1000.0 << ",\n"
+		 << "\t\"buckets\": [";
+
+	// [upper edge in us, count] for each bucket that saw a frame.
+	bool bFirst = true;
+	for(int i = 0; i < BUCKET_COUNT; i++)
+	{
+		if(!m_Counts[i])
+			continue;
+
+		file << (bFirst ? "" : ", ") << '[' << BucketUpperBound(i) << ", " << m_Counts[i] << ']';
+		bFirst = false;
+	}
+	file << "]\n}\n";
+
+	return file.good();
+}
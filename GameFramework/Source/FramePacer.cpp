@@ -0,0 +1,161 @@
+// FramePacer.cpp
+// Waits for frame deadlines by sleeping most of the way and spinning the rest.
+#include "FramePacer.h"
+#include <chrono>
+#include <math.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define PACER_SPIN_PAUSE() _mm_pause()
+#else
+#define PACER_SPIN_PAUSE() std::this_thread::yield()
+#endif
+
+namespace
+{
+	// Bounds for the spin before a deadline. Below the minimum a sleep that
+	// wakes a little late already misses; above the maximum the sleep is
+	// not worth much any more.
+	const double MIN_MARGIN = 0.00005;
+	const double MAX_MARGIN = 0.004;
+	const double START_MARGIN = 0.001;
+
+	// Weight of the newest wake-up in the running averages, and how many
+	// deviations above the average the margin sits.
+	const double OVERSLEEP_WEIGHT = 1.0 / 16.0;
+	const double MARGIN_DEVIATIONS = 4.0;
+}
+
+//-----------------------------------------------------------------------------
+// CFramePacer Member Functions
+//-----------------------------------------------------------------------------
+CFramePacer::CFramePacer()
+	: m_fMargin(START_MARGIN), m_fOversleepMean(0.0), m_fOversleepDev(0.0), m_fOversleepMax(0.0),
+	  m_nLateWakes(0), m_fPeriod(0.0), m_fDeadline(0.0), m_fLastFrame(0.0), m_fPeriodTotal(0.0),
+	  m_nFrames(0)
+{
+#ifdef _WIN32
+	// Sleep() only wakes on the system tick, 15.6 ms by default.
+	timeBeginPeriod(1);
+#endif
+}
+
+CFramePacer::~CFramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+double CFramePacer::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CFramePacer::Sleep(double fSeconds)
+{
+#ifdef _WIN32
+	// Whole milliseconds only; the spin covers the rest.
+	DWORD ms = (DWORD)(fSeconds * 1000.0);
+	if(ms > 0)
+		::Sleep(ms);
+#else
+	struct timespec ts;
+	ts.tv_sec = (time_t)fSeconds;
+	ts.tv_nsec = (long)((fSeconds - (double)ts.tv_sec) * 1000000000.0);
+	while(clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+		;
+#endif
+}
+
+void CFramePacer::UpdateMargin(double fOversleep)
+{
+	m_fOversleepMean += (fOversleep - m_fOversleepMean) * OVERSLEEP_WEIGHT;
+	m_fOversleepDev += (fabs(fOversleep - m_fOversleepMean) - m_fOversleepDev) * OVERSLEEP_WEIGHT;
+	if(fOversleep > m_fOversleepMax)
+		m_fOversleepMax = fOversleep;
+
+	m_fMargin = m_fOversleepMean + m_fOversleepDev * MARGIN_DEVIATIONS;
+	if(m_fMargin < MIN_MARGIN) m_fMargin = MIN_MARGIN;
+	if(m_fMargin > MAX_MARGIN) m_fMargin = MAX_MARGIN;
+}
+
+void CFramePacer::WaitUntil(double fDeadline)
+{
+	double fNow = Now();
+	double fWake = fDeadline - m_fMargin;
+	if(fWake > fNow)
+	{
+		Sleep(fWake - fNow);
+
+		fNow = Now();
+		UpdateMargin(fNow - fWake);
+		if(fNow > fDeadline)
+			m_nLateWakes++;
+	}
+
+	while(fNow < fDeadline)
+	{
+		PACER_SPIN_PAUSE();
+		fNow = Now();
+	}
+}
+
+void CFramePacer::Pace(double fPeriod)
+{
+	if(fPeriod <= 0.0)
+		return;
+
+	// First frame, or a new rate: nothing to hold to yet.
+	if(m_fDeadline == 0.0 || fPeriod != m_fPeriod)
+	{
+		m_fPeriod = fPeriod;
+		m_fLastFrame = Now();
+		m_fDeadline = m_fLastFrame + fPeriod;
+		return;
+	}
+
+	WaitUntil(m_fDeadline);
+
+	double fNow = Now();
+	double fAchieved = fNow - m_fLastFrame;
+	m_fLastFrame = fNow;
+	m_fPeriodTotal += fAchieved;
+	m_nFrames++;
+	m_Jitter.Add(fabs(fAchieved - fPeriod));
+
+	// A frame that ran past the next deadline restarts the schedule here,
+	// rather than letting the next ones through early to catch up.
+	m_fDeadline += fPeriod;
+	if(m_fDeadline <= fNow)
+		m_fDeadline = fNow + fPeriod;
+}
+
+void CFramePacer::Reset()
+{
+	m_fDeadline = 0.0;
+}
+
+CPacingStats CFramePacer::GetStats() const
+{
+	CPacingStats stats;
+	stats.Frames		= m_nFrames;
+	stats.TargetPeriod	= m_fPeriod;
+	stats.MeanPeriod	= m_nFrames ? m_fPeriodTotal / m_nFrames : 0.0;
+	stats.JitterP50		= m_Jitter.Percentile(50.0);
+	stats.JitterP99		= m_Jitter.Percentile(99.0);
+	stats.JitterMax		= m_Jitter.GetMax();
+	stats.SleepMargin	= m_fMargin;
+	stats.MeanOversleep	= m_fOversleepMean;
+	stats.MaxOversleep	= m_fOversleepMax;
+	stats.LateWakes		= m_nLateWakes;
+	return stats;
+}
@@ -0,0 +1,590 @@
+//-----------------------------------------------------------------------------
+// File: GameWorld.cpp
+//
+// Desc: The game itself: players, crates, collisions and scoring, stepped
+//	   one fixed tick at a time. No window, no clock and no keyboard, so
+//	   the same world runs inside the game and in the headless runner.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CGameWorld Specific Includes
+//-----------------------------------------------------------------------------
+#include "GameWorld.h"
+#include "Profiler.h"
+#include <fstream>
+#define TIMER_SEC 3
+#define TIMER_SEC2 4
+
+extern CAssetCache g_Assets;
+
+//-----------------------------------------------------------------------------
+// CGameWorld Member Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameWorld () (Constructor)
+// Desc : CGameWorld Class Constructor
+//-----------------------------------------------------------------------------
+CGameWorld::CGameWorld()
+{
+	m_fTickRate		= 120.0f;
+	m_nSteps		= 0;
+	m_nLiveEntities = 0;
+	m_nFreedEntities = 0;
+	m_pPlayer		= NULL;
+	m_pRacheta		= NULL;
+	Crate			= NULL;
+	m_bGameOver		= false;
+	memset( m_GameTimers, 0, sizeof(m_GameTimers) );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CGameWorld () (Destructor)
+// Desc : CGameWorld Class Destructor
+//-----------------------------------------------------------------------------
+CGameWorld::~CGameWorld()
+{
+	Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Build ()
+// Desc : Builds the game objects and the scroll position's image.
+//-----------------------------------------------------------------------------
+bool CGameWorld::Build( int nViewHeight )
+{
+	m_pPlayer = new CPlayer();
+	m_pRacheta = new CPlayer2();
+	Crate = new Enemy();
+
+	// Build the short lived sprites now. Crates spawn every half second and
+	// live a few seconds, bullets well under one; the pools grow if a
+	// session ever needs more, and report how far they got on shutdown.
+	m_pPlayer->ReservePools(32, 8);
+	m_pRacheta->ReservePools(32);
+	Crate->ReservePools(32, 16);
+
+	// Only the offset is simulated; the window paints its own layer of the
+	// same image. Start on the bottom of the image and scroll at the pace
+	// the old one pixel per frame had at 60 fps.
+	m_Scroll.SetImage(g_Assets.Acquire("data/scrollingbg.bmp"));
+	if(!m_Scroll.IsLoaded())
+		return false;
+
+	m_Scroll.SetOffset((float)(m_Scroll.GetImageHeight() - nViewHeight));
+	m_Scroll.SetSpeed(60.0f);
+
+	// Success!
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Setup ()
+// Desc : Sets up all the initial states required by the game. After
+//		Release() and Build(), this starts a new game.
+//-----------------------------------------------------------------------------
+void CGameWorld::Setup( float fTickRate, uint64_t seed, const CGameRules& rules )
+{
+	m_fTickRate = fTickRate;
+	m_Rules = rules;
+	m_Random.Seed( seed );
+
+	m_nSteps = 0;
+	m_nLiveEntities = 0;
+	m_nFreedEntities = 0;
+	m_bGameOver = false;
+	Score = Score2 = 0;
+	Lives = Lives2 = 3;
+	RotateIt = RotateIt2 = 0;
+
+	m_pPlayer->Position() = Vec2(100, 400);
+	m_pRacheta->Position() = Vec2(400, 400);
+
+	// Crates every half second, coins every ten, unless the rules say else
+	SetGameTimer(TIMER_SEC, m_Rules.CrateInterval);
+	SetGameTimer(TIMER_SEC2, m_Rules.CoinInterval);
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReportPool () (Static)
+// Desc : Sends a pool's usage to the debugger, to help size the reserves.
+//-----------------------------------------------------------------------------
+static void ReportPool( LPCTSTR szName, const CSpritePool& pool )
+{
+	CSpritePool::Stats stats = pool.GetStats();
+	TCHAR szStats[256];
+	_stprintf_s( szStats, _T("Pool %s: %lu built, %lu high water, %lu grows\n"),
+		szName, (ULONG)stats.Capacity, (ULONG)stats.HighWater, (ULONG)stats.Grows );
+	OutputDebugString( szStats );
+}
+
+
+//-----------------------------------------------------------------------------
+// Name : ReportPools ()
+// Desc : Sends the sprite pools' usage to the debugger, to help size the
+//		reserves.
+//-----------------------------------------------------------------------------
+void CGameWorld::ReportPools() const
+{
+	if(m_pPlayer == NULL || m_pRacheta == NULL || Crate == NULL)
+		return;
+
+	ReportPool( _T("Bullets"), m_pPlayer->GetBulletPool() );
+	ReportPool( _T("Hearts"), m_pPlayer->GetHeartPool() );
+	ReportPool( _T("Bullets2"), m_pRacheta->GetBulletPool() );
+	ReportPool( _T("Crates"), Crate->GetCratePool() );
+	ReportPool( _T("Coins"), Crate->GetCoinPool() );
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases the game objects and their associated memory.
+//-----------------------------------------------------------------------------
+void CGameWorld::Release( )
+{
+	// Pending timers would call into the objects going away. The clock
+	// starts over too: events due on the same tick run in an order that
+	// depends on where the wheel stands, and a new game must not.
+	m_Events.Reset();
+	memset( m_GameTimers, 0, sizeof(m_GameTimers) );
+
+	if(m_pPlayer != NULL)
+	{
+		delete m_pPlayer;
+		m_pPlayer = NULL;
+	}
+	if (m_pRacheta != NULL)
+	{
+		delete m_pRacheta;
+		m_pRacheta = NULL;
+	}
+	if (Crate != NULL)
+	{
+		delete Crate;
+		Crate = NULL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : Step ()
+// Desc : Advances the game by one fixed step of dt seconds.
+//-----------------------------------------------------------------------------
+void CGameWorld::Step( float dt, ULONG ulInput )
+{
+	PROFILE_ZONE("SimulateStep");
+
+	ApplyInput( ulInput );
+
+	// Spawns and explosion frames that fall due on this step
+	m_Events.Advance();
+
+	// Animate the game objects
+	AnimateObjects( dt );
+
+	//Collision();
+
+	// Every check runs against the same grid; whatever got hit is only
+	// killed, the lists keep their indices until the end of the step.
+	BuildCollisionGrid();
+	PlaneCrateCollision();
+	BulletCrateCollision();
+	FishCoinCollision();
+	HeartCollision();
+
+	FishUpgrade();
+
+	// Free everything killed by update or collision in one go.
+	FlushEntities();
+
+	m_nSteps++;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Record ()
+// Desc : Records the world as the last step left it into the snapshot. The
+//		caller fills in the clock time and publishes it.
+//-----------------------------------------------------------------------------
+void CGameWorld::Record( CWorldSnapshot& frame )
+{
+	frame.Step			= m_nSteps;
+	frame.StepLength	= 1.0f / m_fTickRate;
+	frame.ScrollOffset	= (float)m_Scroll.GetOffset();
+	frame.Score			= Score;
+	frame.Score2		= Score2;
+	frame.Lives			= Lives;
+	frame.Lives2		= Lives2;
+	frame.LiveEntities	= m_nLiveEntities;
+	frame.FreedEntities	= m_nFreedEntities;
+
+	m_pPlayer->Draw(frame);
+	m_pPlayer->DrawHeart(frame);
+	m_pRacheta->Draw(frame);
+	Crate->Draw(frame);
+	Crate->drawcoins(frame);
+}
+
+//-----------------------------------------------------------------------------
+// Name : ApplyInput () (Private)
+// Desc : Acts on one step's input: the held keys steer the players, and
+//		the actions pressed since the last step run in a fixed order.
+//-----------------------------------------------------------------------------
+void CGameWorld::ApplyInput( ULONG ulInput )
+{
+	if ( ulInput & INPUT_EXPLODE )
+	{
+		SetGameTimer(1, 100);
+		m_pPlayer->Explode();
+	}
+	if ( ulInput & INPUT_FIRE2 )
+		m_pRacheta->BulletExplosion();
+	if ( ulInput & INPUT_FIRE )
+		m_pPlayer->BulletExplosion();
+	if ( ulInput & INPUT_EXPLODE2 )
+	{
+		SetGameTimer(2, 100);
+		m_pRacheta->Explode();
+	}
+	if ( ulInput & INPUT_ROTATE )
+	{
+		RotateIt++;
+		m_pPlayer->RotateSprite(RotateIt%4);
+	}
+	if ( ulInput & INPUT_ROTATE_BACK )
+	{
+		m_pPlayer->RotateSprite(RotateIt % 4);
+		RotateIt--;	
+		if (RotateIt < 0) {
+			RotateIt = 3;
+		}
+	}
+	if ( ulInput & INPUT_ROTATE2 )
+	{
+		RotateIt++;
+		m_pRacheta->RotateSprite(RotateIt2 % 4);
+	}
+	if ( ulInput & INPUT_ROTATE2_BACK )
+	{
+		m_pRacheta->RotateSprite(RotateIt2 % 4);
+		RotateIt2--;
+		if (RotateIt2 < 0) {
+			RotateIt2 = 3;
+		}
+	}
+	if ( ulInput & INPUT_SAVE )
+		SaveGame();
+	if ( ulInput & INPUT_LOAD )
+		LoadGame();
+
+	// The held keys steer the players every step
+	m_pPlayer->Move( ulInput & 0xFF );
+	m_pRacheta->Move( (ulInput >> 8) & 0xFF );
+}
+
+//-----------------------------------------------------------------------------
+// Name : OnGameTimer () (Private)
+// Desc : Acts on a game timer that fell due. Simulation thread only.
+//-----------------------------------------------------------------------------
+void CGameWorld::OnGameTimer( UINT nID )
+{
+	switch(nID)
+	{
+	case 1:
+		if(!m_pPlayer->AdvanceExplosion())
+	
+			SetGameTimer(1, 0);
+		break;
+	case 2:
+		if (!m_pRacheta->AdvanceExplosion())
+
+			SetGameTimer(2, 0);
+		break;
+	case TIMER_SEC: 
+		Crate->SpawnCrate(m_Random);
+		break;
+	case TIMER_SEC2:
+		Crate->spawncoins(m_Random);
+		break;
+
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetGameTimer ()
+// Desc : Starts (or with nElapse 0, stops) a repeating game timer, like
+//		SetTimer does for windows. It counts simulation steps rather than
+//		clock time, so the same steps always fire the same timers.
+//-----------------------------------------------------------------------------
+void CGameWorld::SetGameTimer( UINT nID, UINT nElapse )
+{
+	assert( nID < MAX_GAME_TIMERS );
+
+	m_Events.Cancel( m_GameTimers[nID] );
+	m_GameTimers[nID] = 0;
+	if ( !nElapse ) return;
+
+	// Rounded up to whole steps, at least one
+	UINT64 nSteps = (UINT64)ceil( (double)nElapse * m_fTickRate / 1000.0 );
+	m_GameTimers[nID] = m_Events.Schedule( nSteps, [this, nID]() { OnGameTimer( nID ); }, nSteps );
+}
+
+//-----------------------------------------------------------------------------
+// Name : AnimateObjects () (Private)
+// Desc : Animates the objects we currently have loaded.
+//-----------------------------------------------------------------------------
+void CGameWorld::AnimateObjects( float dt )
+{
+	PROFILE_ZONE("AnimateObjects");
+
+	m_Scroll.Update(dt);
+	m_pPlayer->Update(dt);
+	m_pPlayer->UpdateHeart(dt);
+	m_pRacheta->Update(dt);
+	Crate->Update(dt);
+	Crate->updatecoins(dt);
+	
+}
+
+void CGameWorld::SaveGame() {
+
+	SaveData data;
+	
+	data.posPlayer1 = m_pPlayer->Position();
+    data.posPlayer2 = m_pRacheta->Position();
+	std::ofstream DataInput("data/Text.txt");
+	DataInput.write((char*)&data, sizeof(data));
+
+
+}
+void CGameWorld::LoadGame() {
+	SaveData data;
+	std::ifstream DataInput("data/Text.txt");
+	DataInput.read((char*)&data, sizeof(data));
+	m_pPlayer->Position() = data.posPlayer1;
+	m_pRacheta->Position() = data.posPlayer2;
+}
+void CGameWorld::Collision() {
+
+	double Distance = m_pPlayer->Position().Distance(m_pRacheta->Position());
+	if (Distance <= (m_pPlayer->getPlayerWidth() + m_pRacheta->getPlayerWidth())/2 && !m_pPlayer->CheckExplosion()&& !m_pRacheta->CheckExplosion()){
+		SetGameTimer(1, 100);
+		m_pPlayer->Velocity() = Vec2(0, 0);
+		m_pPlayer->Explode();
+		m_pPlayer->Position() = Vec2(100, 400);
+		SetGameTimer(2, 100);
+		m_pRacheta->Velocity() = Vec2(0, 0);
+		m_pRacheta->Explode();
+		m_pRacheta->Position() = Vec2(400, 400);
+	}
+
+
+
+
+}
+//-----------------------------------------------------------------------------
+// Name : InsertColliders () (Static)
+// Desc : Adds a sprite list to the grid, the ids being the list indices.
+//-----------------------------------------------------------------------------
+static void InsertColliders(CSpatialHash& grid, int layer, const CEntityList& sprites)
+{
+	for (size_t i = 0; i < sprites.Size(); i++)
+	{
+		grid.Insert(layer, (int)i, sprites.X(i), sprites.Y(i), sprites[i]->width() * 0.5f);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildCollisionGrid () (Private)
+// Desc : Puts everything that can collide this frame into the broadphase.
+//-----------------------------------------------------------------------------
+void CGameWorld::BuildCollisionGrid()
+{
+	PROFILE_ZONE("BuildCollisionGrid");
+
+	m_Collisions.Clear();
+
+	InsertColliders(m_Collisions, LAYER_CRATE, Crate->GetCrates());
+	InsertColliders(m_Collisions, LAYER_COIN, Crate->GetCoins());
+	InsertColliders(m_Collisions, LAYER_HEART, m_pPlayer->GetHearts());
+	InsertColliders(m_Collisions, LAYER_BULLET, m_pPlayer->GetBullets());
+	InsertColliders(m_Collisions, LAYER_BULLET2, m_pRacheta->GetBullets());
+
+	m_Collisions.Insert(LAYER_PLAYER, 0, (float)m_pPlayer->Position().x, (float)m_pPlayer->Position().y, (float)m_pPlayer->getPlayerWidth() * 0.5f);
+	m_Collisions.Insert(LAYER_PLAYER2, 0, (float)m_pRacheta->Position().x, (float)m_pRacheta->Position().y, (float)m_pRacheta->getPlayerWidth() * 0.5f);
+}
+
+//-----------------------------------------------------------------------------
+// Name : FlushEntities () (Private)
+// Desc : Frees everything killed during this frame and counts what is left.
+//-----------------------------------------------------------------------------
+void CGameWorld::FlushEntities()
+{
+	PROFILE_ZONE("FlushEntities");
+
+	CEntityList* lists[] = { &Crate->GetCrates(), &Crate->GetCoins(), &m_pPlayer->GetHearts(),
+							 &m_pPlayer->GetBullets(), &m_pRacheta->GetBullets() };
+
+	Crate->Flush();
+	m_pPlayer->Flush();
+	m_pRacheta->Flush();
+
+	m_nLiveEntities = 0;
+	m_nFreedEntities = 0;
+	for (CEntityList* list : lists)
+	{
+		m_nLiveEntities += (ULONG)list->GetLiveCount();
+		m_nFreedEntities += (ULONG)list->GetFreedCount();
+	}
+}
+
+void CGameWorld::BulletCrateCollision()
+{
+	PROFILE_ZONE("BulletCrateCollision");
+
+	CEntityList& crates = Crate->GetCrates();
+	CEntityList& bullets = m_pPlayer->GetBullets();
+	CEntityList& bullets2 = m_pRacheta->GetBullets();
+
+	// A bullet takes out one crate, and a crate stops one bullet.
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_BULLET, LAYER_CRATE, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (bullets.IsDying(pair.A) || crates.IsDying(pair.B))
+			continue;
+
+		bullets.Kill(pair.A);
+		crates.Kill(pair.B);
+		Score = Score + 100;
+	}
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_BULLET2, LAYER_CRATE, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (bullets2.IsDying(pair.A) || crates.IsDying(pair.B))
+			continue;
+
+		bullets2.Kill(pair.A);
+		crates.Kill(pair.B);
+		Score2 = Score2 + 100;
+	}
+}
+
+void CGameWorld::PlaneCrateCollision()
+{
+	PROFILE_ZONE("PlaneCrateCollision");
+
+	CEntityList& crates = Crate->GetCrates();
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_PLAYER, LAYER_CRATE, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (crates.IsDying(pair.B) || m_pPlayer->CheckExplosion())
+			continue;
+
+		SetGameTimer(1, 50);
+		m_pPlayer->Velocity() = Vec2(0, 0);
+		m_pPlayer->Explode();
+		m_pPlayer->Position() = Vec2(100, 400);
+
+		crates.Kill(pair.B);
+		Lives--;
+		LifeSpawn();
+		if (Lives <= 0) {
+			m_bGameOver = true;
+		}
+	}
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_PLAYER2, LAYER_CRATE, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (crates.IsDying(pair.B) || m_pRacheta->CheckExplosion())
+			continue;
+
+		SetGameTimer(2, 50);
+		m_pRacheta->Velocity() = Vec2(0, 0);
+		m_pRacheta->Explode();
+		m_pRacheta->Position() = Vec2(400, 400);
+
+		crates.Kill(pair.B);
+		Lives2--;
+		LifeSpawn();
+		if (Lives2 <= 0) {
+			m_bGameOver = true;
+		}
+	}
+}
+
+void CGameWorld::FishCoinCollision()
+{
+	PROFILE_ZONE("FishCoinCollision");
+
+	CEntityList& coins = Crate->GetCoins();
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_PLAYER, LAYER_COIN, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (coins.IsDying(pair.B) || m_pPlayer->CheckExplosion())
+			continue;
+
+		coins.Kill(pair.B);
+		Score = Score + 500;
+	}
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_PLAYER2, LAYER_COIN, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (coins.IsDying(pair.B) || m_pRacheta->CheckExplosion())
+			continue;
+
+		coins.Kill(pair.B);
+		Score2 = Score2 + 500;
+	}
+}
+
+void CGameWorld::FishUpgrade() {
+	// The skins are preloaded, SetLevel only switches on an actual level change.
+	int iLevel = CPlayer::LEVEL_START;
+	if (Score >= m_Rules.FishScore) iLevel = CPlayer::LEVEL_FISH;
+	if (Score >= m_Rules.SharkScore) iLevel = CPlayer::LEVEL_SHARK;
+	m_pPlayer->SetLevel(iLevel);
+
+	int iLevel2 = CPlayer2::LEVEL_START;
+	if (Score2 >= m_Rules.FishScore) iLevel2 = CPlayer2::LEVEL_FISH;
+	if (Score2 >= m_Rules.SharkScore) iLevel2 = CPlayer2::LEVEL_SHARK;
+	m_pRacheta->SetLevel(iLevel2);
+}
+
+void CGameWorld::LifeSpawn()
+{
+
+
+
+	if (Lives <= 2)
+	{
+		m_pPlayer->SpawnHeart(m_Random);
+		
+	}
+	
+
+}
+void CGameWorld::HeartCollision()
+{
+	PROFILE_ZONE("HeartCollision");
+
+	CEntityList& hearts = m_pPlayer->GetHearts();
+
+	m_Pairs.clear();
+	m_Collisions.FindPairs(LAYER_PLAYER, LAYER_HEART, m_Pairs);
+	for (const CCollisionPair& pair : m_Pairs)
+	{
+		if (hearts.IsDying(pair.B))
+			continue;
+
+		hearts.Kill(pair.B);
+		Lives++;
+	}
+}
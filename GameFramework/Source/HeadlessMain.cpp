@@ -0,0 +1,438 @@
+//-----------------------------------------------------------------------------
+// File: HeadlessMain.cpp
+//
+// Desc: Runs the game world with no window and no renderer, as fast as the
+//	   CPU allows, and reports the step rate and memory use. This is the
+//	   soak and leak test; it builds on Linux as well (see CMakeLists.txt).
+//
+//	   GameHeadless [-minutes:N] [-tick:N] [-seed:N] [-replay:FILE] [-trace]
+//	   GameHeadless -batch:N [-threads:N] [-results:FILE] [-minutes:N] ...
+//	   GameHeadless -resize[:WxH:WxH] [-threads:N]
+//	   GameHeadless -blit
+//	   GameHeadless -render[:FRAMES] [-seed:N]
+//	   GameHeadless -scroll[:FRAMES]
+//	   GameHeadless -broadphase[:N] [-threads:N]
+//	   GameHeadless -entities[:N] [-threads:N]
+//	   GameHeadless -pipeline[:SECONDS] [-seed:N] [-trace]
+//	   GameHeadless -scaling [-threads:N] [-batch:N] [-minutes:N]
+//
+//	   Either mode takes the balance options -crates:MS, -coins:MS,
+//	   -fish:N and -shark:N (see CGameRules).
+//
+//	   Run it from a directory holding the game's data/ folder.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Headless Module Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "GameWorld.h"
+#include "BatchRunner.h"
+#include "Benchmarks.h"
+#include "InputBot.h"
+#include "InputLog.h"
+#include "AssetCache.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <chrono>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+//-----------------------------------------------------------------------------
+// Global Variable Definitions
+//-----------------------------------------------------------------------------
+CJobSystem	g_Jobs;	 // Worker threads (must outlive the world)
+CAssetCache	g_Assets;   // Shared decoded images (must outlive the world)
+
+static const float	MIN_TICK_RATE	= 10.0f;
+static const float	MAX_TICK_RATE	= 1000.0f;
+
+//-----------------------------------------------------------------------------
+// Name : COption (Struct)
+// Desc : An option the runner takes. Flags stand alone; the others are the
+//		name with its ':' and a value straight after it.
+//-----------------------------------------------------------------------------
+enum EOptionKind { OPTION_FLAG, OPTION_NUMBER, OPTION_COUNT, OPTION_TEXT };
+
+struct COption
+{
+	const char*	szName;
+	EOptionKind	Kind;			// NUMBER is any decimal, COUNT a whole number >= 0
+};
+
+static const COption g_Options[] =
+{
+	{ "-minutes:", OPTION_NUMBER }, { "-tick:", OPTION_NUMBER }, { "-seed:", OPTION_COUNT },
+	{ "-crates:", OPTION_COUNT }, { "-coins:", OPTION_COUNT }, { "-fish:", OPTION_COUNT },
+	{ "-shark:", OPTION_COUNT }, { "-replay:", OPTION_TEXT }, { "-trace", OPTION_FLAG },
+	{ "-threads:", OPTION_COUNT }, { "-batch:", OPTION_COUNT }, { "-results:", OPTION_TEXT },
+	{ "-resize", OPTION_FLAG }, { "-resize:", OPTION_TEXT }, { "-blit", OPTION_FLAG },
+	{ "-render", OPTION_FLAG }, { "-render:", OPTION_COUNT },
+	{ "-scroll", OPTION_FLAG }, { "-scroll:", OPTION_COUNT },
+	{ "-broadphase", OPTION_FLAG }, { "-broadphase:", OPTION_COUNT },
+	{ "-entities", OPTION_FLAG }, { "-entities:", OPTION_COUNT },
+	{ "-pipeline", OPTION_FLAG }, { "-pipeline:", OPTION_NUMBER },
+	{ "-scaling", OPTION_FLAG }
+};
+
+//-----------------------------------------------------------------------------
+// Name : PrintUsage () (Static)
+//-----------------------------------------------------------------------------
+static void PrintUsage( FILE* pFile )
+{
+	fprintf( pFile,
+		"Usage: GameHeadless [-minutes:N] [-tick:N] [-seed:N] [-replay:FILE] [-trace]\n"
+		"       GameHeadless -batch:N [-threads:N] [-results:FILE] [-minutes:N] ...\n"
+		"       GameHeadless -resize[:WxH:WxH] [-threads:N]\n"
+		"       GameHeadless -blit\n"
+		"       GameHeadless -render[:FRAMES] [-seed:N]\n"
+		"       GameHeadless -scroll[:FRAMES]\n"
+		"       GameHeadless -broadphase[:N] [-threads:N]\n"
+		"       GameHeadless -entities[:N] [-threads:N]\n"
+		"       GameHeadless -pipeline[:SECONDS] [-seed:N] [-trace]\n"
+		"       GameHeadless -scaling [-threads:N] [-batch:N] [-minutes:N]\n"
+		"Balance options: -crates:MS -coins:MS -fish:N -shark:N\n"
+		"See Docs/Readme.txt for what each one does.\n" );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ParseNumber () / ParseCount () (Static)
+// Desc : Read a whole option value as a decimal or a whole number, failing
+//		on anything else (atof and atoi would quietly give 0 for "abc").
+//-----------------------------------------------------------------------------
+static bool ParseNumber( const char* szValue, double& fValue )
+{
+	char* pEnd;
+	fValue = strtod( szValue, &pEnd );
+	return pEnd != szValue && *pEnd == '\0' && isfinite( fValue );
+}
+
+static bool ParseCount( const char* szValue, unsigned long long& nValue )
+{
+	char* pEnd;
+	if ( *szValue < '0' || *szValue > '9' ) return false;
+	errno = 0;
+	nValue = strtoull( szValue, &pEnd, 10 );
+	return *pEnd == '\0' && errno == 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CheckArguments () (Static)
+// Desc : Makes sure every argument is a known option with a well formed
+//		value, saying what is wrong with the first that is not.
+//-----------------------------------------------------------------------------
+static bool CheckArguments( int argc, char* argv[] )
+{
+	const int nOptions = sizeof(g_Options) / sizeof(g_Options[0]);
+	for ( int i = 1; i < argc; i++ )
+	{
+		const COption* pOption = NULL;
+		const char* szValue = NULL;
+		for ( int o = 0; o < nOptions && !pOption; o++ )
+		{
+			size_t length = strlen( g_Options[o].szName );
+			if ( g_Options[o].Kind == OPTION_FLAG ? strcmp( argv[i], g_Options[o].szName ) == 0
+												  : strncmp( argv[i], g_Options[o].szName, length ) == 0 )
+			{
+				pOption = &g_Options[o];
+				szValue = argv[i] + length;
+			}
+		}
+
+		if ( !pOption )
+		{
+			fprintf( stderr, "Unknown option %s\n", argv[i] );
+			return false;
+		}
+
+		double fNumber;
+		unsigned long long nCount;
+		if ( ( pOption->Kind == OPTION_NUMBER && !ParseNumber( szValue, fNumber ) ) ||
+			 ( pOption->Kind == OPTION_COUNT && !ParseCount( szValue, nCount ) ) ||
+			 ( pOption->Kind == OPTION_TEXT && !*szValue ) )
+		{
+			fprintf( stderr, "%s needs %s, not \"%s\"\n", pOption->szName,
+				pOption->Kind == OPTION_NUMBER ? "a number" : pOption->Kind == OPTION_COUNT ? "a whole number" : "a value", szValue );
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : FindOption () (Static)
+// Desc : Returns the text after the option ("60" for "-tick:" in "-tick:60"),
+//		or NULL if it was not given. Flags match whole arguments only, and
+//		CheckArguments has vouched for the values by the time this is used.
+//-----------------------------------------------------------------------------
+static const char* FindOption( int argc, char* argv[], const char* szOption )
+{
+	size_t length = strlen( szOption );
+	bool bFlag = szOption[length - 1] != ':';
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( bFlag ? strcmp( argv[i], szOption ) == 0 : strncmp( argv[i], szOption, length ) == 0 ) return argv[i] + length;
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ClockSeconds () (Static)
+// Desc : Monotonic wall clock, for the step rate.
+//-----------------------------------------------------------------------------
+static double ClockSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetMemoryUse () (Static)
+// Desc : Resident memory of the process now and at its peak, in KB. Zero
+//		where the platform does not say.
+//-----------------------------------------------------------------------------
+static void GetMemoryUse( unsigned long& ulCurrent, unsigned long& ulPeak )
+{
+	ulCurrent = ulPeak = 0;
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof(counters) ) )
+	{
+		ulCurrent = (unsigned long)(counters.WorkingSetSize / 1024);
+		ulPeak = (unsigned long)(counters.PeakWorkingSetSize / 1024);
+	}
+#else
+	FILE* pFile = fopen( "/proc/self/status", "r" );
+	if ( !pFile ) return;
+
+	char szLine[256];
+	while ( fgets( szLine, sizeof(szLine), pFile ) )
+	{
+		if ( strncmp( szLine, "VmRSS:", 6 ) == 0 ) ulCurrent = strtoul( szLine + 6, NULL, 10 );
+		if ( strncmp( szLine, "VmHWM:", 6 ) == 0 ) ulPeak = strtoul( szLine + 6, NULL, 10 );
+	}
+	fclose( pFile );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : RunBatch () (Static)
+// Desc : Plays the sessions asked for on every thread, then prints how they
+//		went and optionally writes them out as CSV.
+//-----------------------------------------------------------------------------
+static int RunBatch( const CBatchSettings& settings, const char* szResults )
+{
+	printf( "Batch: %lu sessions of at most %.1f minutes at %.0f steps/s, seeds %llu on, %lu threads\n",
+		settings.Sessions, settings.MaxMinutes, settings.TickRate, (unsigned long long)settings.Seed,
+		(unsigned long)g_Jobs.GetThreadCount() );
+	fflush( stdout );
+
+	std::vector<CSessionResult> results;
+	double fStart = ClockSeconds();
+	if ( !CBatchRunner::Run( settings, results ) )
+	{
+		fprintf( stderr, "Could not load the game assets; run from the directory holding data/\n" );
+		return 1;
+	}
+	double fElapsed = ClockSeconds() - fStart;
+
+	unsigned long long nSteps = 0;
+	for ( size_t i = 0; i < results.size(); i++ ) nSteps += results[i].Steps;
+
+	unsigned long ulMemory, ulPeak;
+	GetMemoryUse( ulMemory, ulPeak );
+	printf( "Batch: %llu steps in %.2f s, %.1f sessions/s, %.0f steps/s; %lu KB peak resident\n",
+		nSteps, fElapsed, settings.Sessions / fElapsed, nSteps / fElapsed, ulPeak );
+	CBatchRunner::PrintSummary( stdout, settings, CBatchRunner::Summarize( settings, results ) );
+
+	if ( szResults && !CBatchRunner::SaveResults( szResults, settings, results ) )
+	{
+		fprintf( stderr, "Could not write the results to %s\n", szResults );
+		return 1;
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : main() (Application Entry Point)
+// Desc : Steps the world for the simulated minutes asked for, starting a new
+//		game whenever one ends, and prints a line per simulated minute.
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+	PROFILE_THREAD("Headless");
+
+	if ( !CheckArguments( argc, argv ) )
+	{
+		PrintUsage( stderr );
+		return 1;
+	}
+
+	const char* szValue;
+	double fMinutes = 10.0;
+	float fTickRate = 120.0f;
+	uint64_t seed = 1;
+	CGameRules rules;
+
+	if ( (szValue = FindOption( argc, argv, "-minutes:" )) ) fMinutes = strtod( szValue, NULL );
+	if ( (szValue = FindOption( argc, argv, "-tick:" )) ) fTickRate = (float)strtod( szValue, NULL );
+	if ( (szValue = FindOption( argc, argv, "-seed:" )) ) seed = strtoull( szValue, NULL, 10 );
+	if ( (szValue = FindOption( argc, argv, "-crates:" )) ) rules.CrateInterval = (UINT)strtoul( szValue, NULL, 10 );
+	if ( (szValue = FindOption( argc, argv, "-coins:" )) ) rules.CoinInterval = (UINT)strtoul( szValue, NULL, 10 );
+	if ( (szValue = FindOption( argc, argv, "-fish:" )) ) rules.FishScore = (int)strtol( szValue, NULL, 10 );
+	if ( (szValue = FindOption( argc, argv, "-shark:" )) ) rules.SharkScore = (int)strtol( szValue, NULL, 10 );
+	if ( fTickRate < MIN_TICK_RATE ) fTickRate = MIN_TICK_RATE;
+	if ( fTickRate > MAX_TICK_RATE ) fTickRate = MAX_TICK_RATE;
+
+	// A recording brings its own tick rate and seed; when it runs out the
+	// players let go of the keys and the run goes on.
+	CInputPlayer replay;
+	if ( (szValue = FindOption( argc, argv, "-replay:" )) )
+	{
+		if ( !replay.Open( szValue ) )
+		{
+			fprintf( stderr, "Could not read the input recording %s\n", szValue );
+			return 1;
+		}
+		fTickRate = replay.GetHeader().TickRate;
+		seed = replay.GetHeader().Seed;
+	}
+
+	// Threads counts the calling thread, which works through the jobs too
+	int nThreads = -1;
+	if ( (szValue = FindOption( argc, argv, "-threads:" )) ) nThreads = (int)strtol( szValue, NULL, 10 );
+	g_Jobs.Start( nThreads > 0 ? nThreads - 1 : -1 );
+
+	if ( FindOption( argc, argv, "-blit" ) ) return CBenchmarks::RunBlit() ? 0 : 1;
+
+	const char* szFrames = FindOption( argc, argv, "-render:" );
+	if ( szFrames || FindOption( argc, argv, "-render" ) )
+		return CBenchmarks::RunRender( szFrames ? strtoul( szFrames, NULL, 10 ) : 3600, seed ) ? 0 : 1;
+
+	if ( (szFrames = FindOption( argc, argv, "-scroll:" )) || FindOption( argc, argv, "-scroll" ) )
+		return CBenchmarks::RunScroll( szFrames ? strtoul( szFrames, NULL, 10 ) : 2000 ) ? 0 : 1;
+
+	const char* szCount = FindOption( argc, argv, "-broadphase:" );
+	if ( szCount || FindOption( argc, argv, "-broadphase" ) )
+		return CBenchmarks::RunBroadphase( szCount ? strtoul( szCount, NULL, 10 ) : 12000 ) ? 0 : 1;
+
+	if ( (szCount = FindOption( argc, argv, "-entities:" )) || FindOption( argc, argv, "-entities" ) )
+		return CBenchmarks::RunEntities( szCount ? strtoul( szCount, NULL, 10 ) : 100000 ) ? 0 : 1;
+
+	const char* szSeconds = FindOption( argc, argv, "-pipeline:" );
+	if ( szSeconds || FindOption( argc, argv, "-pipeline" ) )
+	{
+		bool bPassed = CBenchmarks::RunPipeline( szSeconds ? strtod( szSeconds, NULL ) : 5.0, seed );
+		if ( FindOption( argc, argv, "-trace" ) && !PROFILE_EXPORT( "data/trace.json" ) )
+			fprintf( stderr, "Profiler: no trace written (release build, or data/ not writable)\n" );
+		return bPassed ? 0 : 1;
+	}
+
+	const char* szSizes = FindOption( argc, argv, "-resize:" );
+	if ( szSizes || FindOption( argc, argv, "-resize" ) )
+		return CBenchmarks::RunResize( szSizes ? szSizes : "", g_Jobs.GetThreadCount() ) ? 0 : 1;
+
+	// Shorter sessions, and fewer, than a balancing batch by default
+	if ( FindOption( argc, argv, "-scaling" ) )
+	{
+		CBatchSettings settings;
+		settings.Sessions = (szValue = FindOption( argc, argv, "-batch:" )) ? strtoul( szValue, NULL, 10 ) : 16;
+		settings.Seed = seed;
+		settings.TickRate = fTickRate;
+		settings.MaxMinutes = FindOption( argc, argv, "-minutes:" ) ? fMinutes : 1.0;
+		settings.Rules = rules;
+		return CBenchmarks::RunScaling( g_Jobs.GetThreadCount(), settings ) ? 0 : 1;
+	}
+
+	if ( (szValue = FindOption( argc, argv, "-batch:" )) )
+	{
+		CBatchSettings settings;
+		settings.Sessions = strtoul( szValue, NULL, 10 );
+		settings.Seed = seed;
+		settings.TickRate = fTickRate;
+		settings.MaxMinutes = fMinutes;
+		settings.Rules = rules;
+		return RunBatch( settings, FindOption( argc, argv, "-results:" ) );
+	}
+
+	CGameWorld world;
+	if ( !world.Build( CGameWorld::DEFAULT_VIEW_HEIGHT ) )
+	{
+		fprintf( stderr, "Could not load the game assets; run from the directory holding data/\n" );
+		return 1;
+	}
+	world.Setup( fTickRate, seed, rules );
+
+	bool bReplay = replay.IsOpen();
+	CInputBot bot( seed );
+	float fStep = 1.0f / fTickRate;
+	unsigned long long nStepsPerMinute = (unsigned long long)(fTickRate * 60.0f + 0.5f);
+	unsigned long long nTotalSteps = (unsigned long long)(fMinutes * nStepsPerMinute + 0.5);
+	unsigned long nGames = 1;
+
+	unsigned long ulMemory, ulPeak;
+	GetMemoryUse( ulMemory, ulPeak );
+	printf( "Headless: %.1f minutes at %.0f steps/s, seed %llu, %s input; %lu KB resident at start\n",
+		fMinutes, fTickRate, (unsigned long long)seed, bReplay ? "recorded" : "bot", ulMemory );
+
+	double fStart = ClockSeconds();
+	double fLast = fStart;
+	for ( unsigned long long nStep = 1; nStep <= nTotalSteps; nStep++ )
+	{
+		ULONG ulInput = 0;
+		if ( bReplay )
+		{
+			uint32_t mask;
+			if ( replay.Next( mask ) ) ulInput = mask;
+		}
+		else ulInput = bot.Next();
+
+		world.Step( fStep, ulInput );
+
+		// Game over; a soak keeps going with a fresh game, which also puts
+		// building and releasing the objects through the test.
+		if ( world.IsOver() )
+		{
+			world.Release();
+			if ( !world.Build( CGameWorld::DEFAULT_VIEW_HEIGHT ) ) return 1;
+			world.Setup( fTickRate, seed + nGames, rules );
+			nGames++;
+		}
+
+		if ( nStep % nStepsPerMinute == 0 || nStep == nTotalSteps )
+		{
+			double fNow = ClockSeconds();
+			unsigned long long nSteps = nStep % nStepsPerMinute ? nStep % nStepsPerMinute : nStepsPerMinute;
+			GetMemoryUse( ulMemory, ulPeak );
+			printf( "  minute %5.1f: %10.0f steps/s, %lu KB resident, %lu entities, game %lu at %d / %d points\n",
+				(double)nStep / nStepsPerMinute, nSteps / (fNow - fLast), ulMemory,
+				world.GetLiveEntities(), nGames, world.GetScore(), world.GetScore2() );
+			fflush( stdout );
+			fLast = fNow;
+		}
+	}
+
+	double fElapsed = ClockSeconds() - fStart;
+	GetMemoryUse( ulMemory, ulPeak );
+	printf( "Headless: %llu steps in %.2f s, %.0f steps/s (%.0fx real time), %lu games\n",
+		nTotalSteps, fElapsed, nTotalSteps / fElapsed, nTotalSteps / fElapsed / fTickRate, nGames );
+	printf( "Memory: %lu KB resident, %lu KB peak\n", ulMemory, ulPeak );
+
+	world.ReportPools();
+	world.Release();
+
+	CAssetCache::Stats stats = g_Assets.GetStats();
+	printf( "Assets: %lu resident (%lu KB)\n", stats.AssetCount, (unsigned long)(stats.BytesResident / 1024) );
+
+	if ( FindOption( argc, argv, "-trace" ) && !PROFILE_EXPORT( "data/trace.json" ) )
+		fprintf( stderr, "Profiler: no trace written (release build, or data/ not writable)\n" );
+
+	return 0;
+}
@@ -3,16 +3,49 @@
 // March 2009
 #include "ImageFile.h"
 
-extern HINSTANCE g_hInst;
-
 
 CImageFile::CImageFile() : height(m_biInfo.biHeight), width(m_biInfo.biWidth)
 {
+#ifdef _WIN32
 	m_hBMP = 0;
+#endif
 	m_pRGB = NULL;
+	m_szFileName[0] = 0;
 	ZeroMemory(&m_biInfo, sizeof(BITMAPINFOHEADER));
 }
 
+bool CImageFile::Create(LONG nWidth, LONG nHeight)
+{
+	if(nWidth <= 0 || nHeight <= 0)
+		return false;
+
+	delete[] m_pRGB;
+#ifdef _WIN32
+	if(m_hBMP)
+	{
+		DeleteObject(m_hBMP);
+		m_hBMP = 0;
+	}
+#endif
+
+	ZeroMemory(&m_biInfo, sizeof(BITMAPINFOHEADER));
+	m_biInfo.biSize = sizeof(BITMAPINFOHEADER);
+	m_biInfo.biWidth = nWidth;
+	m_biInfo.biHeight = nHeight;
+	m_biInfo.biPlanes = 1;
+	m_biInfo.biBitCount = 32;
+	m_biInfo.biCompression = BI_RGB;
+	m_szFileName[0] = 0;
+
+	m_pRGB = new RGBQUAD[width * height];
+	Clear();
+	return true;
+}
+
+// Loading and drawing go through GDI, so they are only in the Windows build.
+#ifdef _WIN32
+extern HINSTANCE g_hInst;
+
 bool CImageFile::LoadBitmapFromFile(const char *szFileName, HDC hdc)
 {
 	BYTE *pData;
@@ -107,14 +140,16 @@ void CImageFile::Paint(HDC hdc, int x, int y)
 
 	DeleteDC(mdc);
 }
-
+#endif
 
 CImageFile::~CImageFile(void)
 {
 	if(m_pRGB)
 		delete[] m_pRGB;
 
+#ifdef _WIN32
 	DeleteObject(m_hBMP);
+#endif
 }
 
 BYTE* CImageFile::CopyMonoImage(EColorChannel chn, const RECT* rc)
@@ -0,0 +1,177 @@
+// InputLog.cpp
+// Per-step game input, recorded to and played back from a file.
+#include "InputLog.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	const char INPUT_LOG_TAG[4] = { 'G', 'I', 'N', 'P' };
+
+	void WriteUInt(std::ofstream& file, uint64_t value, int bytes)
+	{
+		for(int i = 0; i < bytes; i++)
+			file.put((char)((value >> (i * 8)) & 0xFF));
+	}
+
+	bool ReadUInt(std::ifstream& file, uint64_t& value, int bytes)
+	{
+		value = 0;
+		for(int i = 0; i < bytes; i++)
+		{
+			int c = file.get();
+			if(c == EOF)
+				return false;
+			value |= (uint64_t)(unsigned char)c << (i * 8);
+		}
+		return true;
+	}
+
+	// Seven bits at a time, lowest first, high bit set on all but the last.
+	void WriteVarint(std::ofstream& file, uint64_t value)
+	{
+		while(value >= 0x80)
+		{
+			file.put((char)((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		file.put((char)value);
+	}
+
+	bool ReadVarint(std::ifstream& file, uint64_t& value)
+	{
+		value = 0;
+		for(int shift = 0; shift < 64; shift += 7)
+		{
+			int c = file.get();
+			if(c == EOF)
+				return false;
+			value |= (uint64_t)(c & 0x7F) << shift;
+			if(!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// CInputRecorder Member Functions
+//-----------------------------------------------------------------------------
+CInputRecorder::CInputRecorder()
+	: m_RunMask(0), m_RunLength(0), m_nSteps(0)
+{
+}
+
+CInputRecorder::~CInputRecorder()
+{
+	Close();
+}
+
+bool CInputRecorder::Open(const char* szFileName, const CInputLogHeader& header)
+{
+	Close();
+
+	m_File.open(szFileName, std::ios::binary | std::ios::trunc);
+	if(!m_File.is_open())
+		return false;
+
+	uint32_t tickRate;
+	memcpy(&tickRate, &header.TickRate, sizeof(tickRate));
+
+	m_File.write(INPUT_LOG_TAG, sizeof(INPUT_LOG_TAG));
+	WriteUInt(m_File, CInputLogHeader::VERSION, 4);
+	WriteUInt(m_File, tickRate, 4);
+	WriteUInt(m_File, header.Seed, 8);
+
+	m_RunLength = 0;
+	m_nSteps = 0;
+	return m_File.good();
+}
+
+void CInputRecorder::Close()
+{
+	if(!m_File.is_open())
+		return;
+
+	FlushRun();
+	m_File.close();
+}
+
+void CInputRecorder::FlushRun()
+{
+	if(!m_RunLength)
+		return;
+
+	WriteVarint(m_File, m_RunLength);
+	WriteUInt(m_File, m_RunMask, 4);
+	m_RunLength = 0;
+}
+
+void CInputRecorder::Record(uint32_t mask)
+{
+	if(!m_File.is_open())
+		return;
+
+	if(m_RunLength && mask != m_RunMask)
+		FlushRun();
+
+	m_RunMask = mask;
+	m_RunLength++;
+	m_nSteps++;
+}
+
+//-----------------------------------------------------------------------------
+// CInputPlayer Member Functions
+//-----------------------------------------------------------------------------
+CInputPlayer::CInputPlayer()
+	: m_RunMask(0), m_RunLeft(0), m_nSteps(0)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+}
+
+bool CInputPlayer::Open(const char* szFileName)
+{
+	m_File.open(szFileName, std::ios::binary);
+	if(!m_File.is_open())
+		return false;
+
+	char tag[sizeof(INPUT_LOG_TAG)];
+	uint64_t version, tickRate, seed;
+	if(!m_File.read(tag, sizeof(tag)) || memcmp(tag, INPUT_LOG_TAG, sizeof(tag)) != 0 ||
+	   !ReadUInt(m_File, version, 4) || version != CInputLogHeader::VERSION ||
+	   !ReadUInt(m_File, tickRate, 4) || !ReadUInt(m_File, seed, 8))
+	{
+		m_File.close();
+		return false;
+	}
+
+	uint32_t tickRateBits = (uint32_t)tickRate;
+	m_Header.Version = (uint32_t)version;
+	memcpy(&m_Header.TickRate, &tickRateBits, sizeof(m_Header.TickRate));
+	m_Header.Seed = seed;
+
+	m_RunLeft = 0;
+	m_nSteps = 0;
+	return true;
+}
+
+bool CInputPlayer::Next(uint32_t& mask)
+{
+	if(!m_File.is_open())
+		return false;
+
+	while(!m_RunLeft)
+	{
+		uint64_t length, runMask;
+		if(!ReadVarint(m_File, length) || !ReadUInt(m_File, runMask, 4))
+			return false;
+
+		m_RunLeft = length;
+		m_RunMask = (uint32_t)runMask;
+	}
+
+	mask = m_RunMask;
+	m_RunLeft--;
+	m_nSteps++;
+	return true;
+}
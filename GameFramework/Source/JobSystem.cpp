@@ -0,0 +1,305 @@
+// JobSystem.cpp
+// Work-stealing thread pool for engine subsystems.
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <assert.h>
+#include <stdio.h>
+
+namespace
+{
+	// Which system and queue the current thread works for.
+	thread_local const CJobSystem*	t_pJobSystem = NULL;
+	thread_local size_t				t_QueueIndex = 0;
+
+	// Rounds an idle worker looks for work before it goes to sleep.
+	const int IDLE_SPINS = 64;
+}
+
+//-----------------------------------------------------------------------------
+// CJob
+//-----------------------------------------------------------------------------
+CJob::CJob()
+	: m_pParent(NULL), m_Unfinished(0), m_Blockers(1), m_nDependents(0), m_bBackground(false)
+{
+}
+
+CJob::CJob(const std::function<void()>& work, CJob* pParent)
+	: m_pParent(NULL), m_Unfinished(0), m_Blockers(1), m_nDependents(0), m_bBackground(false)
+{
+	Set(work, pParent);
+}
+
+void CJob::Set(const std::function<void()>& work, CJob* pParent)
+{
+	assert(IsDone() && "CJob changed while in flight!");
+
+	m_Work = work;
+	m_pParent = pParent;
+	m_nDependents = 0;
+	m_bBackground = false;
+	m_Blockers.store(1, std::memory_order_relaxed);
+	m_Unfinished.store(1, std::memory_order_relaxed);
+
+	if(pParent)
+		pParent->m_Unfinished.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CJob::DependOn(CJob& prerequisite)
+{
+	if(prerequisite.m_nDependents == MAX_DEPENDENTS)
+		return false;
+
+	prerequisite.m_Dependents[prerequisite.m_nDependents++] = this;
+	m_Blockers.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// CJobSystem
+//-----------------------------------------------------------------------------
+CJobSystem::CJobSystem()
+	: m_bRunning(false), m_nQueued(0), m_nSleeping(0)
+{
+	// The shared queue exists even without workers.
+	m_Queues.push_back(std::unique_ptr<CWorkQueue>(new CWorkQueue()));
+	m_Queues[0]->Head = 0;
+	m_Background.Head = 0;
+}
+
+CJobSystem::~CJobSystem()
+{
+	Stop();
+}
+
+bool CJobSystem::Start(int nWorkers)
+{
+	if(m_bRunning)
+		return false;
+
+	if(nWorkers < 0)
+	{
+		int nCores = (int)std::thread::hardware_concurrency();
+		nWorkers = nCores > 1 ? nCores - 1 : 0;
+	}
+
+	m_Queues.resize(1);
+	for(int i = 0; i < nWorkers; i++)
+	{
+		m_Queues.push_back(std::unique_ptr<CWorkQueue>(new CWorkQueue()));
+		m_Queues.back()->Head = 0;
+	}
+
+	m_bRunning = true;
+	for(int i = 0; i < nWorkers; i++)
+		m_Workers.push_back(std::thread(&CJobSystem::WorkerMain, this, (size_t)i + 1));
+
+	return true;
+}
+
+void CJobSystem::Stop()
+{
+	if(!m_bRunning)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_WakeLock);
+		m_bRunning = false;
+	}
+	m_Wake.notify_all();
+
+	for(size_t i = 0; i < m_Workers.size(); i++)
+		m_Workers[i].join();
+	m_Workers.clear();
+	m_Queues.resize(1);
+
+	// Background jobs nobody got to move to the shared queue, where Wait()
+	// still finds them.
+	std::lock_guard<std::mutex> lock(m_Background.Lock);
+	std::lock_guard<std::mutex> sharedLock(m_Queues[0]->Lock);
+	for(size_t i = m_Background.Head; i < m_Background.Jobs.size(); i++)
+	{
+		m_Background.Jobs[i]->m_bBackground = false;
+		m_Queues[0]->Jobs.push_back(m_Background.Jobs[i]);
+	}
+	m_Background.Jobs.clear();
+	m_Background.Head = 0;
+}
+
+size_t CJobSystem::QueueIndex() const
+{
+	return t_pJobSystem == this ? t_QueueIndex : 0;
+}
+
+void CJobSystem::Submit(CJob& job)
+{
+	// The submit itself was the last blocker unless prerequisites are
+	// still running; the last of those pushes the job then.
+	if(job.m_Blockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		Push(job);
+}
+
+void CJobSystem::SubmitBackground(CJob& job)
+{
+	job.m_bBackground = !m_Workers.empty();
+	Submit(job);
+}
+
+void CJobSystem::Push(CJob& job)
+{
+	CWorkQueue& queue = job.m_bBackground ? m_Background : *m_Queues[QueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		queue.Jobs.push_back(&job);
+	}
+
+	// Either a worker about to sleep sees the count, or we see it sleeping.
+	m_nQueued.fetch_add(1);
+	if(m_nSleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_WakeLock);
+		m_Wake.notify_one();
+	}
+}
+
+CJob* CJobSystem::FindJob(size_t index)
+{
+	// Own queue first, newest job.
+	{
+		CWorkQueue& queue = *m_Queues[index];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if(queue.Jobs.size() > queue.Head)
+		{
+			CJob* pJob = queue.Jobs.back();
+			queue.Jobs.pop_back();
+			if(queue.Jobs.size() == queue.Head)
+			{
+				queue.Jobs.clear();
+				queue.Head = 0;
+			}
+			m_nQueued.fetch_sub(1);
+			return pJob;
+		}
+	}
+
+	// Then steal the oldest job of the next queue that has one.
+	size_t count = m_Queues.size();
+	for(size_t i = 1; i < count; i++)
+	{
+		CWorkQueue& queue = *m_Queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if(queue.Jobs.size() > queue.Head)
+		{
+			CJob* pJob = queue.Jobs[queue.Head++];
+			if(queue.Jobs.size() == queue.Head)
+			{
+				queue.Jobs.clear();
+				queue.Head = 0;
+			}
+			m_nQueued.fetch_sub(1);
+			return pJob;
+		}
+	}
+
+	// Background work last, oldest first, and never for a non-worker.
+	if(index != 0)
+	{
+		std::lock_guard<std::mutex> lock(m_Background.Lock);
+		if(m_Background.Jobs.size() > m_Background.Head)
+		{
+			CJob* pJob = m_Background.Jobs[m_Background.Head++];
+			if(m_Background.Jobs.size() == m_Background.Head)
+			{
+				m_Background.Jobs.clear();
+				m_Background.Head = 0;
+			}
+			m_nQueued.fetch_sub(1);
+			return pJob;
+		}
+	}
+
+	return NULL;
+}
+
+void CJobSystem::Execute(CJob& job)
+{
+	if(job.m_Work)
+	{
+		PROFILE_ZONE("Job");
+		job.m_Work();
+	}
+
+	Finish(job);
+}
+
+void CJobSystem::Finish(CJob& job)
+{
+	// Read everything first: once the count hits zero a waiting owner may
+	// destroy the job.
+	CJob* pParent = job.m_pParent;
+	CJob* dependents[CJob::MAX_DEPENDENTS];
+	int nDependents = job.m_nDependents;
+	for(int i = 0; i < nDependents; i++)
+		dependents[i] = job.m_Dependents[i];
+
+	if(job.m_Unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	for(int i = 0; i < nDependents; i++)
+		if(dependents[i]->m_Blockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			Push(*dependents[i]);
+
+	if(pParent)
+		Finish(*pParent);
+}
+
+void CJobSystem::Wait(CJob& job)
+{
+	size_t index = QueueIndex();
+	while(!job.IsDone())
+	{
+		CJob* pJob = FindJob(index);
+		if(pJob)
+			Execute(*pJob);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void CJobSystem::WorkerMain(size_t index)
+{
+	t_pJobSystem = this;
+	t_QueueIndex = index;
+
+#if GAME_PROFILER
+	char szName[32];
+	snprintf(szName, sizeof(szName), "Worker %d", (int)index);
+	PROFILE_THREAD(szName);
+#endif
+
+	int idle = 0;
+	while(m_bRunning)
+	{
+		CJob* pJob = FindJob(index);
+		if(pJob)
+		{
+			Execute(*pJob);
+			idle = 0;
+			continue;
+		}
+
+		if(++idle < IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Nothing for a while; sleep until something is queued.
+		m_nSleeping.fetch_add(1);
+		{
+			std::unique_lock<std::mutex> lock(m_WakeLock);
+			m_Wake.wait(lock, [this]() { return m_nQueued.load() > 0 || !m_bRunning; });
+		}
+		m_nSleeping.fetch_sub(1);
+		idle = 0;
+	}
+}
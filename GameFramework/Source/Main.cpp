@@ -11,10 +11,15 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 #include "CGameApp.h"
+#include "AssetCache.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 //-----------------------------------------------------------------------------
 // Global Variable Definitions
 //-----------------------------------------------------------------------------
+CJobSystem	g_Jobs;	 // Worker threads (must outlive g_App)
+CAssetCache	g_Assets;   // Shared decoded images (must outlive g_App)
 CGameApp	g_App;	  // Core game application processing engine
 HINSTANCE	g_hInst;	// Global instance
 
@@ -32,15 +37,31 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpCmdLi
 	// initialize global instance
 	g_hInst = hInstance;
 
+	// One worker per core, the threads calling into it help out.
+	g_Jobs.Start();
+
 	// Initialise the engine.
 	if (!g_App.InitInstance( lpCmdLine, iCmdShow )) return 1;
 	
 	// Begin the gameplay process. Will return when app due to exit.
 	retCode = g_App.BeginGame();
 
+	// Report how much disk traffic the asset cache saved us.
+	CAssetCache::Stats stats = g_Assets.GetStats();
+	TCHAR szStats[256];
+	_stprintf_s( szStats, _T("Assets: %lu hits, %lu misses, %lu failed, %lu resident (%Iu KB)\n"),
+		stats.Hits, stats.Misses, stats.Failures, stats.AssetCount, stats.BytesResident / 1024 );
+	OutputDebugString( szStats );
+
 	// Shut down the engine, just to be polite, before exiting.
 	if ( !g_App.ShutDown() )  MessageBox( 0, _T("Failed to shut system down correctly, please check file named 'debug.txt'.\r\n\r\nIf the problem persists, please contact technical support."), _T("Non-Fatal Error"), MB_OK | MB_ICONEXCLAMATION );
 
+	// With the simulation stopped, write out where the frames went.
+	if ( lpCmdLine && _tcsstr( lpCmdLine, _T("-trace") ) )
+	{
+		if ( !PROFILE_EXPORT( "data/trace.json" ) ) OutputDebugString( _T("Profiler: no trace written (release build, or data/ not writable)\n") );
+	}
+
 	// Return the correct exit code.
 	return retCode;
 }
\ No newline at end of file
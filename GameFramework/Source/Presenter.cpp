@@ -0,0 +1,69 @@
+// Presenter.cpp
+// Ways of getting a finished back buffer frame somewhere.
+#include "Presenter.h"
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// CMemoryPresenter Member Functions
+//-----------------------------------------------------------------------------
+void CMemoryPresenter::Present(const CPixelSurface& frame, const CDirtyRegion& dirty)
+{
+	m_PixelsPushed = 0;
+
+	// Our copy is only good to patch up if it is the same size.
+	bool bFull = dirty.IsFull() || m_Width != frame.Width || m_Height != frame.Height;
+	if(bFull)
+	{
+		m_Width = frame.Width;
+		m_Height = frame.Height;
+		m_Frame.resize((size_t)frame.Width * frame.Height);
+
+		for(int y = 0; y < frame.Height; y++)
+			memcpy(&m_Frame[(size_t)y * frame.Width], frame.Row(y), frame.Width * sizeof(unsigned int));
+
+		m_PixelsPushed = (unsigned long)frame.Width * frame.Height;
+	}
+	else
+	{
+		const std::vector<CRect>& rects = dirty.Rects();
+		for(size_t i = 0; i < rects.size(); i++)
+		{
+			const CRect& rc = rects[i];
+			for(int y = rc.Top; y < rc.Bottom; y++)
+				memcpy(&m_Frame[(size_t)y * frame.Width + rc.Left], frame.Row(y) + rc.Left, rc.Width() * sizeof(unsigned int));
+
+			m_PixelsPushed += rc.Area();
+		}
+	}
+
+	m_FramesPresented++;
+}
+
+//-----------------------------------------------------------------------------
+// CNullPresenter Member Functions
+//-----------------------------------------------------------------------------
+void CNullPresenter::Present(const CPixelSurface& frame, const CDirtyRegion& dirty)
+{
+	m_PixelsPushed = dirty.IsFull() ? (unsigned long)frame.Width * frame.Height : (unsigned long)dirty.Area();
+	m_FramesPresented++;
+}
+
+//-----------------------------------------------------------------------------
+// CFrameDumpPresenter Member Functions
+//-----------------------------------------------------------------------------
+CFrameDumpPresenter::CFrameDumpPresenter(const char* szFileName)
+	: m_File(szFileName, std::ios::binary | std::ios::trunc)
+{
+}
+
+void CFrameDumpPresenter::Present(const CPixelSurface& frame, const CDirtyRegion& /*dirty*/)
+{
+	if(!m_File.is_open())
+		return;
+
+	for(int y = 0; y < frame.Height; y++)
+		m_File.write((const char*)frame.Row(y), frame.Width * sizeof(unsigned int));
+
+	m_PixelsPushed = (unsigned long)frame.Width * frame.Height;
+	m_FramesPresented++;
+}
@@ -0,0 +1,217 @@
+// Profiler.cpp
+// Scoped timing zones, recorded per thread and exported as a Chrome trace.
+#include "Profiler.h"
+
+#if GAME_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct CProfileEvent
+	{
+		const char*	Name;
+		int64_t		Start;
+		int64_t		End;
+	};
+
+	// One per thread that ever recorded. Only the owner writes Events;
+	// Written tells an exporting thread how far it got.
+	struct CProfileRing
+	{
+		CProfileEvent			Events[CProfiler::RING_SIZE];
+		std::atomic<uint64_t>	Written;
+		int						ThreadId;
+		std::string				ThreadName;
+	};
+
+	// Rings stay around after their thread exits, so finished workers
+	// still show up in the trace.
+	struct CProfileRegistry
+	{
+		std::mutex									Lock;
+		std::vector<std::unique_ptr<CProfileRing>>	Rings;
+
+		~CProfileRegistry();
+	};
+
+	// Set once the registry is gone; zones recorded during static
+	// destruction are dropped.
+	std::atomic<bool>				s_bShutDown(false);
+	thread_local CProfileRing*		t_pRing = NULL;
+
+	CProfileRegistry& Registry()
+	{
+		static CProfileRegistry registry;
+		return registry;
+	}
+
+	CProfileRegistry::~CProfileRegistry()
+	{
+		s_bShutDown = true;
+	}
+
+	CProfileRing* ThreadRing()
+	{
+		if(t_pRing)
+			return t_pRing;
+
+		CProfileRegistry& registry = Registry();
+		std::lock_guard<std::mutex> lock(registry.Lock);
+
+		std::unique_ptr<CProfileRing> pRing(new CProfileRing());
+		pRing->Written = 0;
+		pRing->ThreadId = (int)registry.Rings.size() + 1;
+
+		char szName[32];
+		snprintf(szName, sizeof(szName), "Thread %d", pRing->ThreadId);
+		pRing->ThreadName = szName;
+
+		t_pRing = pRing.get();
+		registry.Rings.push_back(std::move(pRing));
+		return t_pRing;
+	}
+
+	// Zone names are meant to be plain identifiers, but keep the JSON valid
+	// whatever they are.
+	void WriteJsonString(std::ofstream& file, const char* sz)
+	{
+		file << '"';
+		for(; *sz; sz++)
+		{
+			if(*sz == '"' || *sz == '\\')
+				file << '\\' << *sz;
+			else if((unsigned char)*sz >= 0x20)
+				file << *sz;
+		}
+		file << '"';
+	}
+}
+
+//-----------------------------------------------------------------------------
+// CProfiler Member Functions
+//-----------------------------------------------------------------------------
+int64_t CProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CProfiler::Record(const char* szName, int64_t start, int64_t end)
+{
+	if(s_bShutDown.load(std::memory_order_relaxed))
+		return;
+
+	CProfileRing* pRing = ThreadRing();
+	uint64_t index = pRing->Written.load(std::memory_order_relaxed);
+
+	CProfileEvent& event = pRing->Events[index & (RING_SIZE - 1)];
+	event.Name = szName;
+	event.Start = start;
+	event.End = end;
+
+	pRing->Written.store(index + 1, std::memory_order_release);
+}
+
+void CProfiler::SetThreadName(const char* szName)
+{
+	if(s_bShutDown)
+		return;
+
+	CProfileRing* pRing = ThreadRing();
+	std::lock_guard<std::mutex> lock(Registry().Lock);
+	pRing->ThreadName = szName;
+}
+
+bool CProfiler::ExportChromeTrace(const char* szFileName)
+{
+	if(s_bShutDown)
+		return false;
+
+	struct CThreadEvents
+	{
+		int							ThreadId;
+		std::string					ThreadName;
+		std::vector<CProfileEvent>	Events;
+	};
+
+	// Copy the rings out first, so the file is written without the lock.
+	std::vector<CThreadEvents> threads;
+	int64_t origin = INT64_MAX;
+	{
+		CProfileRegistry& registry = Registry();
+		std::lock_guard<std::mutex> lock(registry.Lock);
+
+		threads.resize(registry.Rings.size());
+		for(size_t i = 0; i < registry.Rings.size(); i++)
+		{
+			const CProfileRing& ring = *registry.Rings[i];
+			CThreadEvents& thread = threads[i];
+			thread.ThreadId = ring.ThreadId;
+			thread.ThreadName = ring.ThreadName;
+
+			uint64_t written = ring.Written.load(std::memory_order_acquire);
+			uint64_t first = written > RING_SIZE ? written - RING_SIZE : 0;
+			std::vector<CProfileEvent> copy;
+			copy.reserve((size_t)(written - first));
+			for(uint64_t n = first; n < written; n++)
+				copy.push_back(ring.Events[n & (RING_SIZE - 1)]);
+
+			// Whatever the owner wrote meanwhile may have replaced the
+			// oldest part of the copy.
+			uint64_t now = ring.Written.load(std::memory_order_acquire);
+			uint64_t safe = now > RING_SIZE ? now - RING_SIZE : 0;
+			size_t skip = safe > first ? (size_t)(safe - first) : 0;
+			if(skip > copy.size())
+				skip = copy.size();
+
+			thread.Events.assign(copy.begin() + skip, copy.end());
+			for(size_t e = 0; e < thread.Events.size(); e++)
+				if(thread.Events[e].Start < origin)
+					origin = thread.Events[e].Start;
+		}
+	}
+
+	std::ofstream file(szFileName, std::ios::trunc);
+	if(!file.is_open())
+		return false;
+
+	// Complete ("X") events in microseconds from the first zone, plus the
+	// thread names as metadata.
+	char szTimes[64];
+	bool bFirst = true;
+	file << "{\"traceEvents\":[\n";
+	for(size_t i = 0; i < threads.size(); i++)
+	{
+		const CThreadEvents& thread = threads[i];
+
+		file << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			 << thread.ThreadId << ",\"args\":{\"name\":";
+		WriteJsonString(file, thread.ThreadName.c_str());
+		file << "}}";
+		bFirst = false;
+
+		for(size_t e = 0; e < thread.Events.size(); e++)
+		{
+			const CProfileEvent& event = thread.Events[e];
+			snprintf(szTimes, sizeof(szTimes), "\"ts\":%.3f,\"dur\":%.3f",
+				(double)(event.Start - origin) / 1000.0, (double)(event.End - event.Start) / 1000.0);
+
+			file << ",\n{\"name\":";
+			WriteJsonString(file, event.Name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.ThreadId << ',' << szTimes << '}';
+		}
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	return file.good();
+}
+
+#endif // GAME_PROFILER
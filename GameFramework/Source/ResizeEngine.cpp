@@ -1,4 +1,33 @@
 #include "ResizeEngine.h"
+#include "JobSystem.h"
+#include "CpuFeatures.h"
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+extern CJobSystem g_Jobs;
+
+// Destination pixels per job in the filter passes, at least. A band is
+// this many pixels' worth of whole rows (64 KB of output), so a sprite is
+// scaled in one go on the calling thread, and the threads of a big resize
+// each write a contiguous block that only meets its neighbours' at the
+// band edges.
+#define RESIZE_PIXELS_PER_JOB 16384
+
+namespace
+{
+	// A rounded weight, already scaled by RESIZE_WEIGHT_ONE, as the short
+	// the kernels read. Out of range it would wrap to the other sign, so it
+	// saturates instead; no filter here gets there.
+	inline short FixedWeight(double dFixed)
+	{
+		assert(dFixed >= SHRT_MIN && dFixed <= SHRT_MAX && "Weight outside the Q14 range of a short");
+		return (short)(dFixed < SHRT_MIN ? SHRT_MIN : dFixed > SHRT_MAX ? SHRT_MAX : dFixed);
+	}
+}
 
 CWeightsTable::CWeightsTable(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize) 
 {
@@ -22,17 +51,21 @@ CWeightsTable::CWeightsTable(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrc
 		dWidth= dFilterWidth;
 	}
 
-	// allocate a new line contributions structure
 	// window size is the number of sampled pixels
 	m_WindowSize = 2 * (int)ceil(dWidth) + 1;
+	m_WindowStride = (m_WindowSize + 7) & ~7;
 	m_LineLength = uDstSize;
-	// allocate list of contributions
-	m_WeightTable = new sContribution[m_LineLength];
-	for(u = 0 ; u < m_LineLength ; u++) 
-	{
-		// allocate contributions for every pixel
-		m_WeightTable[u].Weights = new double[m_WindowSize];
-	}
+
+	// one zeroed block for the weights (aligned for the kernels) and the
+	// bounds after them
+	size_t weightBytes = (size_t)m_LineLength * m_WindowStride * sizeof(short);
+	m_pBuffer = new unsigned char[weightBytes + (size_t)m_LineLength * 2 * sizeof(int) + 31];
+	m_pWeights = (short *)(((size_t)m_pBuffer + 31) & ~(size_t)31);
+	m_pBounds = (int *)((unsigned char *)m_pWeights + weightBytes);
+	memset(m_pWeights, 0, weightBytes);
+
+	// one window of weights in double, before rounding
+	std::vector<double> weights(m_WindowSize);
 
 	for(u = 0; u < m_LineLength; u++) 
 	{
@@ -55,16 +88,18 @@ CWeightsTable::CWeightsTable(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrc
 			}
 		}
 
-		m_WeightTable[u].Left = iLeft;
-		m_WeightTable[u].Right = iRight;
+		m_pBounds[2 * u] = iLeft;
+		m_pBounds[2 * u + 1] = iRight;
+
+		// calculate weights
+		pFilter->Sample(dCenter, dFScale, iLeft, iRight - iLeft + 1, &weights[0]);
 
 		int iSrc = 0;
 		double dTotalWeight = 0;  // zero sum of weights
 		for(iSrc = iLeft; iSrc <= iRight; iSrc++) 
 		{
-			// calculate weights
-			double weight = dFScale * pFilter->Filter(dFScale * (dCenter - (double)iSrc));
-			m_WeightTable[u].Weights[iSrc-iLeft] = weight;
+			double weight = dFScale * weights[iSrc-iLeft];
+			weights[iSrc-iLeft] = weight;
 			dTotalWeight += weight;
 		}
 
@@ -74,52 +109,467 @@ CWeightsTable::CWeightsTable(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrc
 			for(iSrc = iLeft; iSrc <= iRight; iSrc++)
 			{
 				// normalize point
-				m_WeightTable[u].Weights[iSrc-iLeft] /= dTotalWeight;
+				weights[iSrc-iLeft] /= dTotalWeight;
 			}
 		}
+
+		// Round to fixed point, then hand the rounding error to the
+		// largest weight, so flat areas keep their exact color.
+		short *pFixed = m_pWeights + u * m_WindowStride;
+		int iFixedTotal = 0;
+		int iLargest = 0;
+		for(iSrc = 0; iSrc <= iRight - iLeft; iSrc++)
+		{
+			pFixed[iSrc] = FixedWeight(floor(weights[iSrc] * RESIZE_WEIGHT_ONE + 0.5));
+			iFixedTotal += pFixed[iSrc];
+			if(fabs(weights[iSrc]) > fabs(weights[iLargest]))
+				iLargest = iSrc;
+		}
+		if(dTotalWeight > 0)
+			pFixed[iLargest] = FixedWeight((double)pFixed[iLargest] + (RESIZE_WEIGHT_ONE - iFixedTotal));
 	}
 }
 
 CWeightsTable::~CWeightsTable() 
 {
-		for(DWORD u = 0; u < m_LineLength; u++) 
+		delete []m_pBuffer;
+}
+
+
+CWeightsCache::Key::Key(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize)
+	: Type(typeid(*pFilter)), Width(pFilter->GetWidth()), DstSize(uDstSize), SrcSize(uSrcSize)
+{
+	pFilter->GetShape(ShapeP, ShapeQ);
+}
+
+bool CWeightsCache::Key::operator<(const Key &rhs) const
+{
+	return std::tie(Type, Width, ShapeP, ShapeQ, DstSize, SrcSize)
+		 < std::tie(rhs.Type, rhs.Width, rhs.ShapeP, rhs.ShapeQ, rhs.DstSize, rhs.SrcSize);
+}
+
+CWeightsCache::CWeightsCache() : m_nUses(0)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+WeightsTablePtr CWeightsCache::Acquire(CGenericFilter *pFilter, DWORD uDstSize, DWORD uSrcSize)
+{
+	Key key(pFilter, uDstSize, uSrcSize);
+
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	TableMap::iterator it = m_Tables.find(key);
+	if(it != m_Tables.end())
+	{
+		m_Stats.Hits++;
+		it->second.LastUse = ++m_nUses;
+		return it->second.pTable;
+	}
+
+	// Built under the lock, like the asset cache's decodes; a table takes
+	// well under a millisecond.
+	m_Stats.Misses++;
+	Evict();
+
+	Entry &entry = m_Tables.insert(TableMap::value_type(key, Entry())).first->second;
+	entry.pTable = std::make_shared<CWeightsTable>(pFilter, uDstSize, uSrcSize);
+	entry.LastUse = ++m_nUses;
+	m_Stats.TableCount++;
+	m_Stats.BytesResident += entry.pTable->SizeInBytes();
+	return entry.pTable;
+}
+
+// Makes room for one more table. Tables still in use stay, so a burst of
+// resizes can briefly hold more than MAX_TABLES.
+void CWeightsCache::Evict()
+{
+	while(m_Tables.size() >= MAX_TABLES)
+	{
+		TableMap::iterator oldest = m_Tables.end();
+		for(TableMap::iterator it = m_Tables.begin(); it != m_Tables.end(); ++it)
 		{
-				// free contributions for every pixel
-				delete []m_WeightTable[u].Weights;
+			if(it->second.pTable.use_count() == 1 && (oldest == m_Tables.end() || it->second.LastUse < oldest->second.LastUse))
+				oldest = it;
 		}
+		if(oldest == m_Tables.end())
+			return;
 
-		// free list of pixels contributions
-		delete []m_WeightTable;
+		m_Stats.TableCount--;
+		m_Stats.BytesResident -= oldest->second.pTable->SizeInBytes();
+		m_Tables.erase(oldest);
+	}
 }
 
+void CWeightsCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
 
-void CResizableImage::ScaleRow(unsigned int dst_width, unsigned int /*dst_height*/, unsigned int row)
+	for(TableMap::iterator it = m_Tables.begin(); it != m_Tables.end(); )
+	{
+		if(it->second.pTable.use_count() == 1)
+		{
+			m_Stats.TableCount--;
+			m_Stats.BytesResident -= it->second.pTable->SizeInBytes();
+			it = m_Tables.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void CWeightsCache::Clear()
 {
-	RGBQUAD *pDstRow = &(m_pResImg[row * dst_width]);
-	RGBQUAD *pSrcRow = &(m_pRGB[row * width]);
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	m_Tables.clear();
+	m_Stats.TableCount = 0;
+	m_Stats.BytesResident = 0;
+}
 
-	for (UINT x = 0; x < dst_width; x++) 
+CWeightsCache::Stats CWeightsCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Stats;
+}
+
+CWeightsCache &GetWeightsCache()
+{
+	// Built on first use, so it is there for resizes during static setup
+	static CWeightsCache cache;
+	return cache;
+}
+
+
+namespace
+{
+	//-------------------------------------------------------------------------
+	// Pass kernels, in fixed point. The row kernels make a destination row
+	// from one source row, each output pixel summing the source pixels in
+	// its window. The blend kernels make a destination row of the vertical
+	// pass from the source rows in one window, walking all of them left to
+	// right, so every read is sequential whatever the image width.
+	//-------------------------------------------------------------------------
+	inline BYTE FixedToByte(int iValue)
+	{
+		iValue >>= RESIZE_WEIGHT_BITS;
+		return (BYTE)(iValue < 0 ? 0 : iValue > 255 ? 255 : iValue);
+	}
+
+	void ResampleRowScalar(RGBQUAD *pDst, const RGBQUAD *pSrc, const CWeightsTable &weights, unsigned int count)
+	{
+		for (unsigned int u = 0; u < count; u++)
+		{
+			int iLeft = weights.getLeftBoundary(u);
+			int iTaps = weights.getRightBoundary(u) - iLeft + 1;
+			const short *pWeights = weights.getFixedWeights(u);
+			const RGBQUAD *pTap = pSrc + iLeft;
+
+			// Start at one half, so the shift rounds
+			int r = RESIZE_WEIGHT_ONE / 2;
+			int g = RESIZE_WEIGHT_ONE / 2;
+			int b = RESIZE_WEIGHT_ONE / 2;
+			for (int i = 0; i < iTaps; i++)
+			{
+				r += pWeights[i] * pTap[i].rgbRed;
+				g += pWeights[i] * pTap[i].rgbGreen;
+				b += pWeights[i] * pTap[i].rgbBlue;
+			}
+
+			pDst[u].rgbRed = FixedToByte(r);
+			pDst[u].rgbGreen = FixedToByte(g);
+			pDst[u].rgbBlue = FixedToByte(b);
+			pDst[u].rgbReserved = 0;
+		}
+	}
+
+	// Columns [first, count) of a blend; the vector kernels finish with it.
+	void BlendRowsScalar(RGBQUAD *pDst, const RGBQUAD *pSrc, size_t srcPitch, const short *pWeights, int iTaps,
+						 unsigned int first, unsigned int count)
+	{
+		for (unsigned int x = first; x < count; x++)
+		{
+			const RGBQUAD *pTap = pSrc + x;
+
+			int r = RESIZE_WEIGHT_ONE / 2;
+			int g = RESIZE_WEIGHT_ONE / 2;
+			int b = RESIZE_WEIGHT_ONE / 2;
+			for (int i = 0; i < iTaps; i++, pTap += srcPitch)
+			{
+				r += pWeights[i] * pTap->rgbRed;
+				g += pWeights[i] * pTap->rgbGreen;
+				b += pWeights[i] * pTap->rgbBlue;
+			}
+
+			pDst[x].rgbRed = FixedToByte(r);
+			pDst[x].rgbGreen = FixedToByte(g);
+			pDst[x].rgbBlue = FixedToByte(b);
+			pDst[x].rgbReserved = 0;
+		}
+	}
+
+	void BlendRowsScalar(RGBQUAD *pDst, const RGBQUAD *pSrc, size_t srcPitch, const short *pWeights, int iTaps,
+						 unsigned int count)
 	{
-		// Loop through row
-		BYTE r = 0;
-		BYTE g = 0;
-		BYTE b = 0;
-		int iLeft = m_pWeights->getLeftBoundary(x);	// Retrieve left boundries
-		int iRight = m_pWeights->getRightBoundary(x);  // Retrieve right boundries
-		for (int i = iLeft; i <= iRight; i++)
+		BlendRowsScalar(pDst, pSrc, srcPitch, pWeights, iTaps, 0, count);
+	}
+
+#ifdef CPU_X86
+	inline int PixelBits(const RGBQUAD *pPixel)
+	{
+		int iBits;
+		memcpy(&iBits, pPixel, sizeof(iBits));
+		return iBits;
+	}
+
+	// A pair of taps as pmaddwd multipliers: (w0, w1) in every dword.
+	inline int WeightPair(const short *pWeights)
+	{
+		return (int)((unsigned short)pWeights[0] | ((unsigned int)(unsigned short)pWeights[1] << 16));
+	}
+
+	// Adds taps [i, iTaps) of one output pixel to its four channel sums,
+	// two taps per multiply: the pixels are interleaved channel by channel
+	// (b0 b1 g0 g1 r0 r1 a0 a1) and pmaddwd sums each pair of products.
+	inline __m128i AccumulateTapsSSE2(__m128i acc, const RGBQUAD *pTap, const short *pWeights, int i, int iTaps)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 2 <= iTaps; i += 2)
 		{
-			// Scan between boundries
-			// Accumulate weighted effect of each neighboring pixel
-			r += (BYTE)(m_pWeights->getWeight(x, i-iLeft) * (double)(pSrcRow[i].rgbRed)); 
-			g += (BYTE)(m_pWeights->getWeight(x, i-iLeft) * (double)(pSrcRow[i].rgbGreen)); 
-			b += (BYTE)(m_pWeights->getWeight(x, i-iLeft) * (double)(pSrcRow[i].rgbBlue)); 
-		} 
-		// set destination row
-		pDstRow[x].rgbRed = r;
-		pDstRow[x].rgbGreen = g;
-		pDstRow[x].rgbBlue = b;
-		pDstRow[x].rgbReserved = 0;
+			__m128i p0 = _mm_cvtsi32_si128(PixelBits(pTap + i));
+			__m128i p1 = _mm_cvtsi32_si128(PixelBits(pTap + i + 1));
+			__m128i p = _mm_unpacklo_epi8(_mm_unpacklo_epi8(p0, p1), zero);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(p, _mm_set1_epi32(WeightPair(pWeights + i))));
+		}
+
+		if (i < iTaps)
+		{
+			__m128i p = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(PixelBits(pTap + i)), zero), zero);
+			__m128i w = _mm_set1_epi32((unsigned short)pWeights[i]);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(p, w));
+		}
+
+		return acc;
+	}
+
+	// Rounds the channel sums down to bytes, saturating, and drops alpha.
+	inline void StorePixelSSE2(RGBQUAD *pDst, __m128i acc)
+	{
+		acc = _mm_srai_epi32(acc, RESIZE_WEIGHT_BITS);
+		acc = _mm_packs_epi32(acc, acc);
+		acc = _mm_packus_epi16(acc, acc);
+
+		int iBits = _mm_cvtsi128_si32(acc) & 0x00FFFFFF;
+		memcpy(pDst, &iBits, sizeof(iBits));
 	}
+
+	void ResampleRowSSE2(RGBQUAD *pDst, const RGBQUAD *pSrc, const CWeightsTable &weights, unsigned int count)
+	{
+		const __m128i half = _mm_set1_epi32(RESIZE_WEIGHT_ONE / 2);
+
+		for (unsigned int u = 0; u < count; u++)
+		{
+			int iLeft = weights.getLeftBoundary(u);
+			int iTaps = weights.getRightBoundary(u) - iLeft + 1;
+
+			__m128i acc = AccumulateTapsSSE2(half, pSrc + iLeft, weights.getFixedWeights(u), 0, iTaps);
+			StorePixelSSE2(pDst + u, acc);
+		}
+	}
+
+	// Four taps per multiply: two interleaved pairs, one per 128 bit lane.
+	CPU_AVX2_FUNC void ResampleRowAVX2(RGBQUAD *pDst, const RGBQUAD *pSrc, const CWeightsTable &weights, unsigned int count)
+	{
+		const __m128i half = _mm_set1_epi32(RESIZE_WEIGHT_ONE / 2);
+		const __m128i interleave = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+		const __m256i lanePairs = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+
+		for (unsigned int u = 0; u < count; u++)
+		{
+			int iLeft = weights.getLeftBoundary(u);
+			int iTaps = weights.getRightBoundary(u) - iLeft + 1;
+			const short *pWeights = weights.getFixedWeights(u);
+			const RGBQUAD *pTap = pSrc + iLeft;
+
+			__m256i acc = _mm256_setzero_si256();
+			int i = 0;
+			for (; i + 4 <= iTaps; i += 4)
+			{
+				__m128i q = _mm_loadu_si128((const __m128i *)(pTap + i));
+				__m256i p = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(q, interleave));
+				__m256i w = _mm256_permutevar8x32_epi32(
+					_mm256_castsi128_si256(_mm_loadl_epi64((const __m128i *)(pWeights + i))), lanePairs);
+				acc = _mm256_add_epi32(acc, _mm256_madd_epi16(p, w));
+			}
+
+			__m128i acc128 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+			acc128 = AccumulateTapsSSE2(_mm_add_epi32(acc128, half), pTap, pWeights, i, iTaps);
+			StorePixelSSE2(pDst + u, acc128);
+		}
+	}
+
+	// Four pixels at a time, two source rows per multiply: the rows are
+	// interleaved byte by byte, so each pixel's channels come in pairs.
+	void BlendRowsSSE2(RGBQUAD *pDst, const RGBQUAD *pSrc, size_t srcPitch, const short *pWeights, int iTaps,
+					   unsigned int count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i half = _mm_set1_epi32(RESIZE_WEIGHT_ONE / 2);
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+
+		unsigned int x = 0;
+		for (; x + 4 <= count; x += 4)
+		{
+			__m128i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+			const RGBQUAD *pTap = pSrc + x;
+
+			for (int i = 0; i < iTaps; i += 2, pTap += 2 * srcPitch)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i *)pTap);
+				__m128i b = i + 1 < iTaps ? _mm_loadu_si128((const __m128i *)(pTap + srcPitch)) : zero;
+				__m128i w = _mm_set1_epi32(i + 1 < iTaps ? WeightPair(pWeights + i) : (unsigned short)pWeights[i]);
+
+				__m128i lo = _mm_unpacklo_epi8(a, b);
+				__m128i hi = _mm_unpackhi_epi8(a, b);
+				acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+				acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+				acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+				acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+			}
+
+			__m128i p01 = _mm_packs_epi32(_mm_srai_epi32(acc0, RESIZE_WEIGHT_BITS), _mm_srai_epi32(acc1, RESIZE_WEIGHT_BITS));
+			__m128i p23 = _mm_packs_epi32(_mm_srai_epi32(acc2, RESIZE_WEIGHT_BITS), _mm_srai_epi32(acc3, RESIZE_WEIGHT_BITS));
+			_mm_storeu_si128((__m128i *)(pDst + x), _mm_and_si128(_mm_packus_epi16(p01, p23), colorMask));
+		}
+
+		BlendRowsScalar(pDst, pSrc, srcPitch, pWeights, iTaps, x, count);
+	}
+
+	// Eight pixels at a time. The unpacks work within each 128 bit lane,
+	// so the sums hold pixels (0, 4), (1, 5), (2, 6) and (3, 7), and the
+	// packs put them back in order.
+	CPU_AVX2_FUNC void BlendRowsAVX2(RGBQUAD *pDst, const RGBQUAD *pSrc, size_t srcPitch, const short *pWeights,
+									 int iTaps, unsigned int count)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i half = _mm256_set1_epi32(RESIZE_WEIGHT_ONE / 2);
+		const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+
+		unsigned int x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			__m256i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+			const RGBQUAD *pTap = pSrc + x;
+
+			for (int i = 0; i < iTaps; i += 2, pTap += 2 * srcPitch)
+			{
+				__m256i a = _mm256_loadu_si256((const __m256i *)pTap);
+				__m256i b = i + 1 < iTaps ? _mm256_loadu_si256((const __m256i *)(pTap + srcPitch)) : zero;
+				__m256i w = _mm256_set1_epi32(i + 1 < iTaps ? WeightPair(pWeights + i) : (unsigned short)pWeights[i]);
+
+				__m256i lo = _mm256_unpacklo_epi8(a, b);
+				__m256i hi = _mm256_unpackhi_epi8(a, b);
+				acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), w));
+				acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), w));
+				acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), w));
+				acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), w));
+			}
+
+			__m256i p01 = _mm256_packs_epi32(_mm256_srai_epi32(acc0, RESIZE_WEIGHT_BITS), _mm256_srai_epi32(acc1, RESIZE_WEIGHT_BITS));
+			__m256i p23 = _mm256_packs_epi32(_mm256_srai_epi32(acc2, RESIZE_WEIGHT_BITS), _mm256_srai_epi32(acc3, RESIZE_WEIGHT_BITS));
+			_mm256_storeu_si256((__m256i *)(pDst + x), _mm256_and_si256(_mm256_packus_epi16(p01, p23), colorMask));
+		}
+
+		// The SSE2 kernel is not inlined here; clear the upper halves first,
+		// or it and all legacy SSE code after it (libm included) pay for
+		// the dirty AVX state.
+		_mm256_zeroupper();
+		BlendRowsSSE2(pDst + x, pSrc + x, srcPitch, pWeights, iTaps, count - x);
+	}
+#endif
+
+	typedef void (*ResampleRowFunc)(RGBQUAD *pDst, const RGBQUAD *pSrc, const CWeightsTable &weights, unsigned int count);
+	typedef void (*BlendRowsFunc)(RGBQUAD *pDst, const RGBQUAD *pSrc, size_t srcPitch, const short *pWeights,
+								  int iTaps, unsigned int count);
+
+	EResamplePath BestResamplePath()
+	{
+#ifdef CPU_X86
+		return CpuHasAVX2() ? RESAMPLE_AVX2 : RESAMPLE_SSE2;
+#else
+		return RESAMPLE_SCALAR;
+#endif
+	}
+
+	EResamplePath		g_ResamplePath = BestResamplePath();
+
+	ResampleRowFunc RowKernel(EResamplePath path)
+	{
+		switch(path)
+		{
+#ifdef CPU_X86
+		case RESAMPLE_AVX2:	return ResampleRowAVX2;
+		case RESAMPLE_SSE2:	return ResampleRowSSE2;
+#endif
+		default:			return ResampleRowScalar;
+		}
+	}
+
+	BlendRowsFunc BlendKernel(EResamplePath path)
+	{
+		switch(path)
+		{
+#ifdef CPU_X86
+		case RESAMPLE_AVX2:	return BlendRowsAVX2;
+		case RESAMPLE_SSE2:	return BlendRowsSSE2;
+#endif
+		default:			return BlendRowsScalar;
+		}
+	}
+
+	ResampleRowFunc		g_ResampleRow = RowKernel(g_ResamplePath);
+	BlendRowsFunc		g_BlendRows = BlendKernel(g_ResamplePath);
+
+	// Rows per band for destination rows this wide.
+	size_t BandRows(unsigned int row_pixels)
+	{
+		return row_pixels < RESIZE_PIXELS_PER_JOB ? RESIZE_PIXELS_PER_JOB / row_pixels : 1;
+	}
+}
+
+EResamplePath GetResamplePath()
+{
+	return g_ResamplePath;
+}
+
+void SetResamplePath(EResamplePath path)
+{
+	// Never select a kernel the CPU cannot run.
+	if(path > BestResamplePath())
+		path = BestResamplePath();
+
+	g_ResamplePath = path;
+	g_ResampleRow = RowKernel(path);
+	g_BlendRows = BlendKernel(path);
+}
+
+void ResampleVertical(RGBQUAD *pDst, const RGBQUAD *pSrc, unsigned int width,
+					  const CWeightsTable &weights, unsigned int dst_height)
+{
+	for (unsigned int u = 0; u < dst_height; u++)
+	{
+		int iLeft = weights.getLeftBoundary(u);
+		int iTaps = weights.getRightBoundary(u) - iLeft + 1;
+
+		g_BlendRows(&pDst[u * width], &pSrc[iLeft * width], width, weights.getFixedWeights(u), iTaps, width);
+	}
+}
+
+
+void CResizableImage::ScaleRow(unsigned int dst_width, unsigned int /*dst_height*/, unsigned int row)
+{
+	g_ResampleRow(&m_pResImg[row * dst_width], &m_pRGB[row * width], *m_pWeights, dst_width);
 }
 
 void CResizableImage::HorizontalFilter(unsigned int dst_width, unsigned int dst_height)
@@ -131,43 +581,28 @@ void CResizableImage::HorizontalFilter(unsigned int dst_width, unsigned int dst_
 		memcpy (m_pResImg, m_pRGB, sizeof(RGBQUAD) * width * height);
 	}
 	
-	m_pWeights = new CWeightsTable(m_pFilter, dst_width, width);
+	m_pWeights = GetWeightsCache().Acquire(m_pFilter, dst_width, width);
 
-	for (UINT u = 0; u < dst_height; u++)
+	// Rows are independent, so bands of them are scaled on the job system.
+	g_Jobs.ParallelFor(0, dst_height, BandRows(dst_width), [&](size_t first, size_t last)
 	{
-		// scale each row
-		ScaleRow (dst_width, dst_width, u);	// Scale each row 
-	}
+		for (UINT u = (UINT)first; u < (UINT)last; u++)
+		{
+			// scale each row
+			ScaleRow (dst_width, dst_width, u);	// Scale each row 
+		}
+	});
 
-	delete m_pWeights;
+	m_pWeights.reset();
 }
 
-void CResizableImage::ScaleCol(unsigned int dst_width, unsigned int dst_height, unsigned int col)
-{ 
-	for (UINT y = 0; y < dst_height; y++) 
-	{
-		// Loop through column
-		BYTE r = 0;
-		BYTE g = 0;
-		BYTE b = 0;
-		int iLeft = m_pWeights->getLeftBoundary(y);	// Retrieve left boundries
-		int iRight = m_pWeights->getRightBoundary(y);  // Retrieve right boundries
-		for (int i = iLeft; i <= iRight; i++)
-		{
-			// Scan between boundries
-			// Accumulate weighted effect of each neighboring pixel
-			RGBQUAD &src = m_pRGB[i * width + col];
-			r += (BYTE)(m_pWeights->getWeight(y, i-iLeft) * (double)(src.rgbRed));
-			g += (BYTE)(m_pWeights->getWeight(y, i-iLeft) * (double)(src.rgbGreen));
-			b += (BYTE)(m_pWeights->getWeight(y, i-iLeft) * (double)(src.rgbBlue));
-		}
+void CResizableImage::ScaleCols(unsigned int dst_width, unsigned int row)
+{
+	int iLeft = m_pWeights->getLeftBoundary(row);
+	int iTaps = m_pWeights->getRightBoundary(row) - iLeft + 1;
 
-		RGBQUAD &dst = m_pResImg[y * dst_width + col];
-		dst.rgbRed = r;
-		dst.rgbGreen = g;
-		dst.rgbBlue = b;
-		dst.rgbReserved = 0;
-	}
+	g_BlendRows(&m_pResImg[row * dst_width], &m_pRGB[iLeft * width], width,
+				m_pWeights->getFixedWeights(row), iTaps, dst_width);
 }
 
 
@@ -179,18 +614,63 @@ void CResizableImage::VerticalFilter(unsigned int dst_width, unsigned int dst_he
 		memcpy(m_pResImg, m_pRGB, sizeof (RGBQUAD) * width * height);
 	}
 	
-	m_pWeights = new CWeightsTable(m_pFilter, dst_height, height);
+	m_pWeights = GetWeightsCache().Acquire(m_pFilter, dst_height, height);
 
-	for (UINT u = 0; u < dst_width; u++)
+	// Each destination row blends a few whole source rows, so bands of
+	// destination rows are the jobs here too; neighbouring bands only
+	// share the source rows their windows overlap on, which they just read.
+	g_Jobs.ParallelFor(0, dst_height, BandRows(dst_width), [&](size_t first, size_t last)
 	{
-		// Step through columns
-		ScaleCol(dst_width, dst_height, u);   // Scale each column
-	}
+		for (UINT u = (UINT)first; u < (UINT)last; u++)
+		{
+			// Scale every column of the row
+			ScaleCols(dst_width, u);
+		}
+	});
 
-	delete m_pWeights;
+	m_pWeights.reset();
+}
+
+CResizableImage::~CResizableImage()
+{
+	// A queued resize still uses the image and its job
+	g_Jobs.Wait(m_ResizeJob);
 }
 
 void CResizableImage::Resample(unsigned dst_width, unsigned dst_height)
+{
+	g_Jobs.Wait(m_ResizeJob);
+	ResampleImage(dst_width, dst_height);
+}
+
+std::future<void> CResizableImage::ResampleAsync(unsigned dst_width, unsigned dst_height)
+{
+	g_Jobs.Wait(m_ResizeJob);
+
+	std::shared_ptr<std::promise<void> > pDone = std::make_shared<std::promise<void> >();
+	std::future<void> done = pDone->get_future();
+
+	// Without workers a queued job only runs inside a Wait(), and waiting
+	// on the future is not one.
+	if(g_Jobs.GetWorkerCount() == 0)
+	{
+		ResampleImage(dst_width, dst_height);
+		pDone->set_value();
+		return done;
+	}
+
+	m_ResizeJob.Set([this, pDone, dst_width, dst_height]()
+	{
+		ResampleImage(dst_width, dst_height);
+		pDone->set_value();
+	});
+	// For the workers only: a frame thread that waits on jobs of its own
+	// meanwhile must not end up running the whole resize.
+	g_Jobs.SubmitBackground(m_ResizeJob);
+	return done;
+}
+
+void CResizableImage::ResampleImage(unsigned dst_width, unsigned dst_height)
 {
 	// decide which filtering order (xy or yx) is faster for this mapping
 	if(dst_width * height <= dst_height * width) 
@@ -199,7 +679,7 @@ void CResizableImage::Resample(unsigned dst_width, unsigned dst_height)
 
 		HorizontalFilter(dst_width, height);
 		
-		delete m_pRGB;
+		delete[] m_pRGB;
 		m_pRGB = m_pResImg;
 		width = dst_width;
 		m_pResImg = new RGBQUAD[dst_width * dst_height];
@@ -211,7 +691,7 @@ void CResizableImage::Resample(unsigned dst_width, unsigned dst_height)
 		m_pResImg = new RGBQUAD[width * dst_height];
 		VerticalFilter(width, dst_height);
 		
-		delete m_pRGB;
+		delete[] m_pRGB;
 		m_pRGB = m_pResImg;
 		height = dst_height;
 		m_pResImg = new RGBQUAD[dst_width * dst_height];
@@ -219,11 +699,14 @@ void CResizableImage::Resample(unsigned dst_width, unsigned dst_height)
 		HorizontalFilter(dst_width, dst_height);
 	}
 
-	delete m_pRGB;
+	delete[] m_pRGB;
 	m_pRGB = m_pResImg;
 	width = dst_width;
 	height = dst_height;
 
+#ifdef _WIN32
+	// The bitmap has the old size; Paint makes a new one
 	DeleteObject(m_hBMP);
 	m_hBMP = 0;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+// SpatialHash.cpp
+// Uniform grid broadphase for circle colliders.
+#include "SpatialHash.h"
+#include "JobSystem.h"
+#include <math.h>
+
+extern CJobSystem g_Jobs;
+
+CSpatialHash::CSpatialHash(float fCellSize)
+{
+	SetCellSize(fCellSize);
+	m_bBuilt = false;
+}
+
+void CSpatialHash::SetCellSize(float fCellSize)
+{
+	m_fCellSize = fCellSize > 1.0f ? fCellSize : 1.0f;
+	m_fInvCellSize = 1.0f / m_fCellSize;
+	m_bBuilt = false;
+}
+
+void CSpatialHash::Clear()
+{
+	// Keep the capacity, the grid is rebuilt every frame.
+	m_Colliders.clear();
+	m_bBuilt = false;
+}
+
+void CSpatialHash::Insert(int layer, int id, float x, float y, float radius)
+{
+	Collider c;
+	c.x = x;
+	c.y = y;
+	c.radius = radius;
+	c.layer = layer;
+	c.id = id;
+	c.minX = (int)floorf((x - radius) * m_fInvCellSize);
+	c.minY = (int)floorf((y - radius) * m_fInvCellSize);
+	c.maxX = (int)floorf((x + radius) * m_fInvCellSize);
+	c.maxY = (int)floorf((y + radius) * m_fInvCellSize);
+
+	m_Colliders.push_back(c);
+	m_bBuilt = false;
+}
+
+bool CSpatialHash::Overlap(const Collider& a, const Collider& b)
+{
+	float dx = a.x - b.x;
+	float dy = a.y - b.y;
+	float r = a.radius + b.radius;
+	return dx * dx + dy * dy <= r * r;
+}
+
+unsigned int CSpatialHash::Bucket(int cellX, int cellY) const
+{
+	// Large primes scatter neighbouring cells across the table.
+	unsigned int h = ((unsigned int)cellX * 73856093u) ^ ((unsigned int)cellY * 19349663u);
+	return h & (unsigned int)(m_BucketStart.size() - 2);
+}
+
+void CSpatialHash::Build()
+{
+	// Count the cells covered so the table is about twice that size.
+	size_t cellCount = 0;
+	for(size_t i = 0; i < m_Colliders.size(); i++)
+	{
+		const Collider& c = m_Colliders[i];
+		cellCount += (size_t)(c.maxX - c.minX + 1) * (c.maxY - c.minY + 1);
+	}
+
+	size_t buckets = 64;
+	while(buckets < cellCount * 2)
+		buckets <<= 1;
+
+	// Counting sort of the cell entries by bucket: count, prefix sum, fill.
+	m_BucketStart.assign(buckets + 1, 0);
+	m_Entries.resize(cellCount);
+
+	for(size_t i = 0; i < m_Colliders.size(); i++)
+	{
+		const Collider& c = m_Colliders[i];
+		for(int cy = c.minY; cy <= c.maxY; cy++)
+			for(int cx = c.minX; cx <= c.maxX; cx++)
+				m_BucketStart[Bucket(cx, cy) + 1]++;
+	}
+
+	for(size_t b = 1; b <= buckets; b++)
+		m_BucketStart[b] += m_BucketStart[b - 1];
+
+	m_BucketFill.assign(m_BucketStart.begin(), m_BucketStart.end() - 1);
+	for(size_t i = 0; i < m_Colliders.size(); i++)
+	{
+		const Collider& c = m_Colliders[i];
+		for(int cy = c.minY; cy <= c.maxY; cy++)
+			for(int cx = c.minX; cx <= c.maxX; cx++)
+			{
+				CellEntry& e = m_Entries[m_BucketFill[Bucket(cx, cy)]++];
+				e.cellX = cx;
+				e.cellY = cy;
+				e.collider = (int)i;
+			}
+	}
+
+	m_bBuilt = true;
+}
+
+void CSpatialHash::FindPairs(int layerA, int layerB, std::vector<CCollisionPair>& pairs)
+{
+	if(!m_bBuilt)
+		Build();
+
+	size_t buckets = m_BucketStart.size() - 1;
+	if(m_Entries.size() < PARALLEL_PAIRS_MIN)
+	{
+		FindPairsInBuckets(layerA, layerB, 0, buckets, pairs);
+		return;
+	}
+
+	// Buckets are independent, so each chunk gets its own run of them and
+	// its own output; joining the outputs in order keeps the serial order.
+	size_t chunks = (size_t)g_Jobs.GetThreadCount() * 4;
+	if(chunks > PAIR_CHUNKS)
+		chunks = PAIR_CHUNKS;
+	size_t chunkSize = (buckets + chunks - 1) / chunks;
+
+	g_Jobs.ParallelFor(0, chunks, 1, [&](size_t c0, size_t c1)
+	{
+		for(size_t c = c0; c < c1; c++)
+		{
+			size_t first = c * chunkSize;
+			size_t last = first + chunkSize < buckets ? first + chunkSize : buckets;
+			m_ChunkPairs[c].clear();
+			if(first < last)
+				FindPairsInBuckets(layerA, layerB, first, last, m_ChunkPairs[c]);
+		}
+	});
+
+	for(size_t c = 0; c < chunks; c++)
+		pairs.insert(pairs.end(), m_ChunkPairs[c].begin(), m_ChunkPairs[c].end());
+}
+
+void CSpatialHash::FindPairsInBuckets(int layerA, int layerB, size_t first, size_t last, std::vector<CCollisionPair>& pairs) const
+{
+	for(size_t b = first; b < last; b++)
+	{
+		unsigned int begin = m_BucketStart[b], end = m_BucketStart[b + 1];
+		for(unsigned int i = begin; i < end; i++)
+		{
+			const CellEntry& ei = m_Entries[i];
+			const Collider& a = m_Colliders[ei.collider];
+			if(a.layer != layerA)
+				continue;
+
+			for(unsigned int j = begin; j < end; j++)
+			{
+				const CellEntry& ej = m_Entries[j];
+				if(ej.cellX != ei.cellX || ej.cellY != ei.cellY || ej.collider == ei.collider)
+					continue;
+
+				const Collider& bc = m_Colliders[ej.collider];
+				if(bc.layer != layerB)
+					continue;
+
+				// Within one layer every pair shows up both ways round.
+				if(layerA == layerB && ej.collider < ei.collider)
+					continue;
+
+				// Colliders spanning several cells meet in each of them; only
+				// report the pair from the first cell they share.
+				int ownerX = a.minX > bc.minX ? a.minX : bc.minX;
+				int ownerY = a.minY > bc.minY ? a.minY : bc.minY;
+				if(ei.cellX != ownerX || ei.cellY != ownerY)
+					continue;
+
+				if(Overlap(a, bc))
+				{
+					CCollisionPair p = { a.id, bc.id };
+					pairs.push_back(p);
+				}
+			}
+		}
+	}
+}
+
+void CSpatialHash::FindOverlaps(int layer, float x, float y, float radius, std::vector<int>& ids)
+{
+	if(!m_bBuilt)
+		Build();
+
+	Collider probe;
+	probe.x = x;
+	probe.y = y;
+	probe.radius = radius;
+	probe.layer = layer;
+	probe.id = -1;
+	probe.minX = (int)floorf((x - radius) * m_fInvCellSize);
+	probe.minY = (int)floorf((y - radius) * m_fInvCellSize);
+	probe.maxX = (int)floorf((x + radius) * m_fInvCellSize);
+	probe.maxY = (int)floorf((y + radius) * m_fInvCellSize);
+
+	for(int cy = probe.minY; cy <= probe.maxY; cy++)
+		for(int cx = probe.minX; cx <= probe.maxX; cx++)
+		{
+			unsigned int b = Bucket(cx, cy);
+			for(unsigned int i = m_BucketStart[b]; i < m_BucketStart[b + 1]; i++)
+			{
+				const CellEntry& e = m_Entries[i];
+				if(e.cellX != cx || e.cellY != cy)
+					continue;
+
+				const Collider& c = m_Colliders[e.collider];
+				if(c.layer != layer)
+					continue;
+
+				// Same first-shared-cell rule as FindPairs.
+				int ownerX = c.minX > probe.minX ? c.minX : probe.minX;
+				int ownerY = c.minY > probe.minY ? c.minY : probe.minY;
+				if(cx == ownerX && cy == ownerY && Overlap(c, probe))
+					ids.push_back(c.id);
+			}
+		}
+}
@@ -1,196 +1,191 @@
 #include "Sprite.h"
 
+extern CAssetCache g_Assets;
+
+// Bitmap resources are only in the Windows build.
+#ifdef _WIN32
 extern HINSTANCE g_hInst;
 
+// Converts a bitmap resource into a pixel image.
+static PixelImagePtr ImageFromBitmap(HBITMAP hBitmap)
+{
+	BITMAP bm;
+	if(!hBitmap || !GetObject(hBitmap, sizeof(BITMAP), &bm))
+		return PixelImagePtr();
+
+	BITMAPINFO bmi;
+	ZeroMemory(&bmi, sizeof(BITMAPINFO));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = bm.bmWidth;
+	bmi.bmiHeader.biHeight = -bm.bmHeight;	// top-down, like the pixel store
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	std::shared_ptr<CPixelImage> pImage(new CPixelImage(bm.bmWidth, bm.bmHeight));
+
+	HDC hDC = CreateCompatibleDC(NULL);
+	GetDIBits(hDC, hBitmap, 0, bm.bmHeight, pImage->Pixels(), &bmi, DIB_RGB_COLORS);
+	DeleteDC(hDC);
+
+	return pImage;
+}
+#endif
+
+// Returns the image with its transparent colour baked into the alpha byte,
+// built once per file and colour and kept in the asset cache.
+static PixelImagePtr AcquireKeyedImage(const char *szImageFile, COLORREF crTransparentColor)
+{
+	char szName[MAX_PATH + 32];
+	sprintf_s(szName, "%s?key=%06X", szImageFile, (unsigned int)crTransparentColor);
+
+	PixelImagePtr pKeyed = g_Assets.Find(szName);
+	if(pKeyed)
+		return pKeyed;
+
+	PixelImagePtr pImage = g_Assets.Acquire(szImageFile);
+	if(!pImage)
+		return pImage;
+
+	// COLORREF is 0x00BBGGRR, the pixel store uses 0x00RRGGBB.
+	unsigned int key = (GetRValue(crTransparentColor) << 16) | (GetGValue(crTransparentColor) << 8) | GetBValue(crTransparentColor);
+	pKeyed = BuildColorKeyImage(*pImage, key);
+	g_Assets.Insert(szName, pKeyed);
+	return pKeyed;
+}
+
+// Same as above, for images that come with a separate mask bitmap.
+static PixelImagePtr AcquireMaskedImage(const char *szImageFile, const char *szMaskFile)
+{
+	char szName[2 * MAX_PATH + 16];
+	sprintf_s(szName, "%s?mask=%s", szImageFile, szMaskFile);
+
+	PixelImagePtr pMasked = g_Assets.Find(szName);
+	if(pMasked)
+		return pMasked;
+
+	PixelImagePtr pImage = g_Assets.Acquire(szImageFile);
+	PixelImagePtr pMask = g_Assets.Acquire(szMaskFile);
+	if(!pImage || !pMask)
+		return PixelImagePtr();
+
+	pMasked = BuildMaskedImage(*pImage, *pMask);
+	if(pMasked)
+		g_Assets.Insert(szName, pMasked);
+	return pMasked;
+}
+
+#ifdef _WIN32
 Sprite::Sprite(int imageID, int maskID)
 {
 	// Load the bitmap resources.
-	mhImage = LoadBitmap(g_hInst, MAKEINTRESOURCE(imageID));
-	mhMask = LoadBitmap(g_hInst, MAKEINTRESOURCE(maskID));
+	HBITMAP hImage = LoadBitmap(g_hInst, MAKEINTRESOURCE(imageID));
+	HBITMAP hMask = LoadBitmap(g_hInst, MAKEINTRESOURCE(maskID));
+
+	// Bake the mask into the image once, the bitmaps are not needed after that.
+	PixelImagePtr pImage = ImageFromBitmap(hImage);
+	PixelImagePtr pMask = ImageFromBitmap(hMask);
+	if(pImage && pMask)
+		mpImage = BuildMaskedImage(*pImage, *pMask);
 
-	// Get the BITMAP structure for each of the bitmaps.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
-	GetObject(mhMask, sizeof(BITMAP), &mMaskBM);
+	DeleteObject(hImage);
+	DeleteObject(hMask);
 
 	// Image and Mask should be the same dimensions.
-	assert(mImageBM.bmWidth == mMaskBM.bmWidth);
-	assert(mImageBM.bmHeight == mMaskBM.bmHeight);	
+	assert(mpImage);
 
 	mcTransparentColor = 0;
-	mhSpriteDC = 0;
+	miSkin = -1;
+	mbUpdated = false;
 }
+#endif
 
 Sprite::Sprite(const char *szImageFile, const char *szMaskFile)
 {
-	mhImage = (HBITMAP)LoadImage(g_hInst, szImageFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-	mhMask = (HBITMAP)LoadImage(g_hInst, szMaskFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-
-	// Get the BITMAP structure for each of the bitmaps.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
-	GetObject(mhMask, sizeof(BITMAP), &mMaskBM);
+	// Decoded once per file, shared by every sprite using it.
+	mpImage = AcquireMaskedImage(szImageFile, szMaskFile);
 
 	// Image and Mask should be the same dimensions.
-	assert(mImageBM.bmWidth == mMaskBM.bmWidth);
-	assert(mImageBM.bmHeight == mMaskBM.bmHeight);
+	assert(mpImage);
 
 	mcTransparentColor = 0;
-	mhSpriteDC = 0;
+	miSkin = -1;
+	mbUpdated = false;
 }
 
 Sprite::Sprite(const char *szImageFile, COLORREF crTransparentColor)
 {
-	mhImage = (HBITMAP)LoadImage(g_hInst, szImageFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
+	// Decoded once per file, shared by every sprite using it.
+	mpImage = AcquireKeyedImage(szImageFile, crTransparentColor);
 
-	mhMask = 0;
-	mhSpriteDC = 0;
 	mcTransparentColor = crTransparentColor;
-
-	// Get the BITMAP structure for the bitmap.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
+	miSkin = -1;
+	mbUpdated = false;
 }
 
 Sprite::~Sprite()
 {
-	// Free the resources we created in the constructor.
-	DeleteObject(mhImage);
-	DeleteObject(mhMask);
-
-	DeleteDC(mhSpriteDC);
+	// Images are released together with the asset cache.
 }
 
 void Sprite::setSprite(const char* szImageFile, COLORREF crTransparentColor)
 {
-	mhImage = (HBITMAP)LoadImage(g_hInst, szImageFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-
-	mhMask = 0;
-	mhSpriteDC = 0;
+	mpImage = AcquireKeyedImage(szImageFile, crTransparentColor);
 	mcTransparentColor = crTransparentColor;
+	miSkin = -1;
+}
 
-	// Get the BITMAP structure for the bitmap.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
-
+int Sprite::addSkin(const char* szImageFile)
+{
+	mSkins.push_back(AcquireKeyedImage(szImageFile, mcTransparentColor));
+	return (int)mSkins.size() - 1;
 }
 
+void Sprite::setSkin(int iSkin)
+{
+	assert(iSkin >= 0 && iSkin < (int)mSkins.size() && "Sprite skin index must be in range!");
 
+	if(iSkin == miSkin || !mSkins[iSkin])
+		return;
 
+	miSkin = iSkin;
+	mpImage = mSkins[iSkin];
+}
 
 void Sprite::update(float dt)
 {
-	// Update the sprites position.
+	// Update the sprites position, remembering the old one to draw
+	// in between the two.
+	mPrevPosition = mPosition;
+	mbUpdated = true;
 
 	mPosition += mVelocity * dt;
 	// Update bounding rectangle/circle
 }
 
-void Sprite::setBackBuffer(const BackBuffer *pBackBuffer)
-{
-	mpBackBuffer = pBackBuffer;
-	if(mpBackBuffer)
-	{
-		DeleteDC(mhSpriteDC);
-		mhSpriteDC = CreateCompatibleDC(mpBackBuffer->getDC());
-	}
-}
-
-void Sprite::draw()
+void Sprite::setPrevPosition(const Vec2& prev)
 {
-	if( mhMask != 0 )
-		drawMask();
-	else
-		drawTransparent();
+	mPrevPosition = prev;
+	mbUpdated = true;
 }
 
-void Sprite::drawMask()
+void Sprite::draw(CWorldSnapshot& frame)
 {
-	if( mpBackBuffer == NULL )
-		return;
-
-	HDC hBackBufferDC = mpBackBuffer->getDC();
-
-	// The position BitBlt wants is not the sprite's center
-	// position; rather, it wants the upper-left position,
-	// so compute that.
-	int w = width();
-	int h = height();
-
-	// Upper-left corner.
-	int x = (int)mPosition.x - (w / 2);
-	int y = (int)mPosition.y - (h / 2);
-
-	// Note: For this masking technique to work, it is assumed
-	// the backbuffer bitmap has been cleared to some
-	// non-zero value.
-	// Select the mask bitmap.
-	HGDIOBJ oldObj = SelectObject(mhSpriteDC, mhMask);
-
-	// Draw the mask to the backbuffer with SRCAND. This
-	// only draws the black pixels in the mask to the backbuffer,
-	// thereby marking the pixels we want to draw the sprite
-	// image onto.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, 0, 0, SRCAND);
-
-	// Now select the image bitmap.
-	SelectObject(mhSpriteDC, mhImage);
-
-	// Draw the image to the backbuffer with SRCPAINT. This
-	// will only draw the image onto the pixels that where previously
-	// marked black by the mask.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, 0, 0, SRCPAINT);
-
-	// Restore the original bitmap object.
-	SelectObject(mhSpriteDC, oldObj);
+	drawFrame(frame, 0, 0, width(), height());
 }
 
-void Sprite::drawTransparent()
+void Sprite::drawFrame(CWorldSnapshot& frame, int srcX, int srcY, int w, int h)
 {
-	if( mpBackBuffer == NULL )
+	if( !mpImage )
 		return;
 
-	HDC hBackBuffer = mpBackBuffer->getDC();
-
-	int w = width();
-	int h = height();
-
-	// Upper-left corner.
-	int x = (int)mPosition.x - (w / 2);
-	int y = (int)mPosition.y - (h / 2);
+	// Sprites that were only ever placed, never updated, stand still.
+	const Vec2& prev = mbUpdated ? mPrevPosition : mPosition;
 
-	COLORREF crOldBack = SetBkColor(hBackBuffer, RGB(255, 255, 255));
-	COLORREF crOldText = SetTextColor(hBackBuffer, RGB(0, 0, 0));
-	HDC dcImage, dcTrans;
-
-	// Create two memory dcs for the image and the mask
-	dcImage=CreateCompatibleDC(hBackBuffer);
-	dcTrans=CreateCompatibleDC(hBackBuffer);
-
-	// Select the image into the appropriate dc
-	SelectObject(dcImage, mhImage);
-
-	// Create the mask bitmap
-	BITMAP bitmap;
-	GetObject(mhImage, sizeof(BITMAP), &bitmap);
-	HBITMAP bitmapTrans = CreateBitmap(bitmap.bmWidth, bitmap.bmHeight, 1, 1, NULL);
-
-	// Select the mask bitmap into the appropriate dc
-	SelectObject(dcTrans, bitmapTrans);
-
-	// Build mask based on transparent color
-	SetBkColor(dcImage, mcTransparentColor);
-	BitBlt(dcTrans, 0, 0, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCCOPY);
-
-	// Do the work - True Mask method - cool if not actual display
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCINVERT);
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcTrans, 0, 0, SRCAND);
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCINVERT);
-
-	// free memory	
-	DeleteDC(dcImage);
-	DeleteDC(dcTrans);
-	DeleteObject(bitmapTrans);
-
-	// Restore settings
-	SetBkColor(hBackBuffer, crOldBack);
-	SetTextColor(hBackBuffer, crOldText);
+	// The snapshot keeps the image pointer; skins and keyed images
+	// stay in the asset cache, so it outlives the frame.
+	frame.AddSprite(mpImage.get(), srcX, srcY, w, h,
+					(float)prev.x, (float)prev.y, (float)mPosition.x, (float)mPosition.y);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -215,43 +210,7 @@ void AnimatedSprite::SetFrame(int iIndex)
 	mptFrameCrop.y = mptFrameStartCrop.y + iIndex/4*miFrameHeight;
 }
 
-void AnimatedSprite::draw()
+void AnimatedSprite::draw(CWorldSnapshot& frame)
 {
-	if( mpBackBuffer == NULL )
-		return;
-
-	// The position BitBlt wants is not the sprite's center
-	// position; rather, it wants the upper-left position,
-	// so compute that.
-	int w = miFrameWidth;
-	int h = miFrameHeight;
-
-	HDC hBackBufferDC = mpBackBuffer->getDC();
-
-	// Upper-left corner.
-	int x = (int)mPosition.x - (w / 2);
-	int y = (int)mPosition.y - (h / 2);
-
-	// Note: For this masking technique to work, it is assumed
-	// the backbuffer bitmap has been cleared to some
-	// non-zero value.
-	// Select the mask bitmap.
-	HGDIOBJ oldObj = SelectObject(mhSpriteDC, mhMask);
-
-	// Draw the mask to the backbuffer with SRCAND. This
-	// only draws the black pixels in the mask to the backbuffer,
-	// thereby marking the pixels we want to draw the sprite
-	// image onto.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, mptFrameCrop.x, mptFrameCrop.y, SRCAND);
-
-	// Now select the image bitmap.
-	SelectObject(mhSpriteDC, mhImage);
-
-	// Draw the image to the backbuffer with SRCPAINT. This
-	// will only draw the image onto the pixels that where previously
-	// marked black by the mask.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, mptFrameCrop.x, mptFrameCrop.y, SRCPAINT);
-
-	// Restore the original bitmap object.
-	SelectObject(mhSpriteDC, oldObj);
-}
\ No newline at end of file
+	drawFrame(frame, mptFrameCrop.x, mptFrameCrop.y, miFrameWidth, miFrameHeight);
+}
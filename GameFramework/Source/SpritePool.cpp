@@ -0,0 +1,75 @@
+// SpritePool.cpp
+// Recycled sprites for short lived entities.
+#include "SpritePool.h"
+
+CSpritePool::CSpritePool(const char* szImageFile, COLORREF crTransparentColor)
+{
+	m_szImageFile = szImageFile;
+	m_crTransparentColor = crTransparentColor;
+	m_HighWater = 0;
+	m_Grows = 0;
+}
+
+CSpritePool::~CSpritePool()
+{
+	// Nobody may still be holding one of these.
+	assert(m_Free.size() == m_Sprites.size() && "CSpritePool destroyed with sprites in use!");
+
+	for(size_t i = 0; i < m_Sprites.size(); i++)
+		delete m_Sprites[i];
+}
+
+void CSpritePool::Reserve(size_t count)
+{
+	if(count <= m_Sprites.size())
+		return;
+
+	// Size the free list for the whole pool now, so Release never allocates.
+	m_Sprites.reserve(count);
+	m_Free.reserve(count);
+
+	while(m_Sprites.size() < count)
+	{
+		// The image comes from the asset cache, only the first one decodes.
+		Sprite* pSprite = new Sprite(m_szImageFile, m_crTransparentColor);
+		m_Sprites.push_back(pSprite);
+		m_Free.push_back(pSprite);
+	}
+}
+
+Sprite* CSpritePool::Acquire()
+{
+	if(m_Free.empty())
+	{
+		Reserve(m_Sprites.empty() ? 16 : m_Sprites.size() * 2);
+		m_Grows++;
+	}
+
+	Sprite* pSprite = m_Free.back();
+	m_Free.pop_back();
+
+	pSprite->mPosition = Vec2(0, 0);
+	pSprite->mVelocity = Vec2(0, 0);
+
+	size_t inUse = m_Sprites.size() - m_Free.size();
+	if(inUse > m_HighWater)
+		m_HighWater = inUse;
+
+	return pSprite;
+}
+
+void CSpritePool::Release(Sprite* pSprite)
+{
+	assert(pSprite && m_Free.size() < m_Sprites.size());
+	m_Free.push_back(pSprite);
+}
+
+CSpritePool::Stats CSpritePool::GetStats() const
+{
+	Stats stats;
+	stats.Capacity = m_Sprites.size();
+	stats.InUse = m_Sprites.size() - m_Free.size();
+	stats.HighWater = m_HighWater;
+	stats.Grows = m_Grows;
+	return stats;
+}
@@ -0,0 +1,249 @@
+// TimingWheel.cpp
+// Hierarchical timing wheel for events in simulation ticks.
+#include "TimingWheel.h"
+#include <assert.h>
+#include <utility>
+
+const uint64_t CTimingWheel::MAX_DELAY;
+
+CTimingWheel::CTimingWheel()
+	: m_FreeList(NO_NODE), m_Now(0), m_nPending(0)
+{
+	CList empty = { NO_NODE, NO_NODE };
+	m_Slots.assign(LEVELS * SLOTS, empty);
+	m_Due = empty;
+}
+
+CTimingWheel::CNode* CTimingWheel::Find(Handle handle)
+{
+	// Low half is the node index plus one, high half its generation.
+	size_t index = (size_t)(handle & 0xFFFFFFFF);
+	if(index == 0 || index > m_Nodes.size())
+		return NULL;
+
+	CNode& node = m_Nodes[index - 1];
+	if(node.Generation != (uint32_t)(handle >> 32) || node.Slot == SLOT_FREE)
+		return NULL;
+
+	return &node;
+}
+
+const CTimingWheel::CNode* CTimingWheel::Find(Handle handle) const
+{
+	return const_cast<CTimingWheel*>(this)->Find(handle);
+}
+
+int CTimingWheel::AllocNode()
+{
+	if(m_FreeList == NO_NODE)
+	{
+		CNode node;
+		node.Generation = 0;
+		node.Slot = SLOT_FREE;
+		node.Prev = node.Next = NO_NODE;
+		m_Nodes.push_back(node);
+		return (int)m_Nodes.size() - 1;
+	}
+
+	int index = m_FreeList;
+	m_FreeList = m_Nodes[index].Next;
+	return index;
+}
+
+void CTimingWheel::FreeNode(int index)
+{
+	CNode& node = m_Nodes[index];
+	node.Work = Callback();
+	node.Generation++;
+	node.Slot = SLOT_FREE;
+	node.Prev = NO_NODE;
+	node.Next = m_FreeList;
+	m_FreeList = index;
+	m_nPending--;
+}
+
+void CTimingWheel::Link(CList& list, int slot, int index)
+{
+	CNode& node = m_Nodes[index];
+	node.Slot = slot;
+	node.Prev = list.Tail;
+	node.Next = NO_NODE;
+
+	if(list.Tail != NO_NODE)
+		m_Nodes[list.Tail].Next = index;
+	else
+		list.Head = index;
+	list.Tail = index;
+}
+
+void CTimingWheel::Unlink(int index)
+{
+	CNode& node = m_Nodes[index];
+	CList& list = node.Slot == SLOT_DUE ? m_Due : m_Slots[node.Slot];
+
+	if(node.Prev != NO_NODE)
+		m_Nodes[node.Prev].Next = node.Next;
+	else
+		list.Head = node.Next;
+
+	if(node.Next != NO_NODE)
+		m_Nodes[node.Next].Prev = node.Prev;
+	else
+		list.Tail = node.Prev;
+
+	node.Prev = node.Next = NO_NODE;
+}
+
+void CTimingWheel::Insert(int index)
+{
+	// The finest level whose wheel still reaches the due tick. Slots are
+	// picked by the due tick's own digits, so a coarse slot comes up
+	// exactly when the time gets to the start of its range.
+	uint64_t due = m_Nodes[index].Due;
+	uint64_t delta = due - m_Now;
+
+	int level = 0;
+	while(level < LEVELS - 1 && delta >= ((uint64_t)1 << ((level + 1) * SLOT_BITS)))
+		level++;
+
+	int slot = level * SLOTS + (int)((due >> (level * SLOT_BITS)) & (SLOTS - 1));
+	Link(m_Slots[slot], slot, index);
+}
+
+CTimingWheel::Handle CTimingWheel::Schedule(uint64_t nDelay, const Callback& work, uint64_t nPeriod)
+{
+	if(nDelay < 1) nDelay = 1;
+	if(nDelay > MAX_DELAY) nDelay = MAX_DELAY;
+	if(nPeriod > MAX_DELAY) nPeriod = MAX_DELAY;
+
+	int index = AllocNode();
+	CNode& node = m_Nodes[index];
+	node.Work = work;
+	node.Due = m_Now + nDelay;
+	node.Period = nPeriod;
+	m_nPending++;
+
+	Insert(index);
+	return ((Handle)node.Generation << 32) | (Handle)(index + 1);
+}
+
+bool CTimingWheel::Cancel(Handle handle)
+{
+	CNode* pNode = Find(handle);
+	if(!pNode)
+		return false;
+
+	// A running callback is freed once it returns; it just must not repeat.
+	if(pNode->Slot == SLOT_RUNNING)
+	{
+		if(!pNode->Period)
+			return false;
+
+		pNode->Period = 0;
+		return true;
+	}
+
+	int index = (int)(pNode - &m_Nodes[0]);
+	Unlink(index);
+	FreeNode(index);
+	return true;
+}
+
+bool CTimingWheel::IsPending(Handle handle) const
+{
+	const CNode* pNode = Find(handle);
+	return pNode && (pNode->Slot != SLOT_RUNNING || pNode->Period);
+}
+
+void CTimingWheel::Cascade(int level)
+{
+	int slot = level * SLOTS + (int)((m_Now >> (level * SLOT_BITS)) & (SLOTS - 1));
+	CList& list = m_Slots[slot];
+
+	// Everything here is now within reach of a finer wheel.
+	int index = list.Head;
+	list.Head = list.Tail = NO_NODE;
+	while(index != NO_NODE)
+	{
+		int next = m_Nodes[index].Next;
+		Insert(index);
+		index = next;
+	}
+}
+
+void CTimingWheel::Advance(uint64_t nTicks)
+{
+	while(nTicks--)
+	{
+		m_Now++;
+
+		// Coarse slots that come up on this tick, coarsest first, so their
+		// events can drop through more than one level.
+		int levels = 0;
+		while(levels < LEVELS - 1 && (m_Now & (((uint64_t)1 << ((levels + 1) * SLOT_BITS)) - 1)) == 0)
+			levels++;
+		for(int level = levels; level > 0; level--)
+			Cascade(level);
+
+		// The level 0 slot holds exactly this tick's events.
+		CList& slot = m_Slots[m_Now & (SLOTS - 1)];
+		if(slot.Head == NO_NODE)
+			continue;
+
+		for(int index = slot.Head; index != NO_NODE; index = m_Nodes[index].Next)
+			m_Nodes[index].Slot = SLOT_DUE;
+		m_Due = slot;
+		slot.Head = slot.Tail = NO_NODE;
+
+		while(m_Due.Head != NO_NODE)
+		{
+			int index = m_Due.Head;
+			Unlink(index);
+			m_Nodes[index].Slot = SLOT_RUNNING;
+
+			// The callback may schedule more events and grow the pool,
+			// so it runs from a local copy of the function.
+			Callback work = std::move(m_Nodes[index].Work);
+			work();
+
+			CNode& node = m_Nodes[index];
+			if(node.Period)
+			{
+				node.Work = std::move(work);
+				node.Due = m_Now + node.Period;
+				Insert(index);
+			}
+			else
+			{
+				FreeNode(index);
+			}
+		}
+	}
+}
+
+void CTimingWheel::Clear()
+{
+	for(size_t i = 0; i < m_Nodes.size(); i++)
+	{
+		if(m_Nodes[i].Slot == SLOT_FREE)
+			continue;
+
+		// A running callback is freed by Advance() once it returns.
+		if(m_Nodes[i].Slot == SLOT_RUNNING)
+		{
+			m_Nodes[i].Period = 0;
+			continue;
+		}
+
+		Unlink((int)i);
+		FreeNode((int)i);
+	}
+}
+
+void CTimingWheel::Reset()
+{
+	assert(m_Due.Head == NO_NODE);
+
+	Clear();
+	m_Now = 0;
+}
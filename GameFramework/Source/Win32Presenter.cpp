@@ -0,0 +1,166 @@
+// Win32Presenter.cpp
+// Presents back buffer frames to a window through GDI.
+#include "Win32Presenter.h"
+
+// Describes a 32 bit top-down frame to GDI.
+static void FillFrameInfo(BITMAPINFO& bmi, int width, int height)
+{
+	ZeroMemory(&bmi, sizeof(BITMAPINFO));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = width;
+	bmi.bmiHeader.biHeight = -height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+}
+
+CWin32Presenter::CWin32Presenter(HWND hWnd, EMode eMode)
+{
+	m_hWnd = hWnd;
+	m_eMode = eMode;
+	m_ClientWidth = 0;
+	m_ClientHeight = 0;
+
+	m_hSectionDC = 0;
+	m_hSection = 0;
+	m_hOldBitmap = 0;
+	m_pSectionPixels = NULL;
+	m_SectionWidth = 0;
+	m_SectionHeight = 0;
+}
+
+CWin32Presenter::~CWin32Presenter()
+{
+	ReleaseSection();
+}
+
+void CWin32Presenter::ReleaseSection()
+{
+	if(m_hSectionDC)
+	{
+		SelectObject(m_hSectionDC, m_hOldBitmap);
+		DeleteDC(m_hSectionDC);
+	}
+	if(m_hSection)
+		DeleteObject(m_hSection);
+
+	m_hSectionDC = 0;
+	m_hSection = 0;
+	m_pSectionPixels = NULL;
+	m_SectionWidth = m_SectionHeight = 0;
+}
+
+bool CWin32Presenter::CreateSection(HDC hWndDC, int width, int height)
+{
+	ReleaseSection();
+
+	BITMAPINFO bmi;
+	FillFrameInfo(bmi, width, height);
+
+	void *pBits = NULL;
+	m_hSection = CreateDIBSection(hWndDC, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
+	if(!m_hSection)
+		return false;
+
+	m_hSectionDC = CreateCompatibleDC(hWndDC);
+	m_hOldBitmap = (HBITMAP)SelectObject(m_hSectionDC, m_hSection);
+	m_pSectionPixels = (unsigned int*)pBits;
+	m_SectionWidth = width;
+	m_SectionHeight = height;
+	return true;
+}
+
+void CWin32Presenter::PresentRect(HDC hWndDC, const CPixelSurface& frame, const CRect& rc)
+{
+	// Scale the rectangle to the client area. Edges are mapped the same way
+	// for every rectangle, so neighbouring ones never leave a seam.
+	int dstLeft = rc.Left * m_ClientWidth / frame.Width;
+	int dstTop = rc.Top * m_ClientHeight / frame.Height;
+	int dstRight = rc.Right * m_ClientWidth / frame.Width;
+	int dstBottom = rc.Bottom * m_ClientHeight / frame.Height;
+	bool bScaled = m_ClientWidth != frame.Width || m_ClientHeight != frame.Height;
+
+	if(m_eMode == PRESENT_DIBSECTION)
+	{
+		for(int y = rc.Top; y < rc.Bottom; y++)
+			memcpy(m_pSectionPixels + y * frame.Width + rc.Left, frame.Row(y) + rc.Left, rc.Width() * sizeof(unsigned int));
+
+		if(!bScaled)
+			BitBlt(hWndDC, rc.Left, rc.Top, rc.Width(), rc.Height(), m_hSectionDC, rc.Left, rc.Top, SRCCOPY);
+		else
+			StretchBlt(hWndDC, dstLeft, dstTop, dstRight - dstLeft, dstBottom - dstTop,
+				m_hSectionDC, rc.Left, rc.Top, rc.Width(), rc.Height(), SRCCOPY);
+	}
+	else
+	{
+		// Describe only the rows of the rectangle, starting at its first
+		// one; GDI reads the source rows of top-down DIBs upside down when
+		// asked for a sub-rectangle, so never ask for one vertically.
+		BITMAPINFO bmi;
+		FillFrameInfo(bmi, frame.Pitch, rc.Height());
+
+		StretchDIBits(hWndDC, dstLeft, dstTop, dstRight - dstLeft, dstBottom - dstTop,
+			rc.Left, 0, rc.Width(), rc.Height(), frame.Row(rc.Top), &bmi, DIB_RGB_COLORS, SRCCOPY);
+	}
+}
+
+void CWin32Presenter::Present(const CPixelSurface& frame, const CDirtyRegion& dirty)
+{
+	m_PixelsPushed = 0;
+
+	RECT rc;
+	GetClientRect(m_hWnd, &rc);
+	int clientWidth = rc.right - rc.left;
+	int clientHeight = rc.bottom - rc.top;
+
+	// Whatever was on screen before a resize is gone.
+	bool bFull = dirty.IsFull() || clientWidth != m_ClientWidth || clientHeight != m_ClientHeight;
+	m_ClientWidth = clientWidth;
+	m_ClientHeight = clientHeight;
+
+	if(!bFull && dirty.IsEmpty())
+	{
+		m_FramesPresented++;
+		return;
+	}
+
+	// Get a handle to the device context associated with
+	// the window.
+	HDC hWndDC = GetDC(m_hWnd);
+
+	if(m_eMode == PRESENT_DIBSECTION)
+	{
+		if(m_SectionWidth != frame.Width || m_SectionHeight != frame.Height)
+		{
+			if(!CreateSection(hWndDC, frame.Width, frame.Height))
+			{
+				ReleaseDC(m_hWnd, hWndDC);
+				return;
+			}
+			bFull = true;
+		}
+
+		// Make sure GDI is done with the section before we write to it.
+		GdiFlush();
+	}
+
+	if(bFull)
+	{
+		PresentRect(hWndDC, frame, CRect(0, 0, frame.Width, frame.Height));
+		m_PixelsPushed = (unsigned long)frame.Width * frame.Height;
+	}
+	else
+	{
+		const std::vector<CRect>& rects = dirty.Rects();
+		for(size_t i = 0; i < rects.size(); i++)
+		{
+			PresentRect(hWndDC, frame, rects[i]);
+			m_PixelsPushed += rects[i].Area();
+		}
+	}
+
+	// Always free window DC when done.
+	ReleaseDC(m_hWnd, hWndDC);
+
+	m_FramesPresented++;
+}
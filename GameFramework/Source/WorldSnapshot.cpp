@@ -0,0 +1,59 @@
+// WorldSnapshot.cpp
+// Everything the renderer needs from one simulation step.
+#include "WorldSnapshot.h"
+
+CWorldSnapshot::CWorldSnapshot()
+{
+	Step = 0;
+	Time = 0.0;
+	StepLength = 0.0f;
+	ScrollOffset = 0.0f;
+	Score = Score2 = 0;
+	Lives = Lives2 = 0;
+	LiveEntities = 0;
+	FreedEntities = 0;
+}
+
+void CWorldSnapshot::Clear()
+{
+	m_Items.clear();
+}
+
+void CWorldSnapshot::AddSprite(const CPixelImage* pImage, int srcX, int srcY, int w, int h,
+							   float prevX, float prevY, float x, float y)
+{
+	CDrawItem item;
+	item.pImage = pImage;
+	item.SrcX = srcX;
+	item.SrcY = srcY;
+	item.Width = w;
+	item.Height = h;
+	item.PrevX = prevX;
+	item.PrevY = prevY;
+	item.X = x;
+	item.Y = y;
+	m_Items.push_back(item);
+}
+
+void CWorldSnapshot::Draw(BackBuffer& target, float fAlpha) const
+{
+	CPixelSurface surface = target.getSurface();
+
+	for(size_t i = 0; i < m_Items.size(); i++)
+	{
+		const CDrawItem& item = m_Items[i];
+
+		// Item positions are sprite centers; the blitter wants
+		// the upper-left corner.
+		float cx = item.PrevX + (item.X - item.PrevX) * fAlpha;
+		float cy = item.PrevY + (item.Y - item.PrevY) * fAlpha;
+		int x = (int)cx - (item.Width / 2);
+		int y = (int)cy - (item.Height / 2);
+
+		// Transparency is baked into the image, see Blitter.h.
+		BlitKeyed(surface, x, y, *item.pImage, item.SrcX, item.SrcY, item.Width, item.Height);
+
+		// Dirty now, erased by the next reset(); the back buffer clips it.
+		target.markDrawn(CRect(x, y, x + item.Width, y + item.Height));
+	}
+}